@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2017 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "Arduino.h"
+#include <stdio.h>
+#include <time.h>
+
+HostSerial Serial;
+
+void HostSerial::print(const char *str)
+{
+    fputs(str, stdout);
+}
+
+void HostSerial::print(char ch)
+{
+    putchar(ch);
+}
+
+void HostSerial::print(int value)
+{
+    printf("%d", value);
+}
+
+void HostSerial::print(unsigned int value)
+{
+    printf("%u", value);
+}
+
+void HostSerial::print(long value)
+{
+    printf("%ld", value);
+}
+
+void HostSerial::print(unsigned long value)
+{
+    printf("%lu", value);
+}
+
+void HostSerial::print(double value, int digits)
+{
+    printf("%.*f", digits, value);
+}
+
+void HostSerial::println()
+{
+    // Arduino's Serial.println() ends lines with CRLF, but plain
+    // newlines are easier to work with on the host.
+    putchar('\n');
+}
+
+unsigned long micros()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long)ts.tv_sec * 1000000UL +
+           (unsigned long)(ts.tv_nsec / 1000);
+}
+
+unsigned long millis()
+{
+    return micros() / 1000UL;
+}
+
+// Runs the sketch's setup() function once.  The example sketches do all
+// of their work in setup() and have an empty loop().
+int main()
+{
+    setup();
+    fflush(stdout);
+    return 0;
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2017 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef ARDUINO_HOST_SHIM_h
+#define ARDUINO_HOST_SHIM_h
+
+// Minimal stand-in for the Arduino core so that the example sketches
+// can be compiled and run on a Linux host with HOST_BUILD defined.
+
+#include <inttypes.h>
+#include <stddef.h>
+
+typedef uint8_t byte;
+
+class HostSerial
+{
+public:
+    void begin(unsigned long baud) { (void)baud; }
+
+    void print(const char *str);
+    void print(char ch);
+    void print(int value);
+    void print(unsigned int value);
+    void print(long value);
+    void print(unsigned long value);
+    void print(double value, int digits = 2);
+
+    void println();
+    void println(const char *str) { print(str); println(); }
+    void println(char ch) { print(ch); println(); }
+    void println(int value) { print(value); println(); }
+    void println(unsigned int value) { print(value); println(); }
+    void println(long value) { print(value); println(); }
+    void println(unsigned long value) { print(value); println(); }
+    void println(double value, int digits = 2)
+        { print(value, digits); println(); }
+};
+
+extern HostSerial Serial;
+
+unsigned long micros();
+unsigned long millis();
+
+void setup();
+void loop();
+
+#endif
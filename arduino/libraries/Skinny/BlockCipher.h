@@ -40,6 +40,9 @@ public:
     virtual void encryptBlock(uint8_t *output, const uint8_t *input) = 0;
     virtual void decryptBlock(uint8_t *output, const uint8_t *input) = 0;
 
+    virtual void encryptBlocks
+        (uint8_t *output, const uint8_t *input, size_t count);
+
     virtual void clear() = 0;
 };
 
@@ -27,7 +27,7 @@
 /**
  * \class CTRCommon CTR.h <CTR.h>
  * \brief Concrete base class to assist with implementing CTR mode for
- * 128-bit block ciphers.
+ * 64-bit and 128-bit block ciphers.
  *
  * Reference: http://en.wikipedia.org/wiki/Block_cipher_mode_of_operation
  *
@@ -41,7 +41,8 @@
  */
 CTRCommon::CTRCommon()
     : blockCipher(0)
-    , posn(16)
+    , posn(0)
+    , avail(0)
     , counterStart(0)
 {
 }
@@ -61,15 +62,16 @@ size_t CTRCommon::keySize() const
 
 size_t CTRCommon::ivSize() const
 {
-    return 16;
+    return blockCipher->blockSize();
 }
 
 /**
  * \brief Sets the counter size for the IV.
  *
  * \param size The number of bytes on the end of the counter block
- * that are relevant when incrementing, between 1 and 16.
- * \return Returns false if the \a size value is not between 1 and 16.
+ * that are relevant when incrementing, between 1 and the block size.
+ * \return Returns false if the \a size value is not between 1 and
+ * the block size of the underlying block cipher.
  *
  * When the counter is incremented during encrypt(), only the last
  * \a size bytes are considered relevant.  This can be useful
@@ -78,23 +80,25 @@ size_t CTRCommon::ivSize() const
  * should explicitly generate a new initial counter value and key long
  * before the \a size bytes overflow and wrap around.
  *
- * By default, the counter size is 16 which is the same as the block size
- * of the underlying block cipher.
+ * By default, the counter size is the same as the block size of the
+ * underlying block cipher; i.e. 16 or 8.
  *
  * \sa setIV()
  */
 bool CTRCommon::setCounterSize(size_t size)
 {
-    if (size < 1 || size > 16)
+    size_t blockSize = blockCipher->blockSize();
+    if (size < 1 || size > blockSize)
         return false;
-    counterStart = 16 - size;
+    counterStart = blockSize - size;
     return true;
 }
 
 bool CTRCommon::setKey(const uint8_t *key, size_t len)
 {
     // Verify the cipher's block size, just in case.
-    if (blockCipher->blockSize() != 16)
+    size_t blockSize = blockCipher->blockSize();
+    if (blockSize != 16 && blockSize != 8)
         return false;
 
     // Set the key on the underlying block cipher.
@@ -105,9 +109,11 @@ bool CTRCommon::setKey(const uint8_t *key, size_t len)
  * \brief Sets the initial counter value to use for future encryption and
  * decryption operations.
  *
- * \param iv The initial counter value which must contain exactly 16 bytes.
- * \param len The length of the counter value, which mut be 16.
- * \return Returns false if \a len is not exactly 16.
+ * \param iv The initial counter value, which must be the same size as
+ * a block of the underlying block cipher.
+ * \param len The length of the counter value, which must be 16 for
+ * 128-bit block ciphers or 8 for 64-bit block ciphers.
+ * \return Returns false if \a len is not the block size.
  *
  * The precise method to generate the initial counter is not defined by
  * this class.  Usually higher level protocols like SSL/TLS and SSH
@@ -118,42 +124,88 @@ bool CTRCommon::setKey(const uint8_t *key, size_t len)
  */
 bool CTRCommon::setIV(const uint8_t *iv, size_t len)
 {
-    if (len != 16)
+    if (len != blockCipher->blockSize() || len > sizeof(counter))
         return false;
     memcpy(counter, iv, len);
-    posn = 16;
+    posn = 0;
+    avail = 0;
     return true;
 }
 
+/**
+ * \brief XOR's a run of keystream bytes with the input to produce
+ * the output.
+ *
+ * \param output The output buffer.
+ * \param input The input buffer, which may be the same as \a output.
+ * \param keystream The keystream bytes.
+ * \param len The number of bytes to process.
+ *
+ * This is shared by CTRCommon and CTRFixed so that there is only one
+ * copy of the code that applies the keystream.
+ */
+void ctr_xor_keystream(uint8_t *output, const uint8_t *input,
+                       const uint8_t *keystream, size_t len)
+{
+#if !defined(__AVR__)
+    // XOR a word at a time.  memcpy() lets the compiler use
+    // unaligned word loads and stores where the CPU supports them.
+    while (len >= 4) {
+        uint32_t in, ks;
+        memcpy(&in, input, 4);
+        memcpy(&ks, keystream, 4);
+        in ^= ks;
+        memcpy(output, &in, 4);
+        input += 4;
+        output += 4;
+        keystream += 4;
+        len -= 4;
+    }
+#endif
+    while (len > 0) {
+        *output++ = *input++ ^ *keystream++;
+        --len;
+    }
+}
+
 void CTRCommon::encrypt(uint8_t *output, const uint8_t *input, size_t len)
 {
     while (len > 0) {
-        if (posn >= 16) {
-            // Generate a new encrypted counter block.
-            blockCipher->encryptBlock(state, counter);
-            posn = 0;
+        if (posn >= avail) {
+            // Fill the keystream buffer with enough counter blocks
+            // for the rest of the request, and encrypt them all at once.
+            uint8_t blockSize = (uint8_t)(blockCipher->blockSize());
+            uint8_t blocks = CTR_KEYSTREAM_SIZE / blockSize;
+            if (len < CTR_KEYSTREAM_SIZE)
+                blocks = (uint8_t)((len + blockSize - 1) / blockSize);
+            for (uint8_t block = 0; block < blocks; ++block) {
+                memcpy(state + block * blockSize, counter, blockSize);
 
-            // Increment the counter, taking care not to reveal
-            // any timing information about the starting value.
-            // We iterate through the entire counter region even
-            // if we could stop earlier because a byte is non-zero.
-            uint16_t temp = 1;
-            uint8_t index = 16;
-            while (index > counterStart) {
-                --index;
-                temp += counter[index];
-                counter[index] = (uint8_t)temp;
-                temp >>= 8;
+                // Increment the counter, taking care not to reveal
+                // any timing information about the starting value.
+                // We iterate through the entire counter region even
+                // if we could stop earlier because a byte is non-zero.
+                uint16_t temp = 1;
+                uint8_t index = blockSize;
+                while (index > counterStart) {
+                    --index;
+                    temp += counter[index];
+                    counter[index] = (uint8_t)temp;
+                    temp >>= 8;
+                }
             }
+            blockCipher->encryptBlocks(state, state, blocks);
+            posn = 0;
+            avail = blocks * blockSize;
         }
-        uint8_t templen = 16 - posn;
+        uint8_t templen = avail - posn;
         if (templen > len)
             templen = len;
+        ctr_xor_keystream(output, input, state + posn, templen);
+        output += templen;
+        input += templen;
+        posn += templen;
         len -= templen;
-        while (templen > 0) {
-            *output++ = *input++ ^ state[posn++];
-            --templen;
-        }
     }
 }
 
@@ -167,7 +219,8 @@ void CTRCommon::clear()
     blockCipher->clear();
     clean(counter);
     clean(state);
-    posn = 16;
+    posn = 0;
+    avail = 0;
 }
 
 /**
@@ -175,16 +228,17 @@ void CTRCommon::clear()
  * \brief Sets the block cipher to use for this CTR object.
  *
  * \param cipher The block cipher to use to implement CTR mode,
- * which must have a block size of 16 bytes (128 bits).
+ * which must have a block size of 16 bytes (128 bits) or 8 bytes (64 bits).
  *
  * \note This class only works with block ciphers whose block size is
- * 16 bytes (128 bits).  If the \a cipher has a different block size,
+ * 16 or 8 bytes.  If the \a cipher has a different block size,
  * then setKey() will fail and return false.
  */
 
 /**
  * \class CTR CTR.h <CTR.h>
- * \brief Implementation of the Counter (CTR) mode for 128-bit block ciphers.
+ * \brief Implementation of the Counter (CTR) mode for 64-bit and 128-bit
+ * block ciphers.
  *
  * Counter mode converts a block cipher into a stream cipher.  The specific
  * block cipher is passed as the template parameter T and the key is
@@ -209,6 +263,16 @@ void CTRCommon::clear()
  * In this example, the last 4 bytes of the IV are incremented to count
  * blocks.  The remaining bytes are left unchanged from block to block.
  *
+ * 64-bit block ciphers such as Skinny64_128 and Mantis8 are also supported,
+ * in which case the IV is 8 bytes in size:
+ *
+ * \code
+ * CTR<Skinny64_128> ctr;
+ * ctr.setKey(key, 16);
+ * ctr.setIV(iv, 8);
+ * ctr.encrypt(output, input, len);
+ * \endcode
+ *
  * Reference: http://en.wikipedia.org/wiki/Block_cipher_mode_of_operation
  *
  * \sa CFB, OFB, CBC
@@ -216,5 +280,35 @@ void CTRCommon::clear()
 
 /**
  * \fn CTR::CTR()
- * \brief Constructs a new CTR object for the 128-bit block cipher T.
+ * \brief Constructs a new CTR object for the block cipher T.
+ */
+
+/**
+ * \class CTRFixed CTR.h <CTR.h>
+ * \brief Implementation of the Counter (CTR) mode with the block cipher,
+ * block size, and counter size fixed at compile time.
+ *
+ * This class produces the same output as CTR with the same key,
+ * initial counter, and counter size.  Because the block cipher type T is
+ * known at compile time, the block function is called directly instead
+ * of through a BlockCipher pointer.  The counter increment loop has
+ * constant bounds so the compiler can unroll it.
+ *
+ * The template parameter BlockSize must match the block size of T and
+ * CounterSize must be between 1 and BlockSize.  Other counter sizes
+ * would reuse the keystream, so they cause a compilation error:
+ *
+ * \code
+ * CTRFixed<Skinny128_256, 16, 4> ctr;
+ * ctr.setKey(key, 32);
+ * ctr.setIV(iv, 16);
+ * ctr.encrypt(output, input, len);
+ * \endcode
+ *
+ * \sa CTR
+ */
+
+/**
+ * \fn CTRFixed::CTRFixed()
+ * \brief Constructs a new CTRFixed object for the block cipher T.
  */
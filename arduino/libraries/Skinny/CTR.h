@@ -25,6 +25,19 @@
 
 #include "Cipher.h"
 #include "BlockCipher.h"
+#include "Crypto.h"
+#include <string.h>
+
+// Number of bytes of keystream to generate at once.  Larger sizes let
+// the block cipher process several counter blocks per call.
+#if defined(__AVR__)
+#define CTR_KEYSTREAM_SIZE 16
+#else
+#define CTR_KEYSTREAM_SIZE 64
+#endif
+
+void ctr_xor_keystream(uint8_t *output, const uint8_t *input,
+                       const uint8_t *keystream, size_t len);
 
 class CTRCommon : public Cipher
 {
@@ -51,8 +64,9 @@ protected:
 private:
     BlockCipher *blockCipher;
     uint8_t counter[16];
-    uint8_t state[16];
+    uint8_t state[CTR_KEYSTREAM_SIZE];
     uint8_t posn;
+    uint8_t avail;
     uint8_t counterStart;
 };
 
@@ -66,4 +80,89 @@ private:
     T cipher;
 };
 
+template <typename T, size_t BlockSize = 16, size_t CounterSize = BlockSize>
+class CTRFixed : public Cipher
+{
+    // A zero-sized counter never changes and a counter that is larger
+    // than the block underflows the increment loop.  Either would reuse
+    // the keystream, so reject them at compile time.  This uses a
+    // negative-sized array as some AVR toolchains lack static_assert.
+    typedef char CounterSizeCheck
+        [(CounterSize >= 1 && CounterSize <= BlockSize) ? 1 : -1];
+
+public:
+    CTRFixed() : posn(BlockSize) {}
+    virtual ~CTRFixed() { clean(counter); clean(state); }
+
+    size_t keySize() const { return cipher.T::keySize(); }
+    size_t ivSize() const { return BlockSize; }
+
+    bool setKey(const uint8_t *key, size_t len)
+    {
+        // Verify the cipher's block size, just in case.
+        if (cipher.T::blockSize() != BlockSize)
+            return false;
+        return cipher.T::setKey(key, len);
+    }
+
+    bool setIV(const uint8_t *iv, size_t len)
+    {
+        if (len != BlockSize)
+            return false;
+        memcpy(counter, iv, len);
+        posn = BlockSize;
+        return true;
+    }
+
+    void encrypt(uint8_t *output, const uint8_t *input, size_t len)
+    {
+        while (len > 0) {
+            if (posn >= BlockSize) {
+                // Generate a new encrypted counter block with a direct
+                // call to the cipher, bypassing the vtable.
+                cipher.T::encryptBlock(state, counter);
+                posn = 0;
+
+                // Increment the counter in constant time.  The loop
+                // bounds are constants so the compiler can unroll it.
+                uint16_t temp = 1;
+                for (size_t index = BlockSize;
+                        index > (BlockSize - CounterSize); ) {
+                    --index;
+                    temp += counter[index];
+                    counter[index] = (uint8_t)temp;
+                    temp >>= 8;
+                }
+            }
+            size_t templen = BlockSize - posn;
+            if (templen > len)
+                templen = len;
+            ctr_xor_keystream(output, input, state + posn, templen);
+            output += templen;
+            input += templen;
+            posn += templen;
+            len -= templen;
+        }
+    }
+
+    void decrypt(uint8_t *output, const uint8_t *input, size_t len)
+    {
+        encrypt(output, input, len);
+    }
+
+    void clear()
+    {
+        cipher.T::clear();
+        clean(counter);
+        clean(state);
+        posn = BlockSize;
+    }
+
+private:
+    T cipher;
+    uint8_t counter[BlockSize];
+    uint8_t state[BlockSize];
+    uint8_t posn;
+};
+
 #endif
@@ -1206,6 +1206,19 @@ void Mantis8::decryptBlock(uint8_t *output, const uint8_t *input)
     encryptBlock(output, input);
 }
 
+void Mantis8::encryptBlocks
+    (uint8_t *output, const uint8_t *input, size_t count)
+{
+    // Call encryptBlock() directly rather than through the vtable
+    // so that the compiler can inline the block function.
+    while (count > 0) {
+        Mantis8::encryptBlock(output, input);
+        output += 8;
+        input += 8;
+        --count;
+    }
+}
+
 void Mantis8::clear()
 {
     clean(st);
@@ -92,6 +92,53 @@
  * \sa Skinny128_384, Skinny128_Tweaked, Skinny128_256_Tweaked
  */
 
+/**
+ * \class Skinny128_Small Skinny128.h <Skinny128.h>
+ * \brief Abstract base class for SKINNY block ciphers with 128-bit blocks
+ * that compute the key schedule on the fly.
+ *
+ * The Skinny128 classes expand the full key schedule when the key is set,
+ * which takes 320 to 448 bytes of RAM per object.  This class stores
+ * only the 16 to 48 bytes of tweakey state and expands the round keys
+ * as each block is encrypted.  Decryption runs the tweakey state forward
+ * to the last round and then rewinds it one round at a time.
+ *
+ * The trade-off is speed: encryption does a little more work per round,
+ * and decryption also pays for running the tweakey state forward.  This is
+ * intended for memory-constrained devices that mostly need encryption,
+ * such as CTR mode on an 8-bit AVR.
+ *
+ * The caller should instantiate Skinny128_128_Small, Skinny128_256_Small,
+ * or Skinny128_384_Small to create a block cipher with a specific key size.
+ *
+ * \sa Skinny128, Skinny128_128_Small, Skinny128_256_Small,
+ * Skinny128_384_Small
+ */
+
+/**
+ * \class Skinny128_128_Small Skinny128.h <Skinny128.h>
+ * \brief SKINNY block cipher with a 128-bit block and a 128-bit key,
+ * using an on-the-fly key schedule.
+ *
+ * \sa Skinny128_128, Skinny128_Small
+ */
+
+/**
+ * \class Skinny128_256_Small Skinny128.h <Skinny128.h>
+ * \brief SKINNY block cipher with a 128-bit block and a 256-bit key,
+ * using an on-the-fly key schedule.
+ *
+ * \sa Skinny128_256, Skinny128_Small
+ */
+
+/**
+ * \class Skinny128_384_Small Skinny128.h <Skinny128.h>
+ * \brief SKINNY block cipher with a 128-bit block and a 384-bit key,
+ * using an on-the-fly key schedule.
+ *
+ * \sa Skinny128_384, Skinny128_Small
+ */
+
 #if defined(__AVR__)
 #define USE_AVR_INLINE_ASM 1
 #endif
@@ -229,8 +276,11 @@ static uint8_t const sbox_inv[256] PROGMEM ALIGN256 = {
     "mov " row2 ",__tmp_reg__\n" \
     "eor " row1 "," row2 "\n"
 
-#else // !USE_AVR_INLINE_ASM
+#endif // USE_AVR_INLINE_ASM
 
+// The bit-sliced S-box is used by the main classes on non-AVR platforms
+// and by the Skinny128_Small classes on all platforms, as the point of
+// the latter is to avoid spending RAM or flash on large tables.
 inline uint32_t skinny128_sbox(uint32_t x)
 {
     /* Original version from the specification is equivalent to:
@@ -338,8 +388,6 @@ inline uint32_t skinny128_inv_sbox(uint32_t x)
            ((x & 0x10101010U) >> 1);
 }
 
-#endif // !USE_AVR_INLINE_ASM
-
 void Skinny128::encryptBlock(uint8_t *output, const uint8_t *input)
 {
 #if USE_AVR_INLINE_ASM
@@ -714,6 +762,19 @@ void Skinny128::decryptBlock(uint8_t *output, const uint8_t *input)
 #endif // !USE_AVR_INLINE_ASM
 }
 
+void Skinny128::encryptBlocks
+    (uint8_t *output, const uint8_t *input, size_t count)
+{
+    // Call encryptBlock() directly rather than through the vtable
+    // so that the compiler can inline the block function.
+    while (count > 0) {
+        Skinny128::encryptBlock(output, input);
+        output += 16;
+        input += 16;
+        --count;
+    }
+}
+
 void Skinny128::clear()
 {
     clean(s, r * 2 * sizeof(uint32_t));
@@ -742,7 +803,7 @@ void Skinny128::clear()
     "mov r10,r16\n"             /* TK[2] = TK[8] */ \
     "mov r16,__tmp_reg__\n"     /* TK[8] = tmp (original TK[0]) */
 
-#else // !USE_AVR_INLINE_ASM
+#endif // USE_AVR_INLINE_ASM
 
 // Permutes the bytes within a TKn value while expanding the key schedule.
 // PT = [9, 15, 8, 13, 10, 14, 12, 11, 0, 1, 2, 3, 4, 5, 6, 7]
@@ -762,8 +823,6 @@ void Skinny128::clear()
                 ( row3        & 0x00FF0000U); \
     } while (0)
 
-#endif // !USE_AVR_INLINE_ASM
-
 /**
  * \brief Clears the key schedule and sets it to the schedule for TK1.
  *
@@ -992,7 +1051,7 @@ void Skinny128::xorTK1(const uint8_t *key)
     "bld r24,7\n" \
     "eor " reg ",r24\n"
 
-#else // !USE_AVR_INLINE_ASM
+#endif // USE_AVR_INLINE_ASM
 
 inline uint32_t skinny128_LFSR2(uint32_t x)
 {
@@ -1004,8 +1063,6 @@ inline uint32_t skinny128_LFSR3(uint32_t x)
     return ((x >> 1) & 0x7F7F7F7FU) ^ (((x << 7) ^ (x << 1)) & 0x80808080U);
 }
 
-#endif // !USE_AVR_INLINE_ASM
-
 /**
  * \brief XOR's the key schedule with the schedule for TK2.
  *
@@ -1465,3 +1522,331 @@ bool Skinny128_384_Tweaked::setKey(const uint8_t *key, size_t len)
     setTK3(key + 16);
     return true;
 }
+
+// Inverse of skinny128_permute_tk().
+#define skinny128_inv_permute_tk(tk) \
+    do { \
+        uint32_t row0 = tk[0]; \
+        uint32_t row1 = tk[1]; \
+        uint32_t row3; \
+        tk[0] = tk[2]; \
+        tk[1] = tk[3]; \
+        tk[2] = ((row0 >> 16) & 0x000000FFU) | \
+                ((row0 <<  8) & 0x0000FF00U) | \
+                ((row1 << 16) & 0x00FF0000U) | \
+                ( row1        & 0xFF000000U); \
+        row3  = ((row1 >>  8) & 0x000000FFU) | \
+                ( row0        & 0xFF00FF00U) | \
+                ( row1        & 0x00FF0000U); \
+        tk[3] = (row3 << 16) | (row3 >> 16); \
+    } while (0)
+
+// Advances the tweakey state for "count" TK's to the next round.
+static void skinny128_small_step(uint32_t *tk, uint8_t count)
+{
+    skinny128_permute_tk(tk);
+    if (count >= 2) {
+        skinny128_permute_tk((tk + 4));
+        tk[4] = skinny128_LFSR2(tk[4]);
+        tk[5] = skinny128_LFSR2(tk[5]);
+    }
+    if (count >= 3) {
+        skinny128_permute_tk((tk + 8));
+        tk[8] = skinny128_LFSR3(tk[8]);
+        tk[9] = skinny128_LFSR3(tk[9]);
+    }
+}
+
+// Rewinds the tweakey state for "count" TK's to the previous round.
+// LFSR2 and LFSR3 are the inverses of each other.
+static void skinny128_small_unstep(uint32_t *tk, uint8_t count)
+{
+    skinny128_inv_permute_tk(tk);
+    if (count >= 2) {
+        tk[4] = skinny128_LFSR3(tk[4]);
+        tk[5] = skinny128_LFSR3(tk[5]);
+        skinny128_inv_permute_tk((tk + 4));
+    }
+    if (count >= 3) {
+        tk[8] = skinny128_LFSR2(tk[8]);
+        tk[9] = skinny128_LFSR2(tk[9]);
+        skinny128_inv_permute_tk((tk + 8));
+    }
+}
+
+/**
+ * \brief Constructs a Skinny-128 block cipher object with an on-the-fly
+ * key schedule.
+ *
+ * \param tk Points to the tweakey state in the subclass.
+ * \param count The number of TK's in the tweakey state; between 1 and 3.
+ * \param rounds The number of rounds to perform during encryption/decryption.
+ */
+Skinny128_Small::Skinny128_Small(uint32_t *tk, uint8_t count, uint8_t rounds)
+    : t(tk), n(count), r(rounds)
+{
+}
+
+/**
+ * \brief Destroys this Skinny-128 block cipher object after clearing
+ * sensitive information.
+ */
+Skinny128_Small::~Skinny128_Small()
+{
+}
+
+/**
+ * \brief Size of a Skinny-128 block in bytes.
+ * \return Always returns 16.
+ */
+size_t Skinny128_Small::blockSize() const
+{
+    return 16;
+}
+
+void Skinny128_Small::encryptBlock(uint8_t *output, const uint8_t *input)
+{
+    uint32_t state[4];
+    uint32_t tk[12];
+    uint32_t temp;
+    uint8_t rc = 0;
+
+    // Unpack the input block and copy the tweakey state, which
+    // we will be modifying as we go.
+    memcpy(state, input, sizeof(state));
+    memcpy(tk, t, n * 4 * sizeof(uint32_t));
+
+    // Perform all encryption rounds.
+    for (uint8_t index = r; index > 0; --index) {
+        // Apply the S-box to all bytes in the state.
+        state[0] = skinny128_sbox(state[0]);
+        state[1] = skinny128_sbox(state[1]);
+        state[2] = skinny128_sbox(state[2]);
+        state[3] = skinny128_sbox(state[3]);
+
+        // Compute the subkey and round constant for this round
+        // and apply them to the state.
+        rc = (rc << 1) ^ ((rc >> 5) & 0x01) ^ ((rc >> 4) & 0x01) ^ 0x01;
+        rc &= 0x3F;
+        state[0] ^= tk[0] ^ (rc & 0x0F);
+        state[1] ^= tk[1] ^ (rc >> 4);
+        if (n >= 2) {
+            state[0] ^= tk[4];
+            state[1] ^= tk[5];
+        }
+        if (n >= 3) {
+            state[0] ^= tk[8];
+            state[1] ^= tk[9];
+        }
+        state[2] ^= 0x02;
+
+        // Shift the cells in the rows right.
+        state[1] = leftRotate8(state[1]);
+        state[2] = leftRotate16(state[2]);
+        state[3] = leftRotate24(state[3]);
+
+        // Mix the columns.
+        state[1] ^= state[2];
+        state[2] ^= state[0];
+        temp = state[3] ^ state[2];
+        state[3] = state[2];
+        state[2] = state[1];
+        state[1] = state[0];
+        state[0] = temp;
+
+        // Advance the tweakey state to the next round.
+        skinny128_small_step(tk, n);
+    }
+
+    // Pack the result into the output buffer and clean up.
+    memcpy(output, state, sizeof(state));
+    clean(tk);
+}
+
+void Skinny128_Small::decryptBlock(uint8_t *output, const uint8_t *input)
+{
+    uint32_t state[4];
+    uint32_t tk[12];
+    uint32_t temp;
+    uint8_t rc = 0;
+    uint8_t index;
+
+    // Unpack the input block and run the tweakey state and the
+    // round constant forward to the end of the last round.
+    memcpy(state, input, sizeof(state));
+    memcpy(tk, t, n * 4 * sizeof(uint32_t));
+    for (index = r; index > 0; --index) {
+        rc = (rc << 1) ^ ((rc >> 5) & 0x01) ^ ((rc >> 4) & 0x01) ^ 0x01;
+        rc &= 0x3F;
+        skinny128_small_step(tk, n);
+    }
+
+    // Perform all decryption rounds.
+    for (index = r; index > 0; --index) {
+        // Rewind the tweakey state to the current round.
+        skinny128_small_unstep(tk, n);
+
+        // Inverse mix of the columns.
+        temp = state[3];
+        state[3] = state[0];
+        state[0] = state[1];
+        state[1] = state[2];
+        state[3] ^= temp;
+        state[2] = temp ^ state[0];
+        state[1] ^= state[2];
+
+        // Inverse shift of the rows.
+        state[1] = leftRotate24(state[1]);
+        state[2] = leftRotate16(state[2]);
+        state[3] = leftRotate8(state[3]);
+
+        // Apply the subkey and round constant for this round, and
+        // then rewind the round constant to the previous round.
+        state[0] ^= tk[0] ^ (rc & 0x0F);
+        state[1] ^= tk[1] ^ (rc >> 4);
+        if (n >= 2) {
+            state[0] ^= tk[4];
+            state[1] ^= tk[5];
+        }
+        if (n >= 3) {
+            state[0] ^= tk[8];
+            state[1] ^= tk[9];
+        }
+        state[2] ^= 0x02;
+        rc = (rc >> 1) ^ (((rc >> 5) ^ rc ^ 0x01) << 5);
+        rc &= 0x3F;
+
+        // Apply the inverse of the S-box to all bytes in the state.
+        state[0] = skinny128_inv_sbox(state[0]);
+        state[1] = skinny128_inv_sbox(state[1]);
+        state[2] = skinny128_inv_sbox(state[2]);
+        state[3] = skinny128_inv_sbox(state[3]);
+    }
+
+    // Pack the result into the output buffer and clean up.
+    memcpy(output, state, sizeof(state));
+    clean(tk);
+}
+
+void Skinny128_Small::encryptBlocks
+    (uint8_t *output, const uint8_t *input, size_t count)
+{
+    // Call encryptBlock() directly rather than through the vtable
+    // so that the compiler can inline the block function.
+    while (count > 0) {
+        Skinny128_Small::encryptBlock(output, input);
+        output += 16;
+        input += 16;
+        --count;
+    }
+}
+
+void Skinny128_Small::clear()
+{
+    clean(t, n * 4 * sizeof(uint32_t));
+}
+
+/**
+ * \brief Constructs a Skinny-128 block cipher with a 128-bit key and
+ * an on-the-fly key schedule.
+ */
+Skinny128_128_Small::Skinny128_128_Small()
+    : Skinny128_Small(tk, 1, 40)
+{
+}
+
+/**
+ * \brief Destroys this Skinny-128 block cipher object after clearing
+ * sensitive information.
+ */
+Skinny128_128_Small::~Skinny128_128_Small()
+{
+    clean(tk);
+}
+
+/**
+ * \brief Size of a Skinny128_128_Small key in bytes.
+ * \return Always returns 16.
+ */
+size_t Skinny128_128_Small::keySize() const
+{
+    return 16;
+}
+
+bool Skinny128_128_Small::setKey(const uint8_t *key, size_t len)
+{
+    if (len != 16)
+        return false;
+    memcpy(tk, key, 16);
+    return true;
+}
+
+/**
+ * \brief Constructs a Skinny-128 block cipher with a 256-bit key and
+ * an on-the-fly key schedule.
+ */
+Skinny128_256_Small::Skinny128_256_Small()
+    : Skinny128_Small(tk, 2, 48)
+{
+}
+
+/**
+ * \brief Destroys this Skinny-128 block cipher object after clearing
+ * sensitive information.
+ */
+Skinny128_256_Small::~Skinny128_256_Small()
+{
+    clean(tk);
+}
+
+/**
+ * \brief Size of a Skinny128_256_Small key in bytes.
+ * \return Always returns 32.
+ */
+size_t Skinny128_256_Small::keySize() const
+{
+    return 32;
+}
+
+bool Skinny128_256_Small::setKey(const uint8_t *key, size_t len)
+{
+    if (len != 32)
+        return false;
+    memcpy(tk, key, 32);
+    return true;
+}
+
+/**
+ * \brief Constructs a Skinny-128 block cipher with a 384-bit key and
+ * an on-the-fly key schedule.
+ */
+Skinny128_384_Small::Skinny128_384_Small()
+    : Skinny128_Small(tk, 3, 56)
+{
+}
+
+/**
+ * \brief Destroys this Skinny-128 block cipher object after clearing
+ * sensitive information.
+ */
+Skinny128_384_Small::~Skinny128_384_Small()
+{
+    clean(tk);
+}
+
+/**
+ * \brief Size of a Skinny128_384_Small key in bytes.
+ * \return Always returns 48.
+ */
+size_t Skinny128_384_Small::keySize() const
+{
+    return 48;
+}
+
+bool Skinny128_384_Small::setKey(const uint8_t *key, size_t len)
+{
+    if (len != 48)
+        return false;
+    memcpy(tk, key, 48);
+    return true;
+}
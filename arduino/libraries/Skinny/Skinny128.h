@@ -35,6 +35,8 @@ public:
     void encryptBlock(uint8_t *output, const uint8_t *input);
     void decryptBlock(uint8_t *output, const uint8_t *input);
 
+    void encryptBlocks(uint8_t *output, const uint8_t *input, size_t count);
+
     void clear();
 
 protected:
@@ -138,4 +140,69 @@ private:
     uint32_t sched[56 * 2];
 };
 
+class Skinny128_Small : public BlockCipher
+{
+public:
+    virtual ~Skinny128_Small();
+
+    size_t blockSize() const;
+
+    void encryptBlock(uint8_t *output, const uint8_t *input);
+    void decryptBlock(uint8_t *output, const uint8_t *input);
+
+    void encryptBlocks(uint8_t *output, const uint8_t *input, size_t count);
+
+    void clear();
+
+protected:
+    Skinny128_Small(uint32_t *tk, uint8_t count, uint8_t rounds);
+
+private:
+    uint32_t *t;
+    uint8_t n;
+    uint8_t r;
+};
+
+class Skinny128_128_Small : public Skinny128_Small
+{
+public:
+    Skinny128_128_Small();
+    virtual ~Skinny128_128_Small();
+
+    size_t keySize() const;
+
+    bool setKey(const uint8_t *key, size_t len);
+
+private:
+    uint32_t tk[4];
+};
+
+class Skinny128_256_Small : public Skinny128_Small
+{
+public:
+    Skinny128_256_Small();
+    virtual ~Skinny128_256_Small();
+
+    size_t keySize() const;
+
+    bool setKey(const uint8_t *key, size_t len);
+
+private:
+    uint32_t tk[8];
+};
+
+class Skinny128_384_Small : public Skinny128_Small
+{
+public:
+    Skinny128_384_Small();
+    virtual ~Skinny128_384_Small();
+
+    size_t keySize() const;
+
+    bool setKey(const uint8_t *key, size_t len);
+
+private:
+    uint32_t tk[12];
+};
+
 #endif
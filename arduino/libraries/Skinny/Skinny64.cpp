@@ -636,6 +636,19 @@ void Skinny64::decryptBlock(uint8_t *output, const uint8_t *input)
 #endif // !USE_AVR_INLINE_ASM
 }
 
+void Skinny64::encryptBlocks
+    (uint8_t *output, const uint8_t *input, size_t count)
+{
+    // Call encryptBlock() directly rather than through the vtable
+    // so that the compiler can inline the block function.
+    while (count > 0) {
+        Skinny64::encryptBlock(output, input);
+        output += 8;
+        input += 8;
+        --count;
+    }
+}
+
 void Skinny64::clear()
 {
     clean(s, r * sizeof(uint32_t));
@@ -0,0 +1,257 @@
+/*
+ * Copyright (C) 2017 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+This example runs tests on the CTR and CTRFixed implementations to
+verify correct behaviour with 128-bit and 64-bit block ciphers.
+*/
+
+#include <Skinny.h>
+#include <CTR.h>
+#include <string.h>
+
+#define CTR_TEST_SIZE 100
+
+struct CTRTestVector
+{
+    const char *name;
+    byte key[32];
+    size_t keySize;
+    byte iv[16];
+    size_t ivSize;
+    byte ciphertext[CTR_TEST_SIZE];
+};
+
+// The ciphertexts were generated with skinny128_ctr_encrypt(),
+// skinny64_ctr_encrypt() and mantis_ctr_encrypt() from the C library.
+// The plaintext is the bytes 0, 7, 14, 21, ... and the counter starts
+// just before a carry out of the last byte.
+static CTRTestVector const testVectorCTRSkinny128_256 = {
+    "Skinny128_256",
+    {0x01, 0x0c, 0x17, 0x22, 0x2d, 0x38, 0x43, 0x4e,
+     0x59, 0x64, 0x6f, 0x7a, 0x85, 0x90, 0x9b, 0xa6,
+     0xb1, 0xbc, 0xc7, 0xd2, 0xdd, 0xe8, 0xf3, 0xfe,
+     0x09, 0x14, 0x1f, 0x2a, 0x35, 0x40, 0x4b, 0x56},
+    32,
+    {0xa0, 0xa1, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
+     0xa8, 0xa9, 0xaa, 0xab, 0xac, 0xad, 0xff, 0xfe},
+    16,
+    {0xd4, 0x2d, 0x5b, 0xf9, 0xcc, 0xa4, 0xa1, 0x84,
+     0x87, 0x92, 0x00, 0x04, 0xcf, 0x08, 0xf2, 0x7c,
+     0x02, 0xb2, 0xd3, 0x71, 0xaa, 0x0c, 0xa9, 0xcb,
+     0x63, 0x9e, 0xbc, 0x97, 0xc5, 0x99, 0x5c, 0xe9,
+     0xab, 0x86, 0x93, 0x9b, 0xe2, 0x7d, 0xe7, 0xd2,
+     0x1e, 0xe5, 0xe6, 0x31, 0x84, 0x5f, 0x1d, 0xf5,
+     0x44, 0xd9, 0x5f, 0x28, 0x3a, 0x0b, 0xf3, 0xb7,
+     0xa8, 0x84, 0x2a, 0x56, 0x20, 0x5c, 0xac, 0x44,
+     0xf8, 0x3f, 0xe6, 0x60, 0x1f, 0x1d, 0x6b, 0x0c,
+     0xd1, 0xc6, 0xfe, 0xc2, 0xfc, 0xda, 0xab, 0x63,
+     0x2b, 0x43, 0x43, 0x3d, 0x73, 0x8f, 0xb5, 0x7d,
+     0xaa, 0x73, 0xe8, 0x55, 0xcf, 0xb4, 0x55, 0xa6,
+     0xb5, 0x53, 0x5e, 0xa2}
+};
+static CTRTestVector const testVectorCTRSkinny64_128 = {
+    "Skinny64_128",
+    {0x01, 0x0c, 0x17, 0x22, 0x2d, 0x38, 0x43, 0x4e,
+     0x59, 0x64, 0x6f, 0x7a, 0x85, 0x90, 0x9b, 0xa6},
+    16,
+    {0xa8, 0xa9, 0xaa, 0xab, 0xac, 0xad, 0xff, 0xfe},
+    8,
+    {0xc5, 0x3c, 0x25, 0xfb, 0x30, 0x33, 0xe2, 0xa2,
+     0x58, 0x89, 0x2e, 0xb7, 0x4e, 0xf1, 0x99, 0xcb,
+     0x20, 0x9f, 0x3e, 0x7a, 0x2f, 0xc4, 0x96, 0x2b,
+     0x6f, 0x9d, 0xd1, 0x4f, 0x9d, 0x81, 0xfe, 0xf3,
+     0x18, 0x9e, 0x65, 0xe5, 0x65, 0x12, 0xb7, 0x92,
+     0xfb, 0x0d, 0xa0, 0x26, 0x01, 0xbd, 0xa9, 0xda,
+     0x9f, 0x9e, 0x6a, 0xa1, 0x96, 0x29, 0xbc, 0x11,
+     0xd5, 0x07, 0xfa, 0x7d, 0x7f, 0xdd, 0x89, 0x08,
+     0xcb, 0x12, 0xcf, 0x33, 0x63, 0xef, 0x7f, 0x43,
+     0x77, 0xb8, 0xe6, 0x2c, 0xb7, 0x82, 0x20, 0xb1,
+     0x48, 0x5a, 0x68, 0x0b, 0x67, 0x73, 0x02, 0x9f,
+     0xf0, 0x8b, 0xd3, 0x61, 0x37, 0xfa, 0xc6, 0x6c,
+     0xe3, 0x8c, 0x97, 0x07}
+};
+static CTRTestVector const testVectorCTRMantis8 = {
+    "Mantis8",
+    {0x01, 0x0c, 0x17, 0x22, 0x2d, 0x38, 0x43, 0x4e,
+     0x59, 0x64, 0x6f, 0x7a, 0x85, 0x90, 0x9b, 0xa6},
+    16,
+    {0xa8, 0xa9, 0xaa, 0xab, 0xac, 0xad, 0xff, 0xfe},
+    8,
+    {0xb3, 0x11, 0x2a, 0x96, 0x81, 0x2f, 0x32, 0x1c,
+     0xf7, 0x0c, 0x22, 0xe7, 0x54, 0xfd, 0x4f, 0xfb,
+     0x98, 0x1e, 0x58, 0xaa, 0x48, 0x63, 0xdf, 0xce,
+     0x06, 0xc7, 0xb0, 0xf0, 0x66, 0x73, 0xd6, 0xd8,
+     0x6f, 0xf7, 0xb2, 0xf9, 0xe9, 0xac, 0x72, 0x71,
+     0x47, 0xf3, 0x67, 0x9e, 0xc5, 0xc7, 0x41, 0x78,
+     0xa7, 0x02, 0x53, 0x7b, 0x45, 0x09, 0xc8, 0xc3,
+     0x6a, 0x97, 0x1c, 0x86, 0x53, 0x6d, 0xa2, 0xcd,
+     0x98, 0x48, 0xfe, 0x69, 0x2d, 0x6a, 0x8f, 0x16,
+     0xe9, 0x4d, 0xe1, 0x6e, 0xfd, 0xa5, 0xf3, 0xcf,
+     0xcf, 0x99, 0xf3, 0x37, 0x47, 0xdf, 0xa9, 0x44,
+     0x73, 0x76, 0x6b, 0x75, 0x8d, 0xa0, 0xed, 0xe1,
+     0x08, 0xc5, 0xda, 0x08}
+};
+
+CTR<Skinny128_256> ctrSkinny128_256;
+CTR<Skinny64_128> ctrSkinny64_128;
+CTR<Mantis8> ctrMantis8;
+CTRFixed<Skinny128_256> ctrFixedSkinny128_256;
+CTRFixed<Skinny64_128, 8> ctrFixedSkinny64_128;
+CTRFixed<Mantis8, 8> ctrFixedMantis8;
+
+CTRFixed<Skinny128_256, 16, 2> ctrFixedSkinny128_256_2;
+CTRFixed<Skinny64_128, 8, 2> ctrFixedSkinny64_128_2;
+CTRFixed<Mantis8, 8, 2> ctrFixedMantis8_2;
+
+byte plaintext[CTR_TEST_SIZE];
+byte buffer[CTR_TEST_SIZE + 3];
+byte expected[CTR_TEST_SIZE];
+
+// Request sizes to split the input into.  The sizes are smaller than,
+// equal to, and larger than the block and keystream buffer sizes.
+static size_t const splits[] = {1, 3, 7, 8, 13, 16, 17, 31, 64, 65, 100};
+
+// Encrypts the plaintext in requests of "split" bytes into "output".
+void encryptSplit(Cipher *cipher, const struct CTRTestVector *test,
+                  byte *output, const byte *input, size_t split)
+{
+    size_t posn, len;
+    cipher->setIV(test->iv, test->ivSize);
+    for (posn = 0; posn < CTR_TEST_SIZE; posn += len) {
+        len = CTR_TEST_SIZE - posn;
+        if (len > split)
+            len = split;
+        cipher->encrypt(output + posn, input + posn, len);
+    }
+}
+
+void testCTR(Cipher *cipher, const struct CTRTestVector *test,
+             const char *mode)
+{
+    size_t index, offset;
+    bool ok = true;
+
+    Serial.print(mode);
+    Serial.print("<");
+    Serial.print(test->name);
+    Serial.print("> ... ");
+    cipher->setKey(test->key, test->keySize);
+
+    // Encrypt and decrypt in place with each of the split sizes, and
+    // with the data at byte offsets that are not word-aligned.
+    for (index = 0; index < sizeof(splits) / sizeof(splits[0]); ++index) {
+        for (offset = 0; offset < 4; ++offset) {
+            memcpy(buffer + offset, plaintext, CTR_TEST_SIZE);
+            encryptSplit(cipher, test, buffer + offset, buffer + offset,
+                         splits[index]);
+            if (memcmp(buffer + offset, test->ciphertext, CTR_TEST_SIZE) != 0)
+                ok = false;
+            cipher->setIV(test->iv, test->ivSize);
+            cipher->decrypt(buffer + offset, buffer + offset, CTR_TEST_SIZE);
+            if (memcmp(buffer + offset, plaintext, CTR_TEST_SIZE) != 0)
+                ok = false;
+        }
+    }
+
+    // Encrypt from an unaligned input to an aligned output buffer.
+    memcpy(buffer + 1, plaintext, CTR_TEST_SIZE);
+    encryptSplit(cipher, test, expected, buffer + 1, 5);
+    if (memcmp(expected, test->ciphertext, CTR_TEST_SIZE) != 0)
+        ok = false;
+
+    if (ok)
+        Serial.println("Passed");
+    else
+        Serial.println("Failed");
+}
+
+// Checks that CTRFixed with a short counter gives the same output as
+// CTR after setCounterSize().  The last two bytes of the IV wrap around
+// after two blocks, and must not carry into the rest of the IV.
+void testCounterSize(CTRCommon *ctr, Cipher *fixed,
+                     const struct CTRTestVector *test, size_t counterSize)
+{
+    size_t index;
+    bool ok = true;
+
+    Serial.print("CTRFixed<");
+    Serial.print(test->name);
+    Serial.print(", ");
+    Serial.print((unsigned int)(test->ivSize));
+    Serial.print(", ");
+    Serial.print((unsigned int)counterSize);
+    Serial.print("> ... ");
+
+    ctr->setKey(test->key, test->keySize);
+    if (!ctr->setCounterSize(counterSize))
+        ok = false;
+    fixed->setKey(test->key, test->keySize);
+    for (index = 0; index < sizeof(splits) / sizeof(splits[0]); ++index) {
+        encryptSplit(ctr, test, expected, plaintext, CTR_TEST_SIZE);
+        encryptSplit(fixed, test, buffer, plaintext, splits[index]);
+        if (memcmp(buffer, expected, CTR_TEST_SIZE) != 0)
+            ok = false;
+    }
+    if (memcmp(expected, test->ciphertext, CTR_TEST_SIZE) == 0)
+        ok = false; // The counter size had no effect.
+    ctr->setCounterSize(test->ivSize);
+
+    if (ok)
+        Serial.println("Passed");
+    else
+        Serial.println("Failed");
+}
+
+void setup()
+{
+    size_t index;
+
+    Serial.begin(9600);
+
+    Serial.println();
+
+    for (index = 0; index < CTR_TEST_SIZE; ++index)
+        plaintext[index] = (byte)(index * 7);
+
+    Serial.println("CTR Test Vectors:");
+    testCTR(&ctrSkinny128_256, &testVectorCTRSkinny128_256, "CTR");
+    testCTR(&ctrSkinny64_128, &testVectorCTRSkinny64_128, "CTR");
+    testCTR(&ctrMantis8, &testVectorCTRMantis8, "CTR");
+    testCTR(&ctrFixedSkinny128_256, &testVectorCTRSkinny128_256, "CTRFixed");
+    testCTR(&ctrFixedSkinny64_128, &testVectorCTRSkinny64_128, "CTRFixed");
+    testCTR(&ctrFixedMantis8, &testVectorCTRMantis8, "CTRFixed");
+
+    Serial.println();
+
+    Serial.println("CTR Counter Sizes:");
+    testCounterSize(&ctrSkinny128_256, &ctrFixedSkinny128_256_2,
+                    &testVectorCTRSkinny128_256, 2);
+    testCounterSize(&ctrSkinny64_128, &ctrFixedSkinny64_128_2,
+                    &testVectorCTRSkinny64_128, 2);
+    testCounterSize(&ctrMantis8, &ctrFixedMantis8_2,
+                    &testVectorCTRMantis8, 2);
+}
+
+void loop()
+{
+}
@@ -74,6 +74,9 @@ static TestVector const testVectorSkinny128_384 = {
 Skinny128_128 *skinny128_128;
 Skinny128_256 *skinny128_256;
 Skinny128_384 *skinny128_384;
+Skinny128_128_Small *skinny128_128_small;
+Skinny128_256_Small *skinny128_256_small;
+Skinny128_384_Small *skinny128_384_small;
 
 byte buffer[16];
 
@@ -155,6 +158,12 @@ void setup()
     Serial.println(sizeof(Skinny128_256));
     Serial.print("Skinny128_384 ... ");
     Serial.println(sizeof(Skinny128_384));
+    Serial.print("Skinny128_128_Small ... ");
+    Serial.println(sizeof(Skinny128_128_Small));
+    Serial.print("Skinny128_256_Small ... ");
+    Serial.println(sizeof(Skinny128_256_Small));
+    Serial.print("Skinny128_384_Small ... ");
+    Serial.println(sizeof(Skinny128_384_Small));
     Serial.println();
 
     Serial.println("Skinny128 Test Vectors:");
@@ -170,6 +179,19 @@ void setup()
 
     Serial.println();
 
+    Serial.println("Skinny128_Small Test Vectors:");
+    skinny128_128_small = new Skinny128_128_Small();
+    testCipher(skinny128_128_small, &testVectorSkinny128_128);
+    delete skinny128_128_small;
+    skinny128_256_small = new Skinny128_256_Small();
+    testCipher(skinny128_256_small, &testVectorSkinny128_256);
+    delete skinny128_256_small;
+    skinny128_384_small = new Skinny128_384_Small();
+    testCipher(skinny128_384_small, &testVectorSkinny128_384);
+    delete skinny128_384_small;
+
+    Serial.println();
+
     Serial.println("Skinny128 Performance Tests:");
     skinny128_128 = new Skinny128_128();
     perfCipher(skinny128_128, &testVectorSkinny128_128);
@@ -180,6 +202,17 @@ void setup()
     skinny128_384 = new Skinny128_384();
     perfCipher(skinny128_384, &testVectorSkinny128_384);
     delete skinny128_384;
+
+    Serial.println("Skinny128_Small Performance Tests:");
+    skinny128_128_small = new Skinny128_128_Small();
+    perfCipher(skinny128_128_small, &testVectorSkinny128_128);
+    delete skinny128_128_small;
+    skinny128_256_small = new Skinny128_256_Small();
+    perfCipher(skinny128_256_small, &testVectorSkinny128_256);
+    delete skinny128_256_small;
+    skinny128_384_small = new Skinny128_384_Small();
+    perfCipher(skinny128_384_small, &testVectorSkinny128_384);
+    delete skinny128_384_small;
 }
 
 void loop()
@@ -124,6 +124,30 @@ typedef struct
 
 } MantisKey_t;
 
+/**
+ * \brief Mantis key schedule with a fixed tweak, with the tweak schedule
+ * and round constants folded into a word for each round.
+ *
+ * Set this up with mantis_prepare_tweak() when many blocks are processed
+ * under the same tweak; e.g. all of the blocks in a memory page.
+ */
+typedef struct
+{
+    /** Initial whitening word: k0, k1, and the initial tweak */
+    MantisCells_t whiten_in;
+
+    /** Final whitening word: k0prime, k1 XOR alpha, and the final tweak */
+    MantisCells_t whiten_out;
+
+    /** Key, tweak, and round constant words for the forward rounds
+        followed by the reverse rounds */
+    MantisCells_t schedule[MANTIS_MAX_ROUNDS * 2];
+
+    /** Number of encryption/decryption rounds (half the full amount) */
+    unsigned rounds;
+
+} MantisPreparedTweak_t;
+
 /**
  * \brief State information for Mantis in CTR mode.
  */
@@ -234,6 +258,52 @@ void mantis_ecb_crypt(void *output, const void *input, const MantisKey_t *ks);
 void mantis_ecb_crypt_tweaked
     (void *output, const void *input, const void *tweak, const MantisKey_t *ks);
 
+/**
+ * \brief Prepares a key schedule for encrypting or decrypting many
+ * blocks under the same tweak.
+ *
+ * \param pt The prepared tweak structure to populate.
+ * \param ks The key schedule that was set up by mantis_set_key().
+ * \param tweak The tweak value, or NULL to use the tweak that is
+ * currently set on \a ks.
+ * \param size Size of the tweak value; must be MANTIS_TWEAK_SIZE.
+ *
+ * \return Zero if there is something wrong with the parameters,
+ * or 1 if the tweak was prepared.
+ *
+ * The encryption or decryption mode of \a ks is captured at the time
+ * of the call.  Later calls to mantis_swap_modes() or mantis_set_tweak()
+ * on \a ks do not affect \a pt.
+ *
+ * \sa mantis_ecb_crypt_prepared()
+ */
+int mantis_prepare_tweak
+    (MantisPreparedTweak_t *pt, const MantisKey_t *ks,
+     const void *tweak, unsigned size);
+
+/**
+ * \brief Encrypts or decrypts blocks using the Mantis block cipher in
+ * ECB mode with a prepared tweak.
+ *
+ * \param output The output buffer, which must contain at least
+ * \a count * MANTIS_BLOCK_SIZE bytes of space.
+ * \param input The input buffer, which must contain at least
+ * \a count * MANTIS_BLOCK_SIZE bytes of data.
+ * \param count The number of blocks to encrypt or decrypt.
+ * \param pt The prepared tweak that was set up by mantis_prepare_tweak().
+ *
+ * The \a input and \a output buffers are allowed to be the same.
+ *
+ * The output is the same as calling mantis_ecb_crypt() on each block
+ * with the tweak set on the key schedule, but the tweak schedule is
+ * not recomputed for every block.
+ *
+ * \sa mantis_prepare_tweak()
+ */
+void mantis_ecb_crypt_prepared
+    (void *output, const void *input, size_t count,
+     const MantisPreparedTweak_t *pt);
+
 /**
  * \brief Initializes Mantis in CTR mode.
  *
@@ -255,6 +325,19 @@ int mantis_ctr_init(MantisCTR_t *ctr);
  */
 void mantis_ctr_cleanup(MantisCTR_t *ctr);
 
+/**
+ * \brief Gets the name of the back end that a Mantis CTR control block
+ * is using.
+ *
+ * \param ctr Points to the CTR control block.
+ *
+ * \return The name of the back end, such as "default" or "vec256",
+ * or NULL if \a ctr has not been initialized.
+ *
+ * This is intended for benchmarks and diagnostics.
+ */
+const char *mantis_ctr_backend_name(const MantisCTR_t *ctr);
+
 /**
  * \brief Sets the key schedule for a Mantis block cipher in CTR mode.
  *
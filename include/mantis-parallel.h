@@ -71,6 +71,20 @@ int mantis_parallel_ecb_init(MantisParallelECB_t *ecb);
  */
 void mantis_parallel_ecb_cleanup(MantisParallelECB_t *ecb);
 
+/**
+ * \brief Gets the name of the back end that a Mantis parallel ECB control
+ * block is using.
+ *
+ * \param ecb Points to the parallel ECB control block.
+ *
+ * \return The name of the back end, such as "default" or "vec256",
+ * or NULL if \a ecb has not been initialized.
+ *
+ * This is intended for benchmarks and diagnostics.
+ */
+const char *mantis_parallel_ecb_backend_name
+    (const MantisParallelECB_t *ecb);
+
 /**
  * \brief Sets the key schedule for a Mantis block cipher in
  * parallel ECB mode.
@@ -125,6 +139,64 @@ int mantis_parallel_ecb_crypt
     (void *output, const void *input, const void *tweak, size_t size,
      const MantisParallelECB_t *ecb);
 
+/**
+ * \brief Encrypts or decrypts a run of blocks using the Mantis block
+ * cipher in ECB mode, with the best parallel back end for this platform.
+ *
+ * \param output The output buffer for the result.
+ * \param input The input buffer containing the data to be processed.
+ * \param tweak A buffer containing the tweak values to use for each
+ * block in the input.
+ * \param count The number of 8-byte blocks to be processed.
+ * \param ks The key schedule that was set up by mantis_set_key().
+ *
+ * This is equivalent to calling mantis_ecb_crypt_tweaked() on each block
+ * in turn, but it uses the same vectorized back ends as
+ * mantis_parallel_ecb_crypt() directly on the caller's key schedule.
+ * There is no need to allocate a separate parallel ECB context or to
+ * set up the key a second time.
+ *
+ * The \a input and \a output buffers are allowed to be the same.
+ *
+ * The encryption or decryption mode is selected when the key schedule
+ * is setup by mantis_set_key().  The mode can also be altered on the
+ * fly by calling mantis_swap_modes().
+ *
+ * \sa mantis_ecb_crypt_tweaked()
+ */
+void mantis_ecb_crypt_blocks
+    (void *output, const void *input, const void *tweak, size_t count,
+     const MantisKey_t *ks);
+
+/**
+ * \brief Encrypts or decrypts an array of 64-bit integers, such as
+ * database row IDs, using the Mantis block cipher in ECB mode.
+ *
+ * \param output The output array for the result.
+ * \param input The input array containing the values to be processed.
+ * \param tweak An array containing a 64-bit tweak for each value,
+ * or NULL to use the tweak from the key schedule for all values.
+ * \param count The number of values to be processed.
+ * \param ks The key schedule that was set up by mantis_set_key().
+ *
+ * Each value and tweak is converted into the 8-byte block that holds it
+ * in little-endian byte order, and the result is converted back into a
+ * host-endian value.  The results are the same on all platforms.
+ * On little-endian platforms with a \a tweak array, this is the same
+ * as calling mantis_ecb_crypt_blocks() on the arrays with no conversions.
+ *
+ * The \a input and \a output arrays are allowed to be the same.
+ *
+ * The encryption or decryption mode is selected when the key schedule
+ * is setup by mantis_set_key().  The mode can also be altered on the
+ * fly by calling mantis_swap_modes().
+ *
+ * \sa mantis_ecb_crypt_blocks()
+ */
+void mantis_ecb_crypt_ids
+    (uint64_t *output, const uint64_t *input, const uint64_t *tweak,
+     size_t count, const MantisKey_t *ks);
+
 /**@}*/
 
 #ifdef __cplusplus
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2017 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SKINNY_AUTOTUNE_h
+#define SKINNY_AUTOTUNE_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \defgroup autotune Autotuning API
+ * \brief Chooses the fastest back ends for this machine by measurement.
+ *
+ * By default, the CTR and parallel ECB modes select the widest SIMD back
+ * end that the CPU supports.  This is not always the fastest choice;
+ * for example, some CPUs reduce their clock frequency when running AVX2
+ * code.  The autotuner times each of the available back ends on a bulk
+ * workload and arranges for later calls to skinny128_ctr_init(),
+ * skinny128_parallel_ecb_init(), skinny128_ecb_encrypt_blocks(),
+ * and the equivalents for Skinny-64 and Mantis to use the winners.
+ * Contexts that were initialized before autotuning are not affected.
+ */
+/**@{*/
+
+/**
+ * \brief Chooses the fastest back end for each mode of operation.
+ *
+ * \param cache_file Name of a file to load the previous results from,
+ * or NULL to always measure the back ends.  If the file does not exist,
+ * or it was written on a different kind of CPU, then the back ends are
+ * measured and the results are written to \a cache_file.
+ *
+ * \return Zero if the results could not be written to \a cache_file,
+ * or 1 otherwise.  The measured back ends are used for the rest of the
+ * process even if the return value is zero.
+ *
+ * This function takes a few milliseconds if the back ends have to be
+ * measured.  It should be called once at startup, before other threads
+ * start using the library.
+ */
+int skinny_autotune(const char *cache_file);
+
+/**@}*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2017 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SKINNY_STATS_h
+#define SKINNY_STATS_h
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \defgroup stats Statistics API
+ * \brief Counters for events that bypass the fast paths of the library.
+ *
+ * The counters are only collected if the library was compiled with
+ * <tt>SKINNY_STATS</tt> defined to 1; see <tt>STATS_CFLAGS</tt> in
+ * <tt>options.mak</tt>.  Each thread has its own set of counters
+ * so no locking is required to update them.
+ */
+/**@{*/
+
+/**
+ * \brief Snapshot of the statistics counters for the current thread.
+ */
+typedef struct
+{
+    /** Number of blocks that were processed by a parallel back end in
+        parallel ECB mode or the ECB blocks functions */
+    unsigned long long parallel_blocks;
+
+    /** Number of left-over blocks in parallel ECB mode or the ECB blocks
+        functions that were processed one at a time because they did not
+        fill a complete parallel_size chunk */
+    unsigned long long tail_blocks;
+
+    /** Number of bytes of already-generated CTR keystream that were
+        thrown away because the counter was changed part-way through */
+    unsigned long long ctr_discarded_bytes;
+
+    /** Number of times that the whole key schedule was rewritten
+        to change the tweak */
+    unsigned long long tweak_rewrites;
+
+    /** Number of CTR and parallel ECB contexts that were allocated */
+    unsigned long long context_allocs;
+
+} SkinnyStats_t;
+
+/**
+ * \brief Gets a snapshot of the statistics counters for the current thread.
+ *
+ * \param stats Returns the current values of the counters.
+ *
+ * \return Zero if the library was compiled without statistics support,
+ * in which case \a stats is set to all-zeroes, or 1 if the counters
+ * were collected.
+ *
+ * \sa skinny_stats_reset()
+ */
+int skinny_stats_snapshot(SkinnyStats_t *stats);
+
+/**
+ * \brief Resets the statistics counters for the current thread to zero.
+ *
+ * \sa skinny_stats_snapshot()
+ */
+void skinny_stats_reset(void);
+
+/**@}*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -215,6 +215,19 @@ int skinny128_ctr_init(Skinny128CTR_t *ctr);
  */
 void skinny128_ctr_cleanup(Skinny128CTR_t *ctr);
 
+/**
+ * \brief Gets the name of the back end that a Skinny-128 CTR control block
+ * is using.
+ *
+ * \param ctr Points to the CTR control block.
+ *
+ * \return The name of the back end, such as "default" or "vec256",
+ * or NULL if \a ctr has not been initialized.
+ *
+ * This is intended for benchmarks and diagnostics.
+ */
+const char *skinny128_ctr_backend_name(const Skinny128CTR_t *ctr);
+
 /**
  * \brief Sets the key schedule for a Skinny128 block cipher in CTR mode.
  *
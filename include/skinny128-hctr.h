@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2017 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SKINNY128_HCTR_h
+#define SKINNY128_HCTR_h
+
+#include "skinny128-cipher.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \addtogroup skinny128
+ */
+/**@{*/
+
+/**
+ * \brief State information for Skinny-128 in HCTR wide-block mode.
+ *
+ * HCTR mode encrypts a whole page, such as a 4K database page, as a
+ * single block so that changing any bit of the plaintext changes every
+ * bit of the ciphertext.  The construction follows the shape of HCTR2
+ * and Adiantum:
+ *
+ * \li The first 16 bytes of the page are added (modulo 2^128) to a
+ * Poly1305 hash of the rest of the page.
+ * \li The result is encrypted with a single call to Skinny-128-384,
+ * with the page's 128-bit tweak in the tweakey.
+ * \li The rest of the page is encrypted in CTR mode, with the output of
+ * the previous step as the starting counter.
+ * \li A Poly1305 hash of the encrypted rest of the page is subtracted
+ * from the output of the block cipher to give the first 16 bytes of
+ * the ciphertext.
+ *
+ * The ciphertext is the same size as the plaintext.  Most of the work is
+ * done by Skinny-128 in CTR mode, using the best back end for this
+ * platform.  This mode is specific to this library and is not compatible
+ * with the HCTR2 or Adiantum specifications.
+ *
+ * Each page must be encrypted with a unique tweak, such as its page
+ * number, or equal pages under equal tweaks will be visible to an
+ * attacker.  There is no authentication; a modified ciphertext page
+ * decrypts to a random-looking plaintext page.
+ */
+typedef struct
+{
+    /** Dynamically-allocated context information */
+    void *ctx;
+
+} Skinny128HCTR_t;
+
+/**
+ * \brief Size of the per-page tweak for Skinny-128 in HCTR mode.
+ */
+#define SKINNY128_HCTR_TWEAK_SIZE 16
+
+/**
+ * \brief Initializes Skinny-128 in HCTR wide-block mode.
+ *
+ * \param hctr Points to the HCTR control block to initialize.
+ *
+ * \return Zero if \a hctr is NULL or there is insufficient memory to
+ * create internal data structures, or non-zero if everything is OK.
+ *
+ * \sa skinny128_hctr_set_key(), skinny128_hctr_encrypt()
+ */
+int skinny128_hctr_init(Skinny128HCTR_t *hctr);
+
+/**
+ * \brief Cleans up an HCTR control block for Skinny-128.
+ *
+ * \param hctr Points to the HCTR control block to clean up.
+ */
+void skinny128_hctr_cleanup(Skinny128HCTR_t *hctr);
+
+/**
+ * \brief Sets the key for Skinny-128 in HCTR wide-block mode.
+ *
+ * \param hctr The HCTR control block to set the key on.
+ * \param key Points to the key.
+ * \param size Size of the key, between 16 and 48 bytes.
+ *
+ * \return Zero if there is something wrong with the parameters,
+ * or 1 if the key has been set.
+ *
+ * The CTR key, the block cipher key, and the hash key are derived
+ * from \a key by encrypting constant blocks with Skinny-128.
+ */
+int skinny128_hctr_set_key
+    (Skinny128HCTR_t *hctr, const void *key, unsigned size);
+
+/**
+ * \brief Encrypts one or more pages using Skinny-128 in HCTR mode.
+ *
+ * \param output The output buffer for the ciphertext pages.
+ * \param input The input buffer containing the plaintext pages.
+ * \param page_size The size of each page in bytes, which must be at
+ * least SKINNY128_BLOCK_SIZE.
+ * \param tweaks Points to \a count tweak values, each of which is
+ * SKINNY128_HCTR_TWEAK_SIZE bytes in size.
+ * \param count The number of pages to encrypt.
+ * \param hctr The HCTR control block to use.
+ *
+ * \return Zero if there is something wrong with the parameters,
+ * or 1 if the pages were encrypted.
+ *
+ * The \a input and \a output buffers are allowed to be the same.
+ *
+ * The HCTR control block holds per-request state, so it must not be
+ * used by more than one thread at a time.
+ *
+ * \sa skinny128_hctr_decrypt()
+ */
+int skinny128_hctr_encrypt
+    (void *output, const void *input, size_t page_size,
+     const void *tweaks, size_t count, Skinny128HCTR_t *hctr);
+
+/**
+ * \brief Decrypts one or more pages using Skinny-128 in HCTR mode.
+ *
+ * \param output The output buffer for the plaintext pages.
+ * \param input The input buffer containing the ciphertext pages.
+ * \param page_size The size of each page in bytes, which must be at
+ * least SKINNY128_BLOCK_SIZE.
+ * \param tweaks Points to \a count tweak values, each of which is
+ * SKINNY128_HCTR_TWEAK_SIZE bytes in size.
+ * \param count The number of pages to decrypt.
+ * \param hctr The HCTR control block to use.
+ *
+ * \return Zero if there is something wrong with the parameters,
+ * or 1 if the pages were decrypted.
+ *
+ * The \a input and \a output buffers are allowed to be the same.
+ *
+ * \sa skinny128_hctr_encrypt()
+ */
+int skinny128_hctr_decrypt
+    (void *output, const void *input, size_t page_size,
+     const void *tweaks, size_t count, Skinny128HCTR_t *hctr);
+
+/**@}*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2017 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SKINNY128_KDF_h
+#define SKINNY128_KDF_h
+
+#include "skinny128-cipher.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \addtogroup skinny128
+ */
+/**@{*/
+
+/**
+ * \brief Size of each label for the Skinny-128 key derivation function.
+ */
+#define SKINNY128_KDF_LABEL_SIZE 16
+
+/**
+ * \brief Maximum size of a subkey from the Skinny-128 key derivation
+ * function.
+ */
+#define SKINNY128_KDF_MAX_SUBKEY_SIZE 48
+
+/**
+ * \brief Size of the Skinny-128-384 tweakey that the Skinny-128 key
+ * derivation function encrypts the labels with.
+ */
+#define SKINNY128_KDF_TWEAKEY_SIZE 48
+
+/**
+ * \brief State information for the Skinny-128 key derivation function.
+ *
+ * The KDF derives subkeys from a master key and 16-byte labels, such as
+ * object or tenant identifiers.  Each 16-byte block of a subkey is
+ * produced by encrypting the label with Skinny-128-384.  The 48-byte
+ * tweakey T(i) for block i is made up of the master key K padded with
+ * zeroes to 32 bytes, followed by the bytes i, the size of K, the size
+ * of the subkey, and zero padding:
+ *
+ * \code
+ * T(i) = K || 0...0 || i || size(K) || size(subkey) || 0...0
+ * subkey = E(T(1), label) || E(T(2), label) || E(T(3), label)
+ * \endcode
+ *
+ * The subkey is truncated to the requested size.  Because the size is
+ * part of the tweakey, subkeys of different sizes for the same label
+ * are unrelated to each other.
+ *
+ * Subkeys for many labels are derived at once with the parallel
+ * ECB back ends.  Different labels always give different subkeys.
+ */
+typedef struct
+{
+    /** Tweakey template with the padded master key and its size */
+    uint8_t tk[SKINNY128_KDF_TWEAKEY_SIZE];
+
+} Skinny128KDF_t;
+
+/**
+ * \brief Sets the master key for the Skinny-128 key derivation function.
+ *
+ * \param kdf The KDF state to set the key on.
+ * \param key Points to the master key.
+ * \param size Size of the master key, between 16 and 32 bytes.
+ *
+ * \return Zero if there is something wrong with the parameters,
+ * or 1 if the key has been set.
+ */
+int skinny128_kdf_set_key(Skinny128KDF_t *kdf, const void *key, unsigned size);
+
+/**
+ * \brief Derives subkeys for an array of labels.
+ *
+ * \param subkeys The output buffer for \a count subkeys, each of which
+ * is \a subkey_size bytes in size.
+ * \param subkey_size The size of each subkey, between 1 and
+ * SKINNY128_KDF_MAX_SUBKEY_SIZE bytes.
+ * \param labels Points to \a count labels, each of which is
+ * SKINNY128_KDF_LABEL_SIZE bytes in size.
+ * \param count The number of subkeys to derive.
+ * \param kdf The KDF state containing the master key.
+ *
+ * \return Zero if there is something wrong with the parameters,
+ * or 1 if the subkeys were derived.
+ *
+ * \sa skinny128_kdf_derive_keys()
+ */
+int skinny128_kdf_derive
+    (void *subkeys, unsigned subkey_size, const void *labels,
+     size_t count, const Skinny128KDF_t *kdf);
+
+/**
+ * \brief Derives subkeys for an array of labels and expands them into
+ * Skinny-128 key schedules.
+ *
+ * \param schedules The output array of \a count key schedules.
+ * \param key_size The size of each derived key, between 16 and 48 bytes.
+ * \param labels Points to \a count labels, each of which is
+ * SKINNY128_KDF_LABEL_SIZE bytes in size.
+ * \param count The number of key schedules to derive.
+ * \param kdf The KDF state containing the master key.
+ *
+ * \return Zero if there is something wrong with the parameters,
+ * or 1 if the key schedules were derived.
+ *
+ * This is equivalent to calling skinny128_kdf_derive() and then
+ * skinny128_set_key() on each subkey, but the raw subkeys are never
+ * exposed to the caller.
+ */
+int skinny128_kdf_derive_keys
+    (Skinny128Key_t *schedules, unsigned key_size, const void *labels,
+     size_t count, const Skinny128KDF_t *kdf);
+
+/**@}*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,199 @@
+/*
+ * Copyright (C) 2017 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SKINNY128_KEYHANDLE_h
+#define SKINNY128_KEYHANDLE_h
+
+#include "skinny128-cipher.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \addtogroup skinny128
+ */
+/**@{*/
+
+/**
+ * \brief Skinny-128 key schedule that can be shared between threads
+ * and replaced while other threads are using it.
+ *
+ * The current key schedule is published through an atomic pointer.
+ * Readers bracket their use of the key schedule with
+ * skinny128_key_handle_acquire() and skinny128_key_handle_release().
+ * These never block and never take a lock.
+ *
+ * skinny128_key_handle_rotate() expands the new key schedule off to
+ * the side and publishes it atomically.  It then waits for the readers
+ * that may still hold the old key schedule, and cleanses and frees it.
+ * Readers that arrive during the rotation use the new key straight away.
+ *
+ * This requires compiler support for atomic operations, which is
+ * available in gcc 4.7 or later and clang.  Without it,
+ * skinny128_key_handle_init() will fail.
+ */
+typedef struct
+{
+    /** Dynamically-allocated context information */
+    void *ctx;
+
+} Skinny128KeyHandle_t;
+
+/**
+ * \brief Initializes a shared key handle with its first key.
+ *
+ * \param handle Points to the key handle to initialize.
+ * \param key Points to the key.
+ * \param size Size of the key, between 16 and 48 bytes.
+ *
+ * \return Zero if there is something wrong with the parameters, there
+ * is insufficient memory, or the platform does not support atomic
+ * operations; non-zero if everything is OK.
+ *
+ * \sa skinny128_key_handle_rotate(), skinny128_key_handle_cleanup()
+ */
+int skinny128_key_handle_init
+    (Skinny128KeyHandle_t *handle, const void *key, unsigned size);
+
+/**
+ * \brief Cleans up a shared key handle.
+ *
+ * \param handle Points to the key handle to clean up.
+ *
+ * No other thread may be using the key handle when it is cleaned up.
+ */
+void skinny128_key_handle_cleanup(Skinny128KeyHandle_t *handle);
+
+/**
+ * \brief Replaces the key in a shared key handle.
+ *
+ * \param handle Points to the key handle.
+ * \param key Points to the new key.
+ * \param size Size of the new key, between 16 and 48 bytes.
+ *
+ * \return Zero if there is something wrong with the parameters or
+ * there is insufficient memory, or 1 if the key has been replaced.
+ *
+ * This function returns once no reader can be using the old key
+ * schedule any more.  It must not be called by a thread that is
+ * holding the key schedule from skinny128_key_handle_acquire().
+ * Concurrent calls to this function are serialized.
+ */
+int skinny128_key_handle_rotate
+    (Skinny128KeyHandle_t *handle, const void *key, unsigned size);
+
+/**
+ * \brief Acquires the current key schedule from a shared key handle.
+ *
+ * \param handle Points to the key handle.
+ * \param token Returns a token to pass to skinny128_key_handle_release().
+ *
+ * \return A pointer to the current key schedule, which remains valid
+ * until skinny128_key_handle_release() is called.
+ *
+ * The key schedule can be passed to skinny128_ecb_encrypt() or
+ * skinny128_ecb_encrypt_blocks().  Readers should release it quickly
+ * because rotations wait for them.
+ */
+const Skinny128Key_t *skinny128_key_handle_acquire
+    (Skinny128KeyHandle_t *handle, unsigned *token);
+
+/**
+ * \brief Releases a key schedule that was acquired from a shared
+ * key handle.
+ *
+ * \param handle Points to the key handle.
+ * \param token The token from skinny128_key_handle_acquire().
+ */
+void skinny128_key_handle_release
+    (Skinny128KeyHandle_t *handle, unsigned token);
+
+/**
+ * \brief Encrypts blocks in ECB mode with the current key of a shared
+ * key handle.
+ *
+ * \param output The output buffer for the ciphertext.
+ * \param input The input buffer containing the plaintext.
+ * \param size The number of bytes to encrypt, which must be a multiple
+ * of SKINNY128_BLOCK_SIZE.
+ * \param handle Points to the key handle.
+ *
+ * \return Zero if there is something wrong with the parameters,
+ * or 1 if the data was encrypted.
+ *
+ * The blocks are encrypted with the best parallel back end for this
+ * platform, as for skinny128_ecb_encrypt_blocks().
+ */
+int skinny128_key_handle_ecb_encrypt
+    (void *output, const void *input, size_t size,
+     Skinny128KeyHandle_t *handle);
+
+/**
+ * \brief Decrypts blocks in ECB mode with the current key of a shared
+ * key handle.
+ *
+ * \param output The output buffer for the plaintext.
+ * \param input The input buffer containing the ciphertext.
+ * \param size The number of bytes to decrypt, which must be a multiple
+ * of SKINNY128_BLOCK_SIZE.
+ * \param handle Points to the key handle.
+ *
+ * \return Zero if there is something wrong with the parameters,
+ * or 1 if the data was decrypted.
+ */
+int skinny128_key_handle_ecb_decrypt
+    (void *output, const void *input, size_t size,
+     Skinny128KeyHandle_t *handle);
+
+/**
+ * \brief Encrypts data in CTR mode with the current key of a shared
+ * key handle.
+ *
+ * \param output The output buffer for the ciphertext.
+ * \param input The input buffer containing the plaintext.
+ * \param size The number of bytes to encrypt.
+ * \param counter The caller's 16-byte big-endian counter block, which
+ * is advanced by the number of keystream blocks that were used.
+ * \param handle Points to the key handle.
+ *
+ * \return Zero if there is something wrong with the parameters,
+ * or 1 if the data was encrypted.
+ *
+ * All of the state for the request is in \a counter, so many threads can
+ * share the same key handle.  The keystream for a final partial block is
+ * discarded, so a request that is a multiple of SKINNY128_BLOCK_SIZE
+ * gives the same output as skinny128_ctr_encrypt() with the same key and
+ * counter.  The whole request is encrypted with one key, even if the
+ * key is rotated part-way through.
+ */
+int skinny128_key_handle_ctr_encrypt
+    (void *output, const void *input, size_t size, void *counter,
+     Skinny128KeyHandle_t *handle);
+
+/**@}*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -71,6 +71,20 @@ int skinny128_parallel_ecb_init(Skinny128ParallelECB_t *ecb);
  */
 void skinny128_parallel_ecb_cleanup(Skinny128ParallelECB_t *ecb);
 
+/**
+ * \brief Gets the name of the back end that a Skinny-128 parallel ECB control
+ * block is using.
+ *
+ * \param ecb Points to the parallel ECB control block.
+ *
+ * \return The name of the back end, such as "x2" or "vec256",
+ * or NULL if \a ecb has not been initialized.
+ *
+ * This is intended for benchmarks and diagnostics.
+ */
+const char *skinny128_parallel_ecb_backend_name
+    (const Skinny128ParallelECB_t *ecb);
+
 /**
  * \brief Sets the key schedule for a Skinny128 block cipher in
  * parallel ECB mode.
@@ -130,6 +144,48 @@ int skinny128_parallel_ecb_decrypt
     (void *output, const void *input, size_t size,
      const Skinny128ParallelECB_t *ecb);
 
+/**
+ * \brief Encrypts a run of blocks using the Skinny128 block cipher in ECB mode,
+ * with the best parallel back end for this platform.
+ *
+ * \param output The output buffer for the ciphertext.
+ * \param input The input buffer containing the plaintext.
+ * \param count The number of 16-byte blocks to be encrypted.
+ * \param ks The key schedule that was set up by skinny128_set_key().
+ *
+ * This is equivalent to calling skinny128_ecb_encrypt() on each block in turn,
+ * but it uses the same vectorized back ends as skinny128_parallel_ecb_encrypt()
+ * directly on the caller's key schedule.  There is no need to allocate
+ * a separate parallel ECB context or to set up the key a second time.
+ *
+ * The \a input and \a output buffers are allowed to be the same.
+ *
+ * \sa skinny128_ecb_decrypt_blocks(), skinny128_ecb_encrypt()
+ */
+void skinny128_ecb_encrypt_blocks
+    (void *output, const void *input, size_t count, const Skinny128Key_t *ks);
+
+/**
+ * \brief Decrypts a run of blocks using the Skinny128 block cipher in ECB mode,
+ * with the best parallel back end for this platform.
+ *
+ * \param output The output buffer for the plaintext.
+ * \param input The input buffer containing the ciphertext.
+ * \param count The number of 16-byte blocks to be decrypted.
+ * \param ks The key schedule that was set up by skinny128_set_key().
+ *
+ * This is equivalent to calling skinny128_ecb_decrypt() on each block in turn,
+ * but it uses the same vectorized back ends as skinny128_parallel_ecb_decrypt()
+ * directly on the caller's key schedule.  There is no need to allocate
+ * a separate parallel ECB context or to set up the key a second time.
+ *
+ * The \a input and \a output buffers are allowed to be the same.
+ *
+ * \sa skinny128_ecb_encrypt_blocks(), skinny128_ecb_decrypt()
+ */
+void skinny128_ecb_decrypt_blocks
+    (void *output, const void *input, size_t count, const Skinny128Key_t *ks);
+
 /**@}*/
 
 #ifdef __cplusplus
@@ -0,0 +1,203 @@
+/*
+ * Copyright (C) 2017 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SKINNY128_QUEUE_h
+#define SKINNY128_QUEUE_h
+
+#include "skinny128-cipher.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \addtogroup skinny128
+ */
+/**@{*/
+
+/**
+ * \brief Number of blocks that a job queue tries to gather before it
+ * starts a batch without waiting for the latency bound.
+ *
+ * This is enough for several passes through the widest parallel back end.
+ */
+#define SKINNY128_QUEUE_BATCH_BLOCKS 64
+
+/**
+ * \brief Direction value for Skinny128Job_t to encrypt the input.
+ */
+#define SKINNY128_JOB_ENCRYPT 0
+
+/**
+ * \brief Direction value for Skinny128Job_t to decrypt the input.
+ */
+#define SKINNY128_JOB_DECRYPT 1
+
+typedef struct Skinny128Job_s Skinny128Job_t;
+
+/**
+ * \brief Callback that is invoked on a worker thread when a job is done.
+ *
+ * The job is marked as done just before the callback is invoked, and
+ * the queue does not touch the job again, so the callback may free,
+ * reuse, or resubmit the job.  As a consequence, a thread that polls
+ * or waits for a job with a callback may see it as done while the
+ * callback is still running.  Such jobs should be released by the
+ * callback, not by the thread that waits for them.
+ */
+typedef void (*Skinny128JobCallback_t)(Skinny128Job_t *job);
+
+/**
+ * \brief Request to encrypt or decrypt blocks in ECB mode with
+ * a Skinny128 job queue.
+ *
+ * The caller fills in the public fields and owns the memory for the
+ * job, the buffers, and the key schedule until the job is done.
+ * Many jobs can share the same key schedule.
+ */
+struct Skinny128Job_s
+{
+    /** Output buffer for the result */
+    void *output;
+
+    /** Input buffer, which may be the same as \a output */
+    const void *input;
+
+    /** Number of bytes to process, which must be a multiple of
+        SKINNY128_BLOCK_SIZE */
+    size_t size;
+
+    /** Key schedule to process the data with */
+    const Skinny128Key_t *ks;
+
+    /** SKINNY128_JOB_ENCRYPT or SKINNY128_JOB_DECRYPT */
+    int direction;
+
+    /** Optional callback to invoke when the job is done, or NULL */
+    Skinny128JobCallback_t callback;
+
+    /** Application data for the callback */
+    void *user_data;
+
+    /** Internal: non-zero once the job is done */
+    int done;
+
+    /** Internal: link to the next pending job */
+    Skinny128Job_t *next;
+
+    /** Internal: time by which a batch containing this job must start,
+        in microseconds */
+    unsigned long long deadline;
+};
+
+/**
+ * \brief Queue that gathers small Skinny-128 ECB jobs from many threads
+ * and processes them in batches on worker threads.
+ *
+ * Jobs that share a key schedule and direction are packed together and
+ * passed to skinny128_ecb_encrypt_blocks() or
+ * skinny128_ecb_decrypt_blocks() as a single run, so that requests of
+ * one or two blocks can still fill the lanes of the parallel back ends.
+ *
+ * A worker starts a batch once SKINNY128_QUEUE_BATCH_BLOCKS blocks are
+ * pending or the oldest pending job has waited for the configured delay,
+ * whichever comes first.
+ *
+ * The job queue uses POSIX threads, so applications that use it must be
+ * linked with <tt>-pthread</tt>.  On other platforms, skinny128_queue_init()
+ * will fail.
+ */
+typedef struct
+{
+    /** Dynamically-allocated context information */
+    void *ctx;
+
+} Skinny128Queue_t;
+
+/**
+ * \brief Initializes a Skinny-128 job queue and starts its worker threads.
+ *
+ * \param queue Points to the job queue to initialize.
+ * \param threads Number of worker threads to start, which must be
+ * at least 1.
+ * \param max_delay_us Maximum number of microseconds that a job will wait
+ * for more jobs to batch with before a worker starts on it.  Zero
+ * processes jobs as soon as a worker is free.
+ *
+ * \return Zero if there is something wrong with the parameters, there
+ * are insufficient resources to start the threads, or the platform
+ * does not support threads; non-zero if everything is OK.
+ *
+ * \sa skinny128_queue_submit(), skinny128_queue_cleanup()
+ */
+int skinny128_queue_init
+    (Skinny128Queue_t *queue, unsigned threads, unsigned max_delay_us);
+
+/**
+ * \brief Cleans up a Skinny-128 job queue.
+ *
+ * \param queue Points to the job queue to clean up.
+ *
+ * Jobs that are still pending are processed before the worker threads
+ * are stopped.  No jobs may be submitted during or after this call.
+ */
+void skinny128_queue_cleanup(Skinny128Queue_t *queue);
+
+/**
+ * \brief Submits a job to a Skinny-128 job queue.
+ *
+ * \param queue Points to the job queue.
+ * \param job Points to the job, which must remain valid until it is done.
+ *
+ * \return Zero if there is something wrong with the parameters, or 1 if
+ * the job has been queued.
+ *
+ * \sa skinny128_queue_poll(), skinny128_queue_wait()
+ */
+int skinny128_queue_submit(Skinny128Queue_t *queue, Skinny128Job_t *job);
+
+/**
+ * \brief Determines if a Skinny-128 job is done.
+ *
+ * \param queue Points to the job queue that the job was submitted to.
+ * \param job Points to the job.
+ *
+ * \return Non-zero if the job is done and its output is ready,
+ * or zero if the job is still pending.
+ */
+int skinny128_queue_poll(Skinny128Queue_t *queue, const Skinny128Job_t *job);
+
+/**
+ * \brief Waits for a Skinny-128 job to be done.
+ *
+ * \param queue Points to the job queue that the job was submitted to.
+ * \param job Points to the job.
+ */
+void skinny128_queue_wait(Skinny128Queue_t *queue, const Skinny128Job_t *job);
+
+/**@}*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -216,6 +216,19 @@ int skinny64_ctr_init(Skinny64CTR_t *ctr);
  */
 void skinny64_ctr_cleanup(Skinny64CTR_t *ctr);
 
+/**
+ * \brief Gets the name of the back end that a Skinny-64 CTR control block
+ * is using.
+ *
+ * \param ctr Points to the CTR control block.
+ *
+ * \return The name of the back end, such as "default" or "vec256",
+ * or NULL if \a ctr has not been initialized.
+ *
+ * This is intended for benchmarks and diagnostics.
+ */
+const char *skinny64_ctr_backend_name(const Skinny64CTR_t *ctr);
+
 /**
  * \brief Sets the key schedule for a Skinny64 block cipher in CTR mode.
  *
@@ -71,6 +71,20 @@ int skinny64_parallel_ecb_init(Skinny64ParallelECB_t *ecb);
  */
 void skinny64_parallel_ecb_cleanup(Skinny64ParallelECB_t *ecb);
 
+/**
+ * \brief Gets the name of the back end that a Skinny-64 parallel ECB control
+ * block is using.
+ *
+ * \param ecb Points to the parallel ECB control block.
+ *
+ * \return The name of the back end, such as "x2" or "vec256",
+ * or NULL if \a ecb has not been initialized.
+ *
+ * This is intended for benchmarks and diagnostics.
+ */
+const char *skinny64_parallel_ecb_backend_name
+    (const Skinny64ParallelECB_t *ecb);
+
 /**
  * \brief Sets the key schedule for a Skinny64 block cipher in
  * parallel ECB mode.
@@ -130,6 +144,88 @@ int skinny64_parallel_ecb_decrypt
     (void *output, const void *input, size_t size,
      const Skinny64ParallelECB_t *ecb);
 
+/**
+ * \brief Encrypts a run of blocks using the Skinny64 block cipher in ECB mode,
+ * with the best parallel back end for this platform.
+ *
+ * \param output The output buffer for the ciphertext.
+ * \param input The input buffer containing the plaintext.
+ * \param count The number of 8-byte blocks to be encrypted.
+ * \param ks The key schedule that was set up by skinny64_set_key().
+ *
+ * This is equivalent to calling skinny64_ecb_encrypt() on each block in turn,
+ * but it uses the same vectorized back ends as skinny64_parallel_ecb_encrypt()
+ * directly on the caller's key schedule.  There is no need to allocate
+ * a separate parallel ECB context or to set up the key a second time.
+ *
+ * The \a input and \a output buffers are allowed to be the same.
+ *
+ * \sa skinny64_ecb_decrypt_blocks(), skinny64_ecb_encrypt()
+ */
+void skinny64_ecb_encrypt_blocks
+    (void *output, const void *input, size_t count, const Skinny64Key_t *ks);
+
+/**
+ * \brief Decrypts a run of blocks using the Skinny64 block cipher in ECB mode,
+ * with the best parallel back end for this platform.
+ *
+ * \param output The output buffer for the plaintext.
+ * \param input The input buffer containing the ciphertext.
+ * \param count The number of 8-byte blocks to be decrypted.
+ * \param ks The key schedule that was set up by skinny64_set_key().
+ *
+ * This is equivalent to calling skinny64_ecb_decrypt() on each block in turn,
+ * but it uses the same vectorized back ends as skinny64_parallel_ecb_decrypt()
+ * directly on the caller's key schedule.  There is no need to allocate
+ * a separate parallel ECB context or to set up the key a second time.
+ *
+ * The \a input and \a output buffers are allowed to be the same.
+ *
+ * \sa skinny64_ecb_encrypt_blocks(), skinny64_ecb_decrypt()
+ */
+void skinny64_ecb_decrypt_blocks
+    (void *output, const void *input, size_t count, const Skinny64Key_t *ks);
+
+/**
+ * \brief Encrypts an array of 64-bit integers, such as database row IDs,
+ * using the Skinny64 block cipher in ECB mode.
+ *
+ * \param output The output array for the encrypted values.
+ * \param input The input array containing the values to be encrypted.
+ * \param count The number of values to be encrypted.
+ * \param ks The key schedule that was set up by skinny64_set_key().
+ *
+ * Each value is encrypted as the 8-byte block that holds the value in
+ * little-endian byte order, and the result is converted back into a
+ * host-endian value.  The results are the same on all platforms.
+ * On little-endian platforms this is the same as calling
+ * skinny64_ecb_encrypt_blocks() on the array with no conversions.
+ *
+ * The \a input and \a output arrays are allowed to be the same.
+ *
+ * \sa skinny64_ecb_decrypt_ids(), skinny64_ecb_encrypt_blocks()
+ */
+void skinny64_ecb_encrypt_ids
+    (uint64_t *output, const uint64_t *input, size_t count,
+     const Skinny64Key_t *ks);
+
+/**
+ * \brief Decrypts an array of 64-bit integers that were encrypted with
+ * skinny64_ecb_encrypt_ids().
+ *
+ * \param output The output array for the decrypted values.
+ * \param input The input array containing the values to be decrypted.
+ * \param count The number of values to be decrypted.
+ * \param ks The key schedule that was set up by skinny64_set_key().
+ *
+ * The \a input and \a output arrays are allowed to be the same.
+ *
+ * \sa skinny64_ecb_encrypt_ids(), skinny64_ecb_decrypt_blocks()
+ */
+void skinny64_ecb_decrypt_ids
+    (uint64_t *output, const uint64_t *input, size_t count,
+     const Skinny64Key_t *ks);
+
 /**@}*/
 
 #ifdef __cplusplus
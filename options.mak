@@ -14,5 +14,23 @@ VEC128_CFLAGS = -msse2
 #VEC128_CFLAGS =
 
 # Extra CFLAGS to activate SIMD vector extensions for 256-bit vectors.
-VEC256_CFLAGS = -mavx2
-#VEC256_CFLAGS =
+# On x86 with gcc 5 or later or clang, the AVX2 back ends are always
+# compiled and then selected at runtime, so no extra flags are needed.
+VEC256_CFLAGS =
+#VEC256_CFLAGS = -mavx2
+
+# Extra CFLAGS to activate SIMD vector extensions for 512-bit vectors.
+# On x86 with gcc 5 or later or clang, the AVX-512 back ends are always
+# compiled and then selected at runtime, so no extra flags are needed.
+VEC512_CFLAGS =
+#VEC512_CFLAGS = -mavx512f -mavx512vl
+
+# Extra CFLAGS for collecting per-thread statistics on events that bypass
+# the fast paths of the library.  Use skinny_stats_snapshot() to read them.
+STATS_CFLAGS =
+#STATS_CFLAGS = -DSKINNY_STATS=1
+
+# Extra CFLAGS for compiling in SystemTap/USDT static probe points, which
+# requires <sys/sdt.h> from the SystemTap SDT development package.
+USDT_CFLAGS =
+#USDT_CFLAGS = -DSKINNY_USDT=1
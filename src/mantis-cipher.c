@@ -199,6 +199,7 @@ int mantis_set_key
 #endif
 
     /* Ready to go */
+    SKINNY_PROBE3(mantis_set_key, ks, rounds, mode);
     return 1;
 }
 
@@ -219,6 +220,7 @@ int mantis_set_tweak(MantisKey_t *ks, const void *tweak, unsigned size)
         ks->tweak.lrow[1] = 0;
 #endif
     }
+    SKINNY_PROBE2(mantis_set_tweak, ks, size);
     return 1;
 }
 
@@ -750,3 +752,174 @@ void mantis_ecb_crypt_tweaked
     WRITE_WORD16(output, 6, state.row[3]);
 #endif
 }
+
+/* XOR the round constant for a specific round into a cell array */
+STATIC_INLINE void mantis_xor_rc(MantisCells_t *cells, unsigned round)
+{
+#if RC_ROW_SIZE == 64
+    cells->llrow ^= rc[round];
+#elif RC_ROW_SIZE == 32
+    cells->lrow[0] ^= rc[round][0];
+    cells->lrow[1] ^= rc[round][1];
+#else
+    cells->row[0] ^= rc[round][0];
+    cells->row[1] ^= rc[round][1];
+    cells->row[2] ^= rc[round][2];
+    cells->row[3] ^= rc[round][3];
+#endif
+}
+
+/* XOR two cell arrays together */
+STATIC_INLINE void mantis_xor_cells
+    (MantisCells_t *out, const MantisCells_t *in1, const MantisCells_t *in2)
+{
+#if SKINNY_64BIT
+    out->llrow = in1->llrow ^ in2->llrow;
+#else
+    out->lrow[0] = in1->lrow[0] ^ in2->lrow[0];
+    out->lrow[1] = in1->lrow[1] ^ in2->lrow[1];
+#endif
+}
+
+int mantis_prepare_tweak
+    (MantisPreparedTweak_t *pt, const MantisKey_t *ks,
+     const void *tweak, unsigned size)
+{
+    MantisCells_t tk;
+    MantisCells_t k1;
+    unsigned index;
+
+    /* Validate the parameters */
+    if (!pt || !ks || size != MANTIS_TWEAK_SIZE)
+        return 0;
+
+    /* Determine the initial tweak and whitening value */
+    if (tweak)
+        mantis_unpack_block(&tk, tweak, 0);
+    else
+        tk = ks->tweak;
+    k1 = ks->k1;
+    pt->rounds = ks->rounds;
+    mantis_xor_cells(&(pt->whiten_in), &(ks->k0), &k1);
+    mantis_xor_cells(&(pt->whiten_in), &(pt->whiten_in), &tk);
+
+    /* Run the tweak schedule for the forward rounds */
+    for (index = 0; index < ks->rounds; ++index) {
+        mantis_update_tweak(&tk);
+        mantis_xor_cells(&(pt->schedule[index]), &k1, &tk);
+        mantis_xor_rc(&(pt->schedule[index]), index);
+    }
+
+    /* Convert k1 into k1 XOR alpha for the reverse rounds */
+#if RC_ROW_SIZE == 64
+    k1.llrow ^= ALPHA;
+#elif RC_ROW_SIZE == 32
+    k1.lrow[0] ^= ALPHA_ROW0;
+    k1.lrow[1] ^= ALPHA_ROW1;
+#else
+    k1.row[0] ^= ALPHA_ROW0;
+    k1.row[1] ^= ALPHA_ROW1;
+    k1.row[2] ^= ALPHA_ROW2;
+    k1.row[3] ^= ALPHA_ROW3;
+#endif
+
+    /* Run the tweak schedule for the reverse rounds */
+    for (index = 0; index < ks->rounds; ++index) {
+        mantis_xor_cells(&(pt->schedule[ks->rounds + index]), &k1, &tk);
+        mantis_xor_rc(&(pt->schedule[ks->rounds + index]),
+                      ks->rounds - 1 - index);
+        mantis_update_tweak_inverse(&tk);
+    }
+
+    /* Determine the final whitening value */
+    mantis_xor_cells(&(pt->whiten_out), &(ks->k0prime), &k1);
+    mantis_xor_cells(&(pt->whiten_out), &(pt->whiten_out), &tk);
+    SKINNY_PROBE2(mantis_prepare_tweak, pt, size);
+    return 1;
+}
+
+void mantis_ecb_crypt_prepared
+    (void *output, const void *input, size_t count,
+     const MantisPreparedTweak_t *pt)
+{
+    uint8_t *out = (uint8_t *)output;
+    const uint8_t *in = (const uint8_t *)input;
+    const MantisCells_t *schedule;
+    MantisCells_t state;
+    unsigned index;
+
+    for (; count > 0; --count, in += MANTIS_BLOCK_SIZE,
+                               out += MANTIS_BLOCK_SIZE) {
+        /* Read the input buffer and convert little-endian to host-endian */
+#if SKINNY_64BIT && SKINNY_LITTLE_ENDIAN
+        state.llrow = READ_WORD64(in, 0);
+#elif SKINNY_LITTLE_ENDIAN
+        state.lrow[0] = READ_WORD32(in, 0);
+        state.lrow[1] = READ_WORD32(in, 4);
+#else
+        state.row[0] = READ_WORD16(in, 0);
+        state.row[1] = READ_WORD16(in, 2);
+        state.row[2] = READ_WORD16(in, 4);
+        state.row[3] = READ_WORD16(in, 6);
+#endif
+
+        /* XOR the initial whitening value with the state */
+        mantis_xor_cells(&state, &state, &(pt->whiten_in));
+
+        /* Perform all forward rounds */
+        schedule = pt->schedule;
+        for (index = pt->rounds; index > 0; --index, ++schedule) {
+#if SKINNY_64BIT
+            state.llrow = mantis_sbox(state.llrow);
+#else
+            state.lrow[0] = mantis_sbox(state.lrow[0]);
+            state.lrow[1] = mantis_sbox(state.lrow[1]);
+#endif
+            mantis_xor_cells(&state, &state, schedule);
+            mantis_shift_rows(&state);
+            mantis_mix_columns(&state);
+        }
+
+        /* Half-way there: sbox, mix, sbox */
+#if SKINNY_64BIT
+        state.llrow = mantis_sbox(state.llrow);
+        mantis_mix_columns(&state);
+        state.llrow = mantis_sbox(state.llrow);
+#else
+        state.lrow[0] = mantis_sbox(state.lrow[0]);
+        state.lrow[1] = mantis_sbox(state.lrow[1]);
+        mantis_mix_columns(&state);
+        state.lrow[0] = mantis_sbox(state.lrow[0]);
+        state.lrow[1] = mantis_sbox(state.lrow[1]);
+#endif
+
+        /* Perform all reverse rounds */
+        for (index = pt->rounds; index > 0; --index, ++schedule) {
+            mantis_mix_columns(&state);
+            mantis_shift_rows_inverse(&state);
+            mantis_xor_cells(&state, &state, schedule);
+#if SKINNY_64BIT
+            state.llrow = mantis_sbox(state.llrow);
+#else
+            state.lrow[0] = mantis_sbox(state.lrow[0]);
+            state.lrow[1] = mantis_sbox(state.lrow[1]);
+#endif
+        }
+
+        /* XOR the final whitening value with the state */
+        mantis_xor_cells(&state, &state, &(pt->whiten_out));
+
+        /* Convert host-endian back into little-endian in the output */
+#if SKINNY_64BIT && SKINNY_LITTLE_ENDIAN
+        WRITE_WORD64(out, 0, state.llrow);
+#elif SKINNY_LITTLE_ENDIAN
+        WRITE_WORD32(out, 0, state.lrow[0]);
+        WRITE_WORD32(out, 4, state.lrow[1]);
+#else
+        WRITE_WORD16(out, 0, state.row[0]);
+        WRITE_WORD16(out, 2, state.row[1]);
+        WRITE_WORD16(out, 4, state.row[2]);
+        WRITE_WORD16(out, 6, state.row[3]);
+#endif
+    }
+}
@@ -41,9 +41,12 @@ typedef struct
         (MantisCTR_t *ctr, const void *counter, unsigned size);
     int (*encrypt)
         (void *output, const void *input, size_t size, MantisCTR_t *ctr);
+    const char *name;
 
 } MantisCTRVtable_t;
 
 extern MantisCTRVtable_t const _mantis_ctr_vec128;
+extern MantisCTRVtable_t const _mantis_ctr_ssse3;
+extern MantisCTRVtable_t const _mantis_ctr_vec256;
 
 #endif /* MANTIS_CTR_INTERNAL_H */
@@ -154,6 +154,7 @@ static int mantis_ctr_vec128_set_counter
     } else {
         memset(block, 0, MANTIS_BLOCK_SIZE);
     }
+    SKINNY_STAT_ADD(ctr_discarded_bytes, MANTIS_CTR_BLOCK_SIZE - ctx->offset);
     ctx->offset = MANTIS_CTR_BLOCK_SIZE;
 
     /* Load the counter block and convert into row vectors */
@@ -334,8 +335,44 @@ static uint16_t const rc[MANTIS_MAX_ROUNDS][4] = {
     RC(0x9216D5D98979FB1BULL)
 };
 
-static void mantis_ecb_encrypt_eight
-    (void *output, const SkinnyVector8x16_t *input, const MantisKey_t *ks)
+#if SKINNY_VEC128_SSSE3
+
+/* Nibble lookup tables for the S-box, for use with PSHUFB */
+#define MANTIS_SBOX_LO \
+    _mm_setr_epi8(0x0C, 0x0A, 0x0D, 0x03, 0x0E, 0x0B, 0x0F, 0x07, \
+                  0x08, 0x09, 0x01, 0x05, 0x00, 0x02, 0x04, 0x06)
+#define MANTIS_SBOX_HI \
+    _mm_setr_epi8(0xC0, 0xA0, 0xD0, 0x30, 0xE0, 0xB0, 0xF0, 0x70, \
+                  0x80, 0x90, 0x10, 0x50, 0x00, 0x20, 0x40, 0x60)
+
+#endif /* SKINNY_VEC128_SSSE3 */
+
+/* Applies the S-box to all cells in the state */
+SKINNY_ALWAYS_INLINE void mantis_sbox_state
+    (MantisVectorCells_t *state, int ssse3)
+{
+#if SKINNY_VEC128_SSSE3
+    if (ssse3) {
+        const __m128i lo = MANTIS_SBOX_LO;
+        const __m128i hi = MANTIS_SBOX_HI;
+        state->row[0] = skinny_sbox4_vec128(state->row[0], lo, hi);
+        state->row[1] = skinny_sbox4_vec128(state->row[1], lo, hi);
+        state->row[2] = skinny_sbox4_vec128(state->row[2], lo, hi);
+        state->row[3] = skinny_sbox4_vec128(state->row[3], lo, hi);
+        return;
+    }
+#else
+    (void)ssse3;
+#endif
+    state->row[0] = mantis_sbox(state->row[0]);
+    state->row[1] = mantis_sbox(state->row[1]);
+    state->row[2] = mantis_sbox(state->row[2]);
+    state->row[3] = mantis_sbox(state->row[3]);
+}
+
+/* Encrypts eight blocks that have already been arranged into row vectors */
+SKINNY_ALWAYS_INLINE void mantis_encrypt_rows
+    (SkinnyVector8x16_t *rows, const MantisKey_t *ks, int ssse3)
 {
     const uint16_t *r = rc[0];
     MantisCells_t tweak = ks->tweak;
@@ -344,10 +381,10 @@ static void mantis_ecb_encrypt_eight
     unsigned index;
 
     /* Read the rows of all eight counter blocks into memory */
-    state.row[0] = input[0];
-    state.row[1] = input[1];
-    state.row[2] = input[2];
-    state.row[3] = input[3];
+    state.row[0] = rows[0];
+    state.row[1] = rows[1];
+    state.row[2] = rows[2];
+    state.row[3] = rows[3];
 
     /* XOR the initial whitening key k0 with the state,
        together with k1 and the initial tweak value */
@@ -362,10 +399,7 @@ static void mantis_ecb_encrypt_eight
         mantis_update_tweak(&tweak);
 
         /* Apply the S-box */
-        state.row[0] = mantis_sbox(state.row[0]);
-        state.row[1] = mantis_sbox(state.row[1]);
-        state.row[2] = mantis_sbox(state.row[2]);
-        state.row[3] = mantis_sbox(state.row[3]);
+        mantis_sbox_state(&state, ssse3);
 
         /* Add the round constant */
         state.row[0] ^= r[0];
@@ -388,15 +422,9 @@ static void mantis_ecb_encrypt_eight
     }
 
     /* Half-way there: sbox, mix, sbox */
-    state.row[0] = mantis_sbox(state.row[0]);
-    state.row[1] = mantis_sbox(state.row[1]);
-    state.row[2] = mantis_sbox(state.row[2]);
-    state.row[3] = mantis_sbox(state.row[3]);
+    mantis_sbox_state(&state, ssse3);
     mantis_mix_columns(&state);
-    state.row[0] = mantis_sbox(state.row[0]);
-    state.row[1] = mantis_sbox(state.row[1]);
-    state.row[2] = mantis_sbox(state.row[2]);
-    state.row[3] = mantis_sbox(state.row[3]);
+    mantis_sbox_state(&state, ssse3);
 
     /* Convert k1 into k1 XOR alpha for the reverse rounds */
     k1.row[0] ^= ALPHA_ROW0;
@@ -426,10 +454,7 @@ static void mantis_ecb_encrypt_eight
         state.row[3] ^= r[3];
 
         /* Apply the inverse S-box (which is the same as the forward S-box) */
-        state.row[0] = mantis_sbox(state.row[0]);
-        state.row[1] = mantis_sbox(state.row[1]);
-        state.row[2] = mantis_sbox(state.row[2]);
-        state.row[3] = mantis_sbox(state.row[3]);
+        mantis_sbox_state(&state, ssse3);
 
         /* Update the tweak with the reverse h function */
         mantis_update_tweak_inverse(&tweak);
@@ -442,69 +467,155 @@ static void mantis_ecb_encrypt_eight
     state.row[2] ^= ks->k0prime.row[2] ^ k1.row[2] ^ tweak.row[2];
     state.row[3] ^= ks->k0prime.row[3] ^ k1.row[3] ^ tweak.row[3];
 
+    /* Return the encrypted rows to the caller */
+    rows[0] = state.row[0];
+    rows[1] = state.row[1];
+    rows[2] = state.row[2];
+    rows[3] = state.row[3];
+}
+
+SKINNY_ALWAYS_INLINE void mantis_ecb_encrypt_eight
+    (void *output, const SkinnyVector8x16_t *input, const MantisKey_t *ks,
+     int ssse3)
+{
+    SkinnyVector8x16_t rows[4];
+
+    /* Encrypt the eight counter blocks */
+    rows[0] = input[0];
+    rows[1] = input[1];
+    rows[2] = input[2];
+    rows[3] = input[3];
+    mantis_encrypt_rows(rows, ks, ssse3);
+
     /* Write the rows of all eight blocks back to memory.
        Note: In this case, direct WRITE_WORD16() calls seem to give
        better performance than rearranging the vectors and performing
        an unaligned vector write */
 #if 0 /* SKINNY_LITTLE_ENDIAN && SKINNY_UNALIGNED */
     *((SkinnyVector8x16U_t *)output) =
-        (SkinnyVector8x16_t){state.row[0][0], state.row[1][0],
-                             state.row[2][0], state.row[3][0],
-                             state.row[0][1], state.row[1][1],
-                             state.row[2][1], state.row[3][1]};
+        (SkinnyVector8x16_t){rows[0][0], rows[1][0],
+                             rows[2][0], rows[3][0],
+                             rows[0][1], rows[1][1],
+                             rows[2][1], rows[3][1]};
     *((SkinnyVector8x16U_t *)(output + 16)) =
-        (SkinnyVector8x16_t){state.row[0][2], state.row[1][2],
-                             state.row[2][2], state.row[3][2],
-                             state.row[0][3], state.row[1][3],
-                             state.row[2][3], state.row[3][3]};
+        (SkinnyVector8x16_t){rows[0][2], rows[1][2],
+                             rows[2][2], rows[3][2],
+                             rows[0][3], rows[1][3],
+                             rows[2][3], rows[3][3]};
     *((SkinnyVector8x16U_t *)(output + 32)) =
-        (SkinnyVector8x16_t){state.row[0][4], state.row[1][4],
-                             state.row[2][4], state.row[3][4],
-                             state.row[0][5], state.row[1][5],
-                             state.row[2][5], state.row[3][5]};
+        (SkinnyVector8x16_t){rows[0][4], rows[1][4],
+                             rows[2][4], rows[3][4],
+                             rows[0][5], rows[1][5],
+                             rows[2][5], rows[3][5]};
     *((SkinnyVector8x16U_t *)(output + 48)) =
-        (SkinnyVector8x16_t){state.row[0][6], state.row[1][6],
-                             state.row[2][6], state.row[3][6],
-                             state.row[0][7], state.row[1][7],
-                             state.row[2][7], state.row[3][7]};
+        (SkinnyVector8x16_t){rows[0][6], rows[1][6],
+                             rows[2][6], rows[3][6],
+                             rows[0][7], rows[1][7],
+                             rows[2][7], rows[3][7]};
 #else
-    WRITE_WORD16(output,  0, state.row[0][0]);
-    WRITE_WORD16(output,  2, state.row[1][0]);
-    WRITE_WORD16(output,  4, state.row[2][0]);
-    WRITE_WORD16(output,  6, state.row[3][0]);
-    WRITE_WORD16(output,  8, state.row[0][1]);
-    WRITE_WORD16(output, 10, state.row[1][1]);
-    WRITE_WORD16(output, 12, state.row[2][1]);
-    WRITE_WORD16(output, 14, state.row[3][1]);
-    WRITE_WORD16(output, 16, state.row[0][2]);
-    WRITE_WORD16(output, 18, state.row[1][2]);
-    WRITE_WORD16(output, 20, state.row[2][2]);
-    WRITE_WORD16(output, 22, state.row[3][2]);
-    WRITE_WORD16(output, 24, state.row[0][3]);
-    WRITE_WORD16(output, 26, state.row[1][3]);
-    WRITE_WORD16(output, 28, state.row[2][3]);
-    WRITE_WORD16(output, 30, state.row[3][3]);
-    WRITE_WORD16(output, 32, state.row[0][4]);
-    WRITE_WORD16(output, 34, state.row[1][4]);
-    WRITE_WORD16(output, 36, state.row[2][4]);
-    WRITE_WORD16(output, 38, state.row[3][4]);
-    WRITE_WORD16(output, 40, state.row[0][5]);
-    WRITE_WORD16(output, 42, state.row[1][5]);
-    WRITE_WORD16(output, 44, state.row[2][5]);
-    WRITE_WORD16(output, 46, state.row[3][5]);
-    WRITE_WORD16(output, 48, state.row[0][6]);
-    WRITE_WORD16(output, 50, state.row[1][6]);
-    WRITE_WORD16(output, 52, state.row[2][6]);
-    WRITE_WORD16(output, 54, state.row[3][6]);
-    WRITE_WORD16(output, 56, state.row[0][7]);
-    WRITE_WORD16(output, 58, state.row[1][7]);
-    WRITE_WORD16(output, 60, state.row[2][7]);
-    WRITE_WORD16(output, 62, state.row[3][7]);
+    WRITE_WORD16(output,  0, rows[0][0]);
+    WRITE_WORD16(output,  2, rows[1][0]);
+    WRITE_WORD16(output,  4, rows[2][0]);
+    WRITE_WORD16(output,  6, rows[3][0]);
+    WRITE_WORD16(output,  8, rows[0][1]);
+    WRITE_WORD16(output, 10, rows[1][1]);
+    WRITE_WORD16(output, 12, rows[2][1]);
+    WRITE_WORD16(output, 14, rows[3][1]);
+    WRITE_WORD16(output, 16, rows[0][2]);
+    WRITE_WORD16(output, 18, rows[1][2]);
+    WRITE_WORD16(output, 20, rows[2][2]);
+    WRITE_WORD16(output, 22, rows[3][2]);
+    WRITE_WORD16(output, 24, rows[0][3]);
+    WRITE_WORD16(output, 26, rows[1][3]);
+    WRITE_WORD16(output, 28, rows[2][3]);
+    WRITE_WORD16(output, 30, rows[3][3]);
+    WRITE_WORD16(output, 32, rows[0][4]);
+    WRITE_WORD16(output, 34, rows[1][4]);
+    WRITE_WORD16(output, 36, rows[2][4]);
+    WRITE_WORD16(output, 38, rows[3][4]);
+    WRITE_WORD16(output, 40, rows[0][5]);
+    WRITE_WORD16(output, 42, rows[1][5]);
+    WRITE_WORD16(output, 44, rows[2][5]);
+    WRITE_WORD16(output, 46, rows[3][5]);
+    WRITE_WORD16(output, 48, rows[0][6]);
+    WRITE_WORD16(output, 50, rows[1][6]);
+    WRITE_WORD16(output, 52, rows[2][6]);
+    WRITE_WORD16(output, 54, rows[3][6]);
+    WRITE_WORD16(output, 56, rows[0][7]);
+    WRITE_WORD16(output, 58, rows[1][7]);
+    WRITE_WORD16(output, 60, rows[2][7]);
+    WRITE_WORD16(output, 62, rows[3][7]);
 #endif
 }
 
-static int mantis_ctr_vec128_encrypt
-    (void *output, const void *input, size_t size, MantisCTR_t *ctr)
+/* Encrypts eight counter blocks and XOR's the keystream directly with
+   eight blocks of input, without a round trip through ctx->ecounter */
+SKINNY_ALWAYS_INLINE void mantis_ctr_xor_eight
+    (void *output, const void *input, const SkinnyVector8x16_t *counter,
+     const MantisKey_t *ks, int ssse3)
+{
+    SkinnyVector8x16_t rows[4];
+#if SKINNY_LITTLE_ENDIAN && SKINNY_UNALIGNED
+    SkinnyVector8x16_t blocks[4];
+#endif
+
+    /* Encrypt the eight counter blocks */
+    rows[0] = counter[0];
+    rows[1] = counter[1];
+    rows[2] = counter[2];
+    rows[3] = counter[3];
+    mantis_encrypt_rows(rows, ks, ssse3);
+
+    /* Transpose the keystream back into blocks and XOR with the input */
+#if SKINNY_LITTLE_ENDIAN && SKINNY_UNALIGNED
+    skinny_transpose_8x16(blocks, rows[0], rows[1], rows[2], rows[3]);
+    *((SkinnyVector8x16U_t *)output) =
+        *((const SkinnyVector8x16U_t *)input) ^ blocks[0];
+    *((SkinnyVector8x16U_t *)(output + 16)) =
+        *((const SkinnyVector8x16U_t *)(input + 16)) ^ blocks[1];
+    *((SkinnyVector8x16U_t *)(output + 32)) =
+        *((const SkinnyVector8x16U_t *)(input + 32)) ^ blocks[2];
+    *((SkinnyVector8x16U_t *)(output + 48)) =
+        *((const SkinnyVector8x16U_t *)(input + 48)) ^ blocks[3];
+#else
+    skinny_xor_word16(output, input,  0, rows[0][0]);
+    skinny_xor_word16(output, input,  2, rows[1][0]);
+    skinny_xor_word16(output, input,  4, rows[2][0]);
+    skinny_xor_word16(output, input,  6, rows[3][0]);
+    skinny_xor_word16(output, input,  8, rows[0][1]);
+    skinny_xor_word16(output, input, 10, rows[1][1]);
+    skinny_xor_word16(output, input, 12, rows[2][1]);
+    skinny_xor_word16(output, input, 14, rows[3][1]);
+    skinny_xor_word16(output, input, 16, rows[0][2]);
+    skinny_xor_word16(output, input, 18, rows[1][2]);
+    skinny_xor_word16(output, input, 20, rows[2][2]);
+    skinny_xor_word16(output, input, 22, rows[3][2]);
+    skinny_xor_word16(output, input, 24, rows[0][3]);
+    skinny_xor_word16(output, input, 26, rows[1][3]);
+    skinny_xor_word16(output, input, 28, rows[2][3]);
+    skinny_xor_word16(output, input, 30, rows[3][3]);
+    skinny_xor_word16(output, input, 32, rows[0][4]);
+    skinny_xor_word16(output, input, 34, rows[1][4]);
+    skinny_xor_word16(output, input, 36, rows[2][4]);
+    skinny_xor_word16(output, input, 38, rows[3][4]);
+    skinny_xor_word16(output, input, 40, rows[0][5]);
+    skinny_xor_word16(output, input, 42, rows[1][5]);
+    skinny_xor_word16(output, input, 44, rows[2][5]);
+    skinny_xor_word16(output, input, 46, rows[3][5]);
+    skinny_xor_word16(output, input, 48, rows[0][6]);
+    skinny_xor_word16(output, input, 50, rows[1][6]);
+    skinny_xor_word16(output, input, 52, rows[2][6]);
+    skinny_xor_word16(output, input, 54, rows[3][6]);
+    skinny_xor_word16(output, input, 56, rows[0][7]);
+    skinny_xor_word16(output, input, 58, rows[1][7]);
+    skinny_xor_word16(output, input, 60, rows[2][7]);
+    skinny_xor_word16(output, input, 62, rows[3][7]);
+#endif
+}
+
+SKINNY_ALWAYS_INLINE int mantis_ctr_vec128_process
+    (void *output, const void *input, size_t size, MantisCTR_t *ctr,
+     int ssse3)
 {
     MantisCTRVec128Ctx_t *ctx;
     uint8_t *out = (uint8_t *)output;
@@ -521,7 +632,16 @@ static int mantis_ctr_vec128_encrypt
     while (size > 0) {
         if (ctx->offset >= MANTIS_CTR_BLOCK_SIZE) {
             /* We need a new keystream block */
-            mantis_ecb_encrypt_eight(ctx->ecounter, ctx->counter, &(ctx->ks));
+            if (size >= MANTIS_CTR_BLOCK_SIZE) {
+                /* XOR an entire keystream block in one go, keeping
+                   the keystream in registers rather than ecounter */
+                mantis_ctr_xor_eight
+                    (out, in, ctx->counter, &(ctx->ks), ssse3);
+            } else {
+                /* Last partial block in the request */
+                mantis_ecb_encrypt_eight
+                    (ctx->ecounter, ctx->counter, &(ctx->ks), ssse3);
+            }
             mantis_ctr_increment(ctx->counter, 0, 8);
             mantis_ctr_increment(ctx->counter, 1, 8);
             mantis_ctr_increment(ctx->counter, 2, 8);
@@ -530,36 +650,11 @@ static int mantis_ctr_vec128_encrypt
             mantis_ctr_increment(ctx->counter, 5, 8);
             mantis_ctr_increment(ctx->counter, 6, 8);
             mantis_ctr_increment(ctx->counter, 7, 8);
-
-            /* XOR an entire keystream block in one go if possible */
             if (size >= MANTIS_CTR_BLOCK_SIZE) {
-                skinny64_xor(out, in, ctx->ecounter);
-                skinny64_xor(out + MANTIS_BLOCK_SIZE,
-                             in + MANTIS_BLOCK_SIZE,
-                             ctx->ecounter + MANTIS_BLOCK_SIZE);
-                skinny64_xor(out + MANTIS_BLOCK_SIZE * 2,
-                             in + MANTIS_BLOCK_SIZE * 2,
-                             ctx->ecounter + MANTIS_BLOCK_SIZE * 2);
-                skinny64_xor(out + MANTIS_BLOCK_SIZE * 3,
-                             in + MANTIS_BLOCK_SIZE * 3,
-                             ctx->ecounter + MANTIS_BLOCK_SIZE * 3);
-                skinny64_xor(out + MANTIS_BLOCK_SIZE * 4,
-                             in + MANTIS_BLOCK_SIZE * 4,
-                             ctx->ecounter + MANTIS_BLOCK_SIZE * 4);
-                skinny64_xor(out + MANTIS_BLOCK_SIZE * 5,
-                             in + MANTIS_BLOCK_SIZE * 5,
-                             ctx->ecounter + MANTIS_BLOCK_SIZE * 5);
-                skinny64_xor(out + MANTIS_BLOCK_SIZE * 6,
-                             in + MANTIS_BLOCK_SIZE * 6,
-                             ctx->ecounter + MANTIS_BLOCK_SIZE * 6);
-                skinny64_xor(out + MANTIS_BLOCK_SIZE * 7,
-                             in + MANTIS_BLOCK_SIZE * 7,
-                             ctx->ecounter + MANTIS_BLOCK_SIZE * 7);
                 out += MANTIS_CTR_BLOCK_SIZE;
                 in += MANTIS_CTR_BLOCK_SIZE;
                 size -= MANTIS_CTR_BLOCK_SIZE;
             } else {
-                /* Last partial block in the request */
                 skinny_xor(out, in, ctx->ecounter, size);
                 ctx->offset = size;
                 break;
@@ -579,6 +674,12 @@ static int mantis_ctr_vec128_encrypt
     return 1;
 }
 
+static int mantis_ctr_vec128_encrypt
+    (void *output, const void *input, size_t size, MantisCTR_t *ctr)
+{
+    return mantis_ctr_vec128_process(output, input, size, ctr, 0);
+}
+
 /** Vtable for the 128-bit SIMD Mantis-CTR implementation */
 MantisCTRVtable_t const _mantis_ctr_vec128 = {
     mantis_ctr_vec128_init,
@@ -586,12 +687,41 @@ MantisCTRVtable_t const _mantis_ctr_vec128 = {
     mantis_ctr_vec128_set_key,
     mantis_ctr_vec128_set_tweak,
     mantis_ctr_vec128_set_counter,
-    mantis_ctr_vec128_encrypt
+    mantis_ctr_vec128_encrypt,
+    "vec128"
+};
+
+#if SKINNY_VEC128_SSSE3
+
+SKINNY_TARGET_SSSE3 static int mantis_ctr_ssse3_encrypt
+    (void *output, const void *input, size_t size, MantisCTR_t *ctr)
+{
+    return mantis_ctr_vec128_process(output, input, size, ctr, 1);
+}
+
+/** Vtable for the SSSE3 Mantis-CTR implementation */
+MantisCTRVtable_t const _mantis_ctr_ssse3 = {
+    mantis_ctr_vec128_init,
+    mantis_ctr_vec128_cleanup,
+    mantis_ctr_vec128_set_key,
+    mantis_ctr_vec128_set_tweak,
+    mantis_ctr_vec128_set_counter,
+    mantis_ctr_ssse3_encrypt,
+    "ssse3"
 };
 
+#endif /* SKINNY_VEC128_SSSE3 */
+
 #else /* !SKINNY_VEC128_MATH */
 
 /* Stubbed out */
 MantisCTRVtable_t const _mantis_ctr_vec128;
 
 #endif /* SKINNY_VEC128_MATH */
+
+#if !SKINNY_VEC128_SSSE3
+
+/* Stubbed out */
+MantisCTRVtable_t const _mantis_ctr_ssse3;
+
+#endif /* !SKINNY_VEC128_SSSE3 */
@@ -0,0 +1,586 @@
+/*
+ * Copyright (C) 2017 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#define SKINNY_TARGET_VEC256 1
+
+#include "mantis-cipher.h"
+#include "mantis-ctr-internal.h"
+#include "skinny-internal.h"
+#include <stdlib.h>
+
+#if SKINNY_VEC256_MATH
+
+/* This implementation encrypts sixteen blocks at a time */
+#define MANTIS_CTR_BLOCK_SIZE (MANTIS_BLOCK_SIZE * 16)
+
+/** Internal state information for Mantis in CTR mode */
+typedef struct
+{
+    /** Key schedule for Mantis */
+    MantisKey_t ks;
+
+    /** Counter values for the next block, pre-formatted into row vectors */
+    SkinnyVector16x16_t counter[4];
+
+    /** Encrypted counter value for encrypting the current block */
+    unsigned char ecounter[MANTIS_CTR_BLOCK_SIZE];
+
+    /** Offset into ecounter where the previous request left off */
+    unsigned offset;
+
+    /** Base pointer for unaligned memory allocation */
+    void *base_ptr;
+
+} MantisCTRVec256Ctx_t;
+
+static int mantis_ctr_vec256_init(MantisCTR_t *ctr)
+{
+    MantisCTRVec256Ctx_t *ctx;
+    void *base_ptr;
+    if ((ctx = skinny_calloc(sizeof(MantisCTRVec256Ctx_t), &base_ptr)) == NULL)
+        return 0;
+    ctx->base_ptr = base_ptr;
+    ctx->offset = MANTIS_CTR_BLOCK_SIZE;
+    ctr->ctx = ctx;
+    return 1;
+}
+
+static void mantis_ctr_vec256_cleanup(MantisCTR_t *ctr)
+{
+    if (ctr->ctx) {
+        MantisCTRVec256Ctx_t *ctx = ctr->ctx;
+        void *base_ptr = ctx->base_ptr;
+        skinny_cleanse(ctx, sizeof(MantisCTRVec256Ctx_t));
+        free(base_ptr);
+        ctr->ctx = 0;
+    }
+}
+
+static int mantis_ctr_vec256_set_key
+    (MantisCTR_t *ctr, const void *key, unsigned size, unsigned rounds)
+{
+    MantisCTRVec256Ctx_t *ctx;
+
+    /* Validate the parameters */
+    if (!key)
+        return 0;
+    ctx = ctr->ctx;
+    if (!ctx)
+        return 0;
+
+    /* Populate the underlying key schedule */
+    if (!mantis_set_key(&(ctx->ks), key, size, rounds, MANTIS_ENCRYPT))
+        return 0;
+
+    /* Reset the keystream */
+    ctx->offset = MANTIS_CTR_BLOCK_SIZE;
+    return 1;
+}
+
+static int mantis_ctr_vec256_set_tweak
+    (MantisCTR_t *ctr, const void *tweak, unsigned tweak_size)
+{
+    MantisCTRVec256Ctx_t *ctx;
+
+    /* Validate the parameters */
+    ctx = ctr->ctx;
+    if (!ctx)
+        return 0;
+
+    /* Populate the underlying tweak */
+    if (!mantis_set_tweak(&(ctx->ks), tweak, tweak_size))
+        return 0;
+
+    /* Reset the keystream */
+    ctx->offset = MANTIS_CTR_BLOCK_SIZE;
+    return 1;
+}
+
+/* Increment a specific column in an array of row vectors */
+STATIC_INLINE void mantis_ctr_increment
+    (SkinnyVector16x16_t *counter, unsigned column, unsigned inc)
+{
+    uint8_t *ctr = ((uint8_t *)counter) + column * 2;
+    uint8_t *ptr;
+    unsigned index;
+    for (index = 8; index > 0; ) {
+        --index;
+        ptr = ctr + (index & 0x06) * 16;
+#if SKINNY_LITTLE_ENDIAN
+        ptr += index & 0x01;
+#else
+        ptr += 1 - (index & 0x01);
+#endif
+        inc += ptr[0];
+        ptr[0] = (uint8_t)inc;
+        inc >>= 8;
+    }
+}
+
+/* Increment all sixteen columns of the row vectors at once.  The counter
+   is big-endian, so each 16-bit cell is byte-swapped to make it a number */
+STATIC_INLINE void mantis_ctr_increment_all
+    (SkinnyVector16x16_t *counter, uint16_t inc)
+{
+    SkinnyVector16x16_t row0 = (counter[0] << 8) | (counter[0] >> 8);
+    SkinnyVector16x16_t row1 = (counter[1] << 8) | (counter[1] >> 8);
+    SkinnyVector16x16_t row2 = (counter[2] << 8) | (counter[2] >> 8);
+    SkinnyVector16x16_t row3 = (counter[3] << 8) | (counter[3] >> 8);
+    SkinnyVector16x16_t carry;
+
+    /* Add to the least significant row and ripple the carries upwards.
+       Comparison results are all-ones masks, so subtracting adds one */
+    row3 += inc;
+    carry = (SkinnyVector16x16_t)(row3 < inc);
+    row2 -= carry;
+    carry &= (SkinnyVector16x16_t)(row2 == 0);
+    row1 -= carry;
+    carry &= (SkinnyVector16x16_t)(row1 == 0);
+    row0 -= carry;
+
+    /* Swap the bytes back into big-endian order */
+    counter[0] = (row0 << 8) | (row0 >> 8);
+    counter[1] = (row1 << 8) | (row1 >> 8);
+    counter[2] = (row2 << 8) | (row2 >> 8);
+    counter[3] = (row3 << 8) | (row3 >> 8);
+}
+
+static int mantis_ctr_vec256_set_counter
+    (MantisCTR_t *ctr, const void *counter, unsigned size)
+{
+    MantisCTRVec256Ctx_t *ctx;
+    unsigned char block[MANTIS_BLOCK_SIZE];
+    unsigned column;
+
+    /* Validate the parameters */
+    if (size > MANTIS_BLOCK_SIZE)
+        return 0;
+    ctx = ctr->ctx;
+    if (!ctx)
+        return 0;
+
+    /* Set the counter and reset the keystream to a block boundary */
+    if (counter) {
+        memset(block, 0, MANTIS_BLOCK_SIZE - size);
+        memcpy(block + MANTIS_BLOCK_SIZE - size, counter, size);
+    } else {
+        memset(block, 0, MANTIS_BLOCK_SIZE);
+    }
+    SKINNY_STAT_ADD(ctr_discarded_bytes, MANTIS_CTR_BLOCK_SIZE - ctx->offset);
+    ctx->offset = MANTIS_CTR_BLOCK_SIZE;
+
+    /* Load the counter block and convert into row vectors */
+    ctx->counter[0] = skinny_to_vec16x16(READ_WORD16(block, 0));
+    ctx->counter[1] = skinny_to_vec16x16(READ_WORD16(block, 2));
+    ctx->counter[2] = skinny_to_vec16x16(READ_WORD16(block, 4));
+    ctx->counter[3] = skinny_to_vec16x16(READ_WORD16(block, 6));
+
+    /* Increment the second through sixteenth columns of each row vector */
+    for (column = 1; column < 16; ++column)
+        mantis_ctr_increment(ctx->counter, column, column);
+
+    /* Clean up and exit */
+    skinny_cleanse(block, sizeof(block));
+    return 1;
+}
+
+/**
+ * \brief All cells in a Mantis 16-way block.
+ */
+typedef union
+{
+    SkinnyVector16x16_t row[4];
+
+} MantisVectorCells_t;
+
+STATIC_INLINE void mantis_update_tweak(MantisCells_t *tweak)
+{
+    /* h = [6, 5, 14, 15, 0, 1, 2, 3, 7, 12, 13, 4, 8, 9, 10, 11] */
+    uint16_t row1 = tweak->row[1];
+    uint16_t row3 = tweak->row[3];
+    tweak->row[1] = tweak->row[0];
+    tweak->row[3] = tweak->row[2];
+    tweak->row[0] = ((row1 >>  8) & 0x00F0U) |
+                     (row1        & 0x000FU) |
+                     (row3        & 0xFF00U);
+    tweak->row[2] = ((row1 <<  4) & 0x0F00U) |
+                    ((row1 >>  4) & 0x00F0U) |
+                    ((row3 >>  4) & 0x000FU) |
+                    ((row3 << 12) & 0xF000U);
+}
+
+STATIC_INLINE void mantis_update_tweak_inverse(MantisCells_t *tweak)
+{
+    /* h' = [4, 5, 6, 7, 11, 1, 0, 8, 12, 13, 14, 15, 9, 10, 2, 3] */
+    uint16_t row0 = tweak->row[0];
+    uint16_t row2 = tweak->row[2];
+    tweak->row[0] = tweak->row[1];
+    tweak->row[2] = tweak->row[3];
+    tweak->row[1] = ((row2 >>  4) & 0x00F0U) |
+                    ((row2 <<  4) & 0x0F00U) |
+                     (row0        & 0x000FU) |
+                    ((row0 <<  8) & 0xF000U);
+    tweak->row[3] =  (row0        & 0xFF00U) |
+                    ((row2 <<  4) & 0x00F0U) |
+                    ((row2 >> 12) & 0x000FU);
+}
+
+STATIC_INLINE void mantis_shift_rows(MantisVectorCells_t *state)
+{
+    /* P = [0, 11, 6, 13, 10, 1, 12, 7, 5, 14, 3, 8, 15, 4, 9, 2] */
+    SkinnyVector16x16_t row0 = state->row[0];
+    SkinnyVector16x16_t row1 = state->row[1];
+    SkinnyVector16x16_t row2 = state->row[2];
+    SkinnyVector16x16_t row3 = state->row[3];
+    state->row[0] =  (row0        & 0x00F0U) |
+                     (row1        & 0xF000U) |
+                    ((row2 >>  8) & 0x000FU) |
+                    ((row3 <<  8) & 0x0F00U);
+    state->row[1] =  (row0        & 0x000FU) |
+                     (row1        & 0x0F00U) |
+                    ((row2 >>  8) & 0x00F0U) |
+                    ((row3 <<  8) & 0xF000U);
+    state->row[2] = ((row0 <<  4) & 0xF000U) |
+                    ((row1 <<  4) & 0x00F0U) |
+                    ((row2 <<  4) & 0x0F00U) |
+                    ((row3 >> 12) & 0x000FU);
+    state->row[3] = ((row0 >>  4) & 0x0F00U) |
+                    ((row1 >>  4) & 0x000FU) |
+                    ((row2 << 12) & 0xF000U) |
+                    ((row3 >>  4) & 0x00F0U);
+}
+
+STATIC_INLINE void mantis_shift_rows_inverse(MantisVectorCells_t *state)
+{
+    /* P' = [0, 5, 15, 10, 13, 8, 2, 7, 11, 14, 4, 1, 6, 3, 9, 12] */
+    SkinnyVector16x16_t row0 = state->row[0];
+    SkinnyVector16x16_t row1 = state->row[1];
+    SkinnyVector16x16_t row2 = state->row[2];
+    SkinnyVector16x16_t row3 = state->row[3];
+    state->row[0] =  (row0        & 0x00F0U) |
+                     (row1        & 0x000FU) |
+                    ((row2 >>  4) & 0x0F00U) |
+                    ((row3 <<  4) & 0xF000U);
+    state->row[1] =  (row0        & 0xF000U) |
+                     (row1        & 0x0F00U) |
+                    ((row2 >>  4) & 0x000FU) |
+                    ((row3 <<  4) & 0x00F0U);
+    state->row[2] = ((row0 <<  8) & 0x0F00U) |
+                    ((row1 <<  8) & 0xF000U) |
+                    ((row2 >>  4) & 0x00F0U) |
+                    ((row3 >> 12) & 0x000FU);
+    state->row[3] = ((row0 >>  8) & 0x000FU) |
+                    ((row1 >>  8) & 0x00F0U) |
+                    ((row2 << 12) & 0xF000U) |
+                    ((row3 <<  4) & 0x0F00U);
+}
+
+STATIC_INLINE void mantis_mix_columns(MantisVectorCells_t *state)
+{
+    SkinnyVector16x16_t t0 = state->row[0];
+    SkinnyVector16x16_t t1 = state->row[1];
+    SkinnyVector16x16_t t2 = state->row[2];
+    SkinnyVector16x16_t t3 = state->row[3];
+    state->row[0] = t1 ^ t2 ^ t3;
+    state->row[1] = t0 ^ t2 ^ t3;
+    state->row[2] = t0 ^ t1 ^ t3;
+    state->row[3] = t0 ^ t1 ^ t2;
+}
+
+/* Extract the 16 bits for a row from a 64-bit round constant */
+#define RC_EXTRACT_ROW(x,shift) \
+    (((((uint16_t)((x) >> ((shift) + 8))) & 0xFF)) | \
+     ((((uint16_t)((x) >> ((shift))))     & 0xFF) << 8))
+
+/* Extract the rows from a 64-bit round constant */
+#define RC(x)    \
+    {RC_EXTRACT_ROW((x), 48), RC_EXTRACT_ROW((x), 32), \
+     RC_EXTRACT_ROW((x), 16), RC_EXTRACT_ROW((x), 0)}
+
+/* Alpha constant for adjusting k1 for the inverse rounds */
+#define ALPHA      0x243F6A8885A308D3ULL
+#define ALPHA_ROW0 (RC_EXTRACT_ROW(ALPHA, 48))
+#define ALPHA_ROW1 (RC_EXTRACT_ROW(ALPHA, 32))
+#define ALPHA_ROW2 (RC_EXTRACT_ROW(ALPHA, 16))
+#define ALPHA_ROW3 (RC_EXTRACT_ROW(ALPHA, 0))
+
+/* Round constants for Mantis, split up into 16-bit row values */
+static uint16_t const rc[MANTIS_MAX_ROUNDS][4] = {
+    RC(0x13198A2E03707344ULL),
+    RC(0xA4093822299F31D0ULL),
+    RC(0x082EFA98EC4E6C89ULL),
+    RC(0x452821E638D01377ULL),
+    RC(0xBE5466CF34E90C6CULL),
+    RC(0xC0AC29B7C97C50DDULL),
+    RC(0x3F84D5B5B5470917ULL),
+    RC(0x9216D5D98979FB1BULL)
+};
+
+/* Nibble lookup tables for the S-box, for use with VPSHUFB */
+#define MANTIS_SBOX_LO \
+    _mm256_setr_epi8(0x0C, 0x0A, 0x0D, 0x03, 0x0E, 0x0B, 0x0F, 0x07, \
+                     0x08, 0x09, 0x01, 0x05, 0x00, 0x02, 0x04, 0x06, \
+                     0x0C, 0x0A, 0x0D, 0x03, 0x0E, 0x0B, 0x0F, 0x07, \
+                     0x08, 0x09, 0x01, 0x05, 0x00, 0x02, 0x04, 0x06)
+#define MANTIS_SBOX_HI \
+    _mm256_setr_epi8(0xC0, 0xA0, 0xD0, 0x30, 0xE0, 0xB0, 0xF0, 0x70, \
+                     0x80, 0x90, 0x10, 0x50, 0x00, 0x20, 0x40, 0x60, \
+                     0xC0, 0xA0, 0xD0, 0x30, 0xE0, 0xB0, 0xF0, 0x70, \
+                     0x80, 0x90, 0x10, 0x50, 0x00, 0x20, 0x40, 0x60)
+
+/* Applies the S-box to all cells in the state */
+STATIC_INLINE void mantis_sbox_state(MantisVectorCells_t *state)
+{
+    const __m256i lo = MANTIS_SBOX_LO;
+    const __m256i hi = MANTIS_SBOX_HI;
+    state->row[0] = skinny_sbox4_vec256(state->row[0], lo, hi);
+    state->row[1] = skinny_sbox4_vec256(state->row[1], lo, hi);
+    state->row[2] = skinny_sbox4_vec256(state->row[2], lo, hi);
+    state->row[3] = skinny_sbox4_vec256(state->row[3], lo, hi);
+}
+
+/* Encrypts sixteen blocks that have already been arranged into row vectors */
+STATIC_INLINE void mantis_encrypt_rows
+    (SkinnyVector16x16_t *rows, const MantisKey_t *ks)
+{
+    const uint16_t *r = rc[0];
+    MantisCells_t tweak = ks->tweak;
+    MantisCells_t k1 = ks->k1;
+    MantisVectorCells_t state;
+    unsigned index;
+
+    /* Read the rows of all sixteen counter blocks into memory */
+    state.row[0] = rows[0];
+    state.row[1] = rows[1];
+    state.row[2] = rows[2];
+    state.row[3] = rows[3];
+
+    /* XOR the initial whitening key k0 with the state,
+       together with k1 and the initial tweak value */
+    state.row[0] ^= ks->k0.row[0] ^ k1.row[0] ^ tweak.row[0];
+    state.row[1] ^= ks->k0.row[1] ^ k1.row[1] ^ tweak.row[1];
+    state.row[2] ^= ks->k0.row[2] ^ k1.row[2] ^ tweak.row[2];
+    state.row[3] ^= ks->k0.row[3] ^ k1.row[3] ^ tweak.row[3];
+
+    /* Perform all forward rounds */
+    for (index = ks->rounds; index > 0; --index) {
+        /* Update the tweak with the forward h function */
+        mantis_update_tweak(&tweak);
+
+        /* Apply the S-box */
+        mantis_sbox_state(&state);
+
+        /* Add the round constant */
+        state.row[0] ^= r[0];
+        state.row[1] ^= r[1];
+        state.row[2] ^= r[2];
+        state.row[3] ^= r[3];
+        r += 4;
+
+        /* XOR with the key and tweak */
+        state.row[0] ^= k1.row[0] ^ tweak.row[0];
+        state.row[1] ^= k1.row[1] ^ tweak.row[1];
+        state.row[2] ^= k1.row[2] ^ tweak.row[2];
+        state.row[3] ^= k1.row[3] ^ tweak.row[3];
+
+        /* Shift the rows */
+        mantis_shift_rows(&state);
+
+        /* Mix the columns */
+        mantis_mix_columns(&state);
+    }
+
+    /* Half-way there: sbox, mix, sbox */
+    mantis_sbox_state(&state);
+    mantis_mix_columns(&state);
+    mantis_sbox_state(&state);
+
+    /* Convert k1 into k1 XOR alpha for the reverse rounds */
+    k1.row[0] ^= ALPHA_ROW0;
+    k1.row[1] ^= ALPHA_ROW1;
+    k1.row[2] ^= ALPHA_ROW2;
+    k1.row[3] ^= ALPHA_ROW3;
+
+    /* Perform all reverse rounds */
+    for (index = ks->rounds; index > 0; --index) {
+        /* Inverse mix of the columns (same as the forward mix) */
+        mantis_mix_columns(&state);
+
+        /* Inverse shift of the rows */
+        mantis_shift_rows_inverse(&state);
+
+        /* XOR with the key and tweak */
+        state.row[0] ^= k1.row[0] ^ tweak.row[0];
+        state.row[1] ^= k1.row[1] ^ tweak.row[1];
+        state.row[2] ^= k1.row[2] ^ tweak.row[2];
+        state.row[3] ^= k1.row[3] ^ tweak.row[3];
+
+        /* Add the round constant */
+        r -= 4;
+        state.row[0] ^= r[0];
+        state.row[1] ^= r[1];
+        state.row[2] ^= r[2];
+        state.row[3] ^= r[3];
+
+        /* Apply the inverse S-box (which is the same as the forward S-box) */
+        mantis_sbox_state(&state);
+
+        /* Update the tweak with the reverse h function */
+        mantis_update_tweak_inverse(&tweak);
+    }
+
+    /* XOR the final whitening key k0prime with the state,
+       together with k1alpha and the final tweak value */
+    state.row[0] ^= ks->k0prime.row[0] ^ k1.row[0] ^ tweak.row[0];
+    state.row[1] ^= ks->k0prime.row[1] ^ k1.row[1] ^ tweak.row[1];
+    state.row[2] ^= ks->k0prime.row[2] ^ k1.row[2] ^ tweak.row[2];
+    state.row[3] ^= ks->k0prime.row[3] ^ k1.row[3] ^ tweak.row[3];
+
+    /* Return the encrypted rows to the caller */
+    rows[0] = state.row[0];
+    rows[1] = state.row[1];
+    rows[2] = state.row[2];
+    rows[3] = state.row[3];
+}
+
+static void mantis_ecb_encrypt_sixteen
+    (void *output, const SkinnyVector16x16_t *input, const MantisKey_t *ks)
+{
+    SkinnyVector16x16_t rows[4];
+    SkinnyVector16x16_t blocks[4];
+
+    /* Encrypt the sixteen counter blocks */
+    rows[0] = input[0];
+    rows[1] = input[1];
+    rows[2] = input[2];
+    rows[3] = input[3];
+    mantis_encrypt_rows(rows, ks);
+
+    /* Write the rows of all sixteen blocks back to memory */
+    skinny_transpose_16x16(blocks, rows[0], rows[1], rows[2], rows[3]);
+    _mm256_storeu_si256((__m256i *)output, (__m256i)blocks[0]);
+    _mm256_storeu_si256(((__m256i *)output) + 1, (__m256i)blocks[1]);
+    _mm256_storeu_si256(((__m256i *)output) + 2, (__m256i)blocks[2]);
+    _mm256_storeu_si256(((__m256i *)output) + 3, (__m256i)blocks[3]);
+}
+
+/* Encrypts sixteen counter blocks and XOR's the keystream directly with
+   sixteen blocks of input, without a round trip through ctx->ecounter */
+static void mantis_ctr_xor_sixteen
+    (void *output, const void *input, const SkinnyVector16x16_t *counter,
+     const MantisKey_t *ks)
+{
+    SkinnyVector16x16_t rows[4];
+    SkinnyVector16x16_t blocks[4];
+    const __m256i *in = (const __m256i *)input;
+    __m256i *out = (__m256i *)output;
+
+    /* Encrypt the sixteen counter blocks */
+    rows[0] = counter[0];
+    rows[1] = counter[1];
+    rows[2] = counter[2];
+    rows[3] = counter[3];
+    mantis_encrypt_rows(rows, ks);
+
+    /* Transpose the keystream back into blocks and XOR with the input */
+    skinny_transpose_16x16(blocks, rows[0], rows[1], rows[2], rows[3]);
+    _mm256_storeu_si256(out, _mm256_xor_si256
+        (_mm256_loadu_si256(in), (__m256i)blocks[0]));
+    _mm256_storeu_si256(out + 1, _mm256_xor_si256
+        (_mm256_loadu_si256(in + 1), (__m256i)blocks[1]));
+    _mm256_storeu_si256(out + 2, _mm256_xor_si256
+        (_mm256_loadu_si256(in + 2), (__m256i)blocks[2]));
+    _mm256_storeu_si256(out + 3, _mm256_xor_si256
+        (_mm256_loadu_si256(in + 3), (__m256i)blocks[3]));
+}
+
+static int mantis_ctr_vec256_encrypt
+    (void *output, const void *input, size_t size, MantisCTR_t *ctr)
+{
+    MantisCTRVec256Ctx_t *ctx;
+    uint8_t *out = (uint8_t *)output;
+    const uint8_t *in = (const uint8_t *)input;
+
+    /* Validate the parameters */
+    if (!output || !input)
+        return 0;
+    ctx = ctr->ctx;
+    if (!ctx)
+        return 0;
+
+    /* Encrypt the input in CTR mode to create the output */
+    while (size > 0) {
+        if (ctx->offset >= MANTIS_CTR_BLOCK_SIZE) {
+            /* We need a new keystream block */
+            if (size >= MANTIS_CTR_BLOCK_SIZE) {
+                /* XOR an entire keystream block in one go, keeping
+                   the keystream in registers rather than ecounter */
+                mantis_ctr_xor_sixteen(out, in, ctx->counter, &(ctx->ks));
+            } else {
+                /* Last partial block in the request */
+                mantis_ecb_encrypt_sixteen
+                    (ctx->ecounter, ctx->counter, &(ctx->ks));
+            }
+            mantis_ctr_increment_all(ctx->counter, 16);
+            if (size >= MANTIS_CTR_BLOCK_SIZE) {
+                out += MANTIS_CTR_BLOCK_SIZE;
+                in += MANTIS_CTR_BLOCK_SIZE;
+                size -= MANTIS_CTR_BLOCK_SIZE;
+            } else {
+                skinny_xor(out, in, ctx->ecounter, size);
+                ctx->offset = size;
+                break;
+            }
+        } else {
+            /* Left-over keystream data from the last request */
+            size_t temp = MANTIS_CTR_BLOCK_SIZE - ctx->offset;
+            if (temp > size)
+                temp = size;
+            skinny_xor(out, in, ctx->ecounter + ctx->offset, temp);
+            ctx->offset += temp;
+            out += temp;
+            in += temp;
+            size -= temp;
+        }
+    }
+    return 1;
+}
+
+/** Vtable for the 256-bit SIMD Mantis-CTR implementation */
+MantisCTRVtable_t const _mantis_ctr_vec256 = {
+    mantis_ctr_vec256_init,
+    mantis_ctr_vec256_cleanup,
+    mantis_ctr_vec256_set_key,
+    mantis_ctr_vec256_set_tweak,
+    mantis_ctr_vec256_set_counter,
+    mantis_ctr_vec256_encrypt,
+    "vec256"
+};
+
+#else /* !SKINNY_VEC256_MATH */
+
+/* Stubbed out */
+MantisCTRVtable_t const _mantis_ctr_vec256;
+
+#endif /* SKINNY_VEC256_MATH */
+
+SKINNY_TARGET_END
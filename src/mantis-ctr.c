@@ -120,6 +120,7 @@ static int mantis_ctr_def_set_counter
     } else {
         memset(ctx->counter, 0, MANTIS_BLOCK_SIZE);
     }
+    SKINNY_STAT_ADD(ctr_discarded_bytes, MANTIS_BLOCK_SIZE - ctx->offset);
     ctx->offset = MANTIS_BLOCK_SIZE;
     return 1;
 }
@@ -179,13 +180,33 @@ static MantisCTRVtable_t const mantis_ctr_def = {
     mantis_ctr_def_set_key,
     mantis_ctr_def_set_tweak,
     mantis_ctr_def_set_counter,
-    mantis_ctr_def_encrypt
+    mantis_ctr_def_encrypt,
+    "default"
 };
 
+/* Lists the back ends that are usable on this platform, in increasing
+   order of preference */
+static unsigned mantis_ctr_backends(const MantisCTRVtable_t **list)
+{
+    unsigned count = 0;
+    list[count++] = &mantis_ctr_def;
+    if (_skinny_has_vec128())
+        list[count++] = &_mantis_ctr_vec128;
+    if (_skinny_has_vec128_ssse3())
+        list[count++] = &_mantis_ctr_ssse3;
+    if (_skinny_has_vec256())
+        list[count++] = &_mantis_ctr_vec256;
+    return count;
+}
+
+/* Back end that was chosen by the autotuner, or NULL if not tuned */
+static const MantisCTRVtable_t *mantis_ctr_tuned = 0;
+
 /* Public API, which redirects to the specific backend implementation */
 
 int mantis_ctr_init(MantisCTR_t *ctr)
 {
+    const MantisCTRVtable_t *list[SKINNY_AUTOTUNE_MAX_BACKENDS];
     const MantisCTRVtable_t *vtable;
 
     /* Validate the parameter */
@@ -193,24 +214,38 @@ int mantis_ctr_init(MantisCTR_t *ctr)
         return 0;
 
     /* Choose a backend implementation */
-    vtable = &mantis_ctr_def;
-    if (_skinny_has_vec128())
-        vtable = &_mantis_ctr_vec128;
+    vtable = mantis_ctr_tuned;
+    if (!vtable)
+        vtable = list[mantis_ctr_backends(list) - 1];
     ctr->vtable = vtable;
 
     /* Initialize the CTR mode context */
-    return (*(vtable->init))(ctr);
+    if (!(*(vtable->init))(ctr))
+        return 0;
+    SKINNY_STAT_ADD(context_allocs, 1);
+    SKINNY_PROBE2(mantis_ctr_init, ctr, vtable->name);
+    return 1;
 }
 
 void mantis_ctr_cleanup(MantisCTR_t *ctr)
 {
     if (ctr && ctr->vtable) {
         const MantisCTRVtable_t *vtable = ctr->vtable;
+        SKINNY_PROBE1(mantis_ctr_cleanup, ctr);
         (*(vtable->cleanup))(ctr);
         ctr->vtable = 0;
     }
 }
 
+const char *mantis_ctr_backend_name(const MantisCTR_t *ctr)
+{
+    if (ctr && ctr->vtable) {
+        const MantisCTRVtable_t *vtable = ctr->vtable;
+        return vtable->name;
+    }
+    return 0;
+}
+
 int mantis_ctr_set_key
     (MantisCTR_t *ctr, const void *key, unsigned size, unsigned rounds)
 {
@@ -246,7 +281,79 @@ int mantis_ctr_encrypt
 {
     if (ctr && ctr->vtable) {
         const MantisCTRVtable_t *vtable = ctr->vtable;
-        return (*(vtable->encrypt))(output, input, size, ctr);
+        int result;
+        SKINNY_PROBE3(mantis_ctr_encrypt_start, ctr, size, vtable->name);
+        result = (*(vtable->encrypt))(output, input, size, ctr);
+        SKINNY_PROBE2(mantis_ctr_encrypt_done, ctr, size);
+        return result;
     }
     return 0;
 }
+
+/** @cond */
+
+/**
+ * \brief State for timing a CTR back end with the autotuner.
+ */
+typedef struct
+{
+    MantisCTR_t ctr;
+    unsigned char data[SKINNY_AUTOTUNE_SIZE];
+
+} MantisCTRTune_t;
+
+/** @endcond */
+
+static void mantis_ctr_time(void *arg)
+{
+    MantisCTRTune_t *tune = arg;
+    const MantisCTRVtable_t *vtable = tune->ctr.vtable;
+    (*(vtable->encrypt))(tune->data, tune->data, SKINNY_AUTOTUNE_SIZE,
+                         &(tune->ctr));
+}
+
+const char *_mantis_ctr_autotune(const char *name)
+{
+    const MantisCTRVtable_t *list[SKINNY_AUTOTUNE_MAX_BACKENDS];
+    const MantisCTRVtable_t *vtable;
+    MantisCTRTune_t *tune;
+    uint64_t time, best_time = ~((uint64_t)0);
+    unsigned count, index, best;
+
+    /* Select a specific back end by name */
+    count = mantis_ctr_backends(list);
+    if (name) {
+        for (index = 0; index < count; ++index) {
+            if (!strcmp(list[index]->name, name)) {
+                mantis_ctr_tuned = list[index];
+                return list[index]->name;
+            }
+        }
+        return 0;
+    }
+
+    /* Time each back end, starting with the default choice.  Another
+       back end must be strictly faster to replace the default */
+    best = count - 1;
+    if ((tune = calloc(1, sizeof(MantisCTRTune_t))) != NULL) {
+        for (index = count; index > 0; ) {
+            --index;
+            vtable = list[index];
+            tune->ctr.vtable = vtable;
+            if (!(*(vtable->init))(&(tune->ctr)))
+                continue;
+            if ((*(vtable->set_key))(&(tune->ctr), tune->data,
+                                     MANTIS_KEY_SIZE, MANTIS_MIN_ROUNDS)) {
+                time = _skinny_autotune_measure(mantis_ctr_time, tune);
+                if (time < best_time) {
+                    best = index;
+                    best_time = time;
+                }
+            }
+            (*(vtable->cleanup))(&(tune->ctr));
+        }
+        free(tune);
+    }
+    mantis_ctr_tuned = list[best];
+    return list[best]->name;
+}
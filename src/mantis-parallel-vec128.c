@@ -183,8 +183,44 @@ static uint16_t const rc[MANTIS_MAX_ROUNDS][4] = {
     RC(0x9216D5D98979FB1BULL)
 };
 
-void _mantis_parallel_crypt_vec128
-    (void *output, const void *input, const void *tweak, const MantisKey_t *ks)
+#if SKINNY_VEC128_SSSE3
+
+/* Nibble lookup tables for the S-box, for use with PSHUFB */
+#define MANTIS_SBOX_LO \
+    _mm_setr_epi8(0x0C, 0x0A, 0x0D, 0x03, 0x0E, 0x0B, 0x0F, 0x07, \
+                  0x08, 0x09, 0x01, 0x05, 0x00, 0x02, 0x04, 0x06)
+#define MANTIS_SBOX_HI \
+    _mm_setr_epi8(0xC0, 0xA0, 0xD0, 0x30, 0xE0, 0xB0, 0xF0, 0x70, \
+                  0x80, 0x90, 0x10, 0x50, 0x00, 0x20, 0x40, 0x60)
+
+#endif /* SKINNY_VEC128_SSSE3 */
+
+/* Applies the S-box to all cells in the state */
+SKINNY_ALWAYS_INLINE void mantis_sbox_state
+    (MantisVectorCells_t *state, int ssse3)
+{
+#if SKINNY_VEC128_SSSE3
+    if (ssse3) {
+        const __m128i lo = MANTIS_SBOX_LO;
+        const __m128i hi = MANTIS_SBOX_HI;
+        state->row[0] = skinny_sbox4_vec128(state->row[0], lo, hi);
+        state->row[1] = skinny_sbox4_vec128(state->row[1], lo, hi);
+        state->row[2] = skinny_sbox4_vec128(state->row[2], lo, hi);
+        state->row[3] = skinny_sbox4_vec128(state->row[3], lo, hi);
+        return;
+    }
+#else
+    (void)ssse3;
+#endif
+    state->row[0] = mantis_sbox(state->row[0]);
+    state->row[1] = mantis_sbox(state->row[1]);
+    state->row[2] = mantis_sbox(state->row[2]);
+    state->row[3] = mantis_sbox(state->row[3]);
+}
+
+SKINNY_ALWAYS_INLINE void mantis_parallel_crypt
+    (void *output, const void *input, const void *tweak,
+     const MantisKey_t *ks, int ssse3)
 {
     const uint16_t *r = rc[0];
     MantisVectorCells_t tk;
@@ -253,10 +289,7 @@ void _mantis_parallel_crypt_vec128
         mantis_update_tweak(&tk);
 
         /* Apply the S-box */
-        state.row[0] = mantis_sbox(state.row[0]);
-        state.row[1] = mantis_sbox(state.row[1]);
-        state.row[2] = mantis_sbox(state.row[2]);
-        state.row[3] = mantis_sbox(state.row[3]);
+        mantis_sbox_state(&state, ssse3);
 
         /* Add the round constant */
         state.row[0] ^= r[0];
@@ -279,15 +312,9 @@ void _mantis_parallel_crypt_vec128
     }
 
     /* Half-way there: sbox, mix, sbox */
-    state.row[0] = mantis_sbox(state.row[0]);
-    state.row[1] = mantis_sbox(state.row[1]);
-    state.row[2] = mantis_sbox(state.row[2]);
-    state.row[3] = mantis_sbox(state.row[3]);
+    mantis_sbox_state(&state, ssse3);
     mantis_mix_columns(&state);
-    state.row[0] = mantis_sbox(state.row[0]);
-    state.row[1] = mantis_sbox(state.row[1]);
-    state.row[2] = mantis_sbox(state.row[2]);
-    state.row[3] = mantis_sbox(state.row[3]);
+    mantis_sbox_state(&state, ssse3);
 
     /* Convert k1 into k1 XOR alpha for the reverse rounds */
     k1.row[0] ^= ALPHA_ROW0;
@@ -317,10 +344,7 @@ void _mantis_parallel_crypt_vec128
         state.row[3] ^= r[3];
 
         /* Apply the inverse S-box (which is the same as the forward S-box) */
-        state.row[0] = mantis_sbox(state.row[0]);
-        state.row[1] = mantis_sbox(state.row[1]);
-        state.row[2] = mantis_sbox(state.row[2]);
-        state.row[3] = mantis_sbox(state.row[3]);
+        mantis_sbox_state(&state, ssse3);
 
         /* Update the tweak with the reverse h function */
         mantis_update_tweak_inverse(&tk);
@@ -372,6 +396,22 @@ void _mantis_parallel_crypt_vec128
     WRITE_WORD16(output, 62, state.row[3][7]);
 }
 
+void _mantis_parallel_crypt_vec128
+    (void *output, const void *input, const void *tweak, const MantisKey_t *ks)
+{
+    mantis_parallel_crypt(output, input, tweak, ks, 0);
+}
+
+#if SKINNY_VEC128_SSSE3
+
+SKINNY_TARGET_SSSE3 void _mantis_parallel_crypt_ssse3
+    (void *output, const void *input, const void *tweak, const MantisKey_t *ks)
+{
+    mantis_parallel_crypt(output, input, tweak, ks, 1);
+}
+
+#endif /* SKINNY_VEC128_SSSE3 */
+
 #else /* !SKINNY_VEC128_MATH */
 
 /* Stubbed out */
@@ -385,3 +425,17 @@ void _mantis_parallel_crypt_vec128
 }
 
 #endif /* SKINNY_VEC128_MATH */
+
+#if !SKINNY_VEC128_SSSE3
+
+/* Stubbed out */
+void _mantis_parallel_crypt_ssse3
+    (void *output, const void *input, const void *tweak, const MantisKey_t *ks)
+{
+    (void)output;
+    (void)input;
+    (void)tweak;
+    (void)ks;
+}
+
+#endif /* !SKINNY_VEC128_SSSE3 */
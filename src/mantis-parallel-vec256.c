@@ -0,0 +1,312 @@
+/*
+ * Copyright (C) 2017 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#define SKINNY_TARGET_VEC256 1
+
+#include "mantis-parallel.h"
+#include "skinny-internal.h"
+
+#if SKINNY_VEC256_MATH
+
+/**
+ * \brief All cells in a Mantis 16-way block.
+ */
+typedef union
+{
+    SkinnyVector16x16_t row[4];
+
+} MantisVectorCells_t;
+
+STATIC_INLINE void mantis_update_tweak(MantisVectorCells_t *tweak)
+{
+    /* h = [6, 5, 14, 15, 0, 1, 2, 3, 7, 12, 13, 4, 8, 9, 10, 11] */
+    SkinnyVector16x16_t row1 = tweak->row[1];
+    SkinnyVector16x16_t row3 = tweak->row[3];
+    tweak->row[1] = tweak->row[0];
+    tweak->row[3] = tweak->row[2];
+    tweak->row[0] = ((row1 >>  8) & 0x00F0U) |
+                     (row1        & 0x000FU) |
+                     (row3        & 0xFF00U);
+    tweak->row[2] = ((row1 <<  4) & 0x0F00U) |
+                    ((row1 >>  4) & 0x00F0U) |
+                    ((row3 >>  4) & 0x000FU) |
+                    ((row3 << 12) & 0xF000U);
+}
+
+STATIC_INLINE void mantis_update_tweak_inverse(MantisVectorCells_t *tweak)
+{
+    /* h' = [4, 5, 6, 7, 11, 1, 0, 8, 12, 13, 14, 15, 9, 10, 2, 3] */
+    SkinnyVector16x16_t row0 = tweak->row[0];
+    SkinnyVector16x16_t row2 = tweak->row[2];
+    tweak->row[0] = tweak->row[1];
+    tweak->row[2] = tweak->row[3];
+    tweak->row[1] = ((row2 >>  4) & 0x00F0U) |
+                    ((row2 <<  4) & 0x0F00U) |
+                     (row0        & 0x000FU) |
+                    ((row0 <<  8) & 0xF000U);
+    tweak->row[3] =  (row0        & 0xFF00U) |
+                    ((row2 <<  4) & 0x00F0U) |
+                    ((row2 >> 12) & 0x000FU);
+}
+
+STATIC_INLINE void mantis_shift_rows(MantisVectorCells_t *state)
+{
+    /* P = [0, 11, 6, 13, 10, 1, 12, 7, 5, 14, 3, 8, 15, 4, 9, 2] */
+    SkinnyVector16x16_t row0 = state->row[0];
+    SkinnyVector16x16_t row1 = state->row[1];
+    SkinnyVector16x16_t row2 = state->row[2];
+    SkinnyVector16x16_t row3 = state->row[3];
+    state->row[0] =  (row0        & 0x00F0U) |
+                     (row1        & 0xF000U) |
+                    ((row2 >>  8) & 0x000FU) |
+                    ((row3 <<  8) & 0x0F00U);
+    state->row[1] =  (row0        & 0x000FU) |
+                     (row1        & 0x0F00U) |
+                    ((row2 >>  8) & 0x00F0U) |
+                    ((row3 <<  8) & 0xF000U);
+    state->row[2] = ((row0 <<  4) & 0xF000U) |
+                    ((row1 <<  4) & 0x00F0U) |
+                    ((row2 <<  4) & 0x0F00U) |
+                    ((row3 >> 12) & 0x000FU);
+    state->row[3] = ((row0 >>  4) & 0x0F00U) |
+                    ((row1 >>  4) & 0x000FU) |
+                    ((row2 << 12) & 0xF000U) |
+                    ((row3 >>  4) & 0x00F0U);
+}
+
+STATIC_INLINE void mantis_shift_rows_inverse(MantisVectorCells_t *state)
+{
+    /* P' = [0, 5, 15, 10, 13, 8, 2, 7, 11, 14, 4, 1, 6, 3, 9, 12] */
+    SkinnyVector16x16_t row0 = state->row[0];
+    SkinnyVector16x16_t row1 = state->row[1];
+    SkinnyVector16x16_t row2 = state->row[2];
+    SkinnyVector16x16_t row3 = state->row[3];
+    state->row[0] =  (row0        & 0x00F0U) |
+                     (row1        & 0x000FU) |
+                    ((row2 >>  4) & 0x0F00U) |
+                    ((row3 <<  4) & 0xF000U);
+    state->row[1] =  (row0        & 0xF000U) |
+                     (row1        & 0x0F00U) |
+                    ((row2 >>  4) & 0x000FU) |
+                    ((row3 <<  4) & 0x00F0U);
+    state->row[2] = ((row0 <<  8) & 0x0F00U) |
+                    ((row1 <<  8) & 0xF000U) |
+                    ((row2 >>  4) & 0x00F0U) |
+                    ((row3 >> 12) & 0x000FU);
+    state->row[3] = ((row0 >>  8) & 0x000FU) |
+                    ((row1 >>  8) & 0x00F0U) |
+                    ((row2 << 12) & 0xF000U) |
+                    ((row3 <<  4) & 0x0F00U);
+}
+
+STATIC_INLINE void mantis_mix_columns(MantisVectorCells_t *state)
+{
+    SkinnyVector16x16_t t0 = state->row[0];
+    SkinnyVector16x16_t t1 = state->row[1];
+    SkinnyVector16x16_t t2 = state->row[2];
+    SkinnyVector16x16_t t3 = state->row[3];
+    state->row[0] = t1 ^ t2 ^ t3;
+    state->row[1] = t0 ^ t2 ^ t3;
+    state->row[2] = t0 ^ t1 ^ t3;
+    state->row[3] = t0 ^ t1 ^ t2;
+}
+
+/* Extract the 16 bits for a row from a 64-bit round constant */
+#define RC_EXTRACT_ROW(x,shift) \
+    (((((uint16_t)((x) >> ((shift) + 8))) & 0xFF)) | \
+     ((((uint16_t)((x) >> ((shift))))     & 0xFF) << 8))
+
+/* Extract the rows from a 64-bit round constant */
+#define RC(x)    \
+    {RC_EXTRACT_ROW((x), 48), RC_EXTRACT_ROW((x), 32), \
+     RC_EXTRACT_ROW((x), 16), RC_EXTRACT_ROW((x), 0)}
+
+/* Alpha constant for adjusting k1 for the inverse rounds */
+#define ALPHA      0x243F6A8885A308D3ULL
+#define ALPHA_ROW0 (RC_EXTRACT_ROW(ALPHA, 48))
+#define ALPHA_ROW1 (RC_EXTRACT_ROW(ALPHA, 32))
+#define ALPHA_ROW2 (RC_EXTRACT_ROW(ALPHA, 16))
+#define ALPHA_ROW3 (RC_EXTRACT_ROW(ALPHA, 0))
+
+/* Round constants for Mantis, split up into 16-bit row values */
+static uint16_t const rc[MANTIS_MAX_ROUNDS][4] = {
+    RC(0x13198A2E03707344ULL),
+    RC(0xA4093822299F31D0ULL),
+    RC(0x082EFA98EC4E6C89ULL),
+    RC(0x452821E638D01377ULL),
+    RC(0xBE5466CF34E90C6CULL),
+    RC(0xC0AC29B7C97C50DDULL),
+    RC(0x3F84D5B5B5470917ULL),
+    RC(0x9216D5D98979FB1BULL)
+};
+
+/* Nibble lookup tables for the S-box, for use with VPSHUFB */
+#define MANTIS_SBOX_LO \
+    _mm256_setr_epi8(0x0C, 0x0A, 0x0D, 0x03, 0x0E, 0x0B, 0x0F, 0x07, \
+                     0x08, 0x09, 0x01, 0x05, 0x00, 0x02, 0x04, 0x06, \
+                     0x0C, 0x0A, 0x0D, 0x03, 0x0E, 0x0B, 0x0F, 0x07, \
+                     0x08, 0x09, 0x01, 0x05, 0x00, 0x02, 0x04, 0x06)
+#define MANTIS_SBOX_HI \
+    _mm256_setr_epi8(0xC0, 0xA0, 0xD0, 0x30, 0xE0, 0xB0, 0xF0, 0x70, \
+                     0x80, 0x90, 0x10, 0x50, 0x00, 0x20, 0x40, 0x60, \
+                     0xC0, 0xA0, 0xD0, 0x30, 0xE0, 0xB0, 0xF0, 0x70, \
+                     0x80, 0x90, 0x10, 0x50, 0x00, 0x20, 0x40, 0x60)
+
+/* Applies the S-box to all cells in the state */
+STATIC_INLINE void mantis_sbox_state(MantisVectorCells_t *state)
+{
+    const __m256i lo = MANTIS_SBOX_LO;
+    const __m256i hi = MANTIS_SBOX_HI;
+    state->row[0] = skinny_sbox4_vec256(state->row[0], lo, hi);
+    state->row[1] = skinny_sbox4_vec256(state->row[1], lo, hi);
+    state->row[2] = skinny_sbox4_vec256(state->row[2], lo, hi);
+    state->row[3] = skinny_sbox4_vec256(state->row[3], lo, hi);
+}
+
+void _mantis_parallel_crypt_vec256
+    (void *output, const void *input, const void *tweak, const MantisKey_t *ks)
+{
+    const uint16_t *r = rc[0];
+    MantisVectorCells_t tk;
+    MantisCells_t k1 = ks->k1;
+    MantisVectorCells_t state;
+    unsigned index;
+
+    /* Read the rows of all sixteen blocks into memory */
+    skinny_load_rows_16x16(state.row, input);
+
+    /* Read the sixteen tweak values into memory */
+    skinny_load_rows_16x16(tk.row, tweak);
+
+    /* XOR the initial whitening key k0 with the state,
+       together with k1 and the initial tweak value */
+    state.row[0] ^= ks->k0.row[0] ^ k1.row[0];
+    state.row[0] ^= tk.row[0];
+    state.row[1] ^= ks->k0.row[1] ^ k1.row[1];
+    state.row[1] ^= tk.row[1];
+    state.row[2] ^= ks->k0.row[2] ^ k1.row[2];
+    state.row[2] ^= tk.row[2];
+    state.row[3] ^= ks->k0.row[3] ^ k1.row[3];
+    state.row[3] ^= tk.row[3];
+
+    /* Perform all forward rounds */
+    for (index = ks->rounds; index > 0; --index) {
+        /* Update the tweak with the forward h function */
+        mantis_update_tweak(&tk);
+
+        /* Apply the S-box */
+        mantis_sbox_state(&state);
+
+        /* Add the round constant */
+        state.row[0] ^= r[0];
+        state.row[1] ^= r[1];
+        state.row[2] ^= r[2];
+        state.row[3] ^= r[3];
+        r += 4;
+
+        /* XOR with the key and tweak */
+        state.row[0] ^= k1.row[0] ^ tk.row[0];
+        state.row[1] ^= k1.row[1] ^ tk.row[1];
+        state.row[2] ^= k1.row[2] ^ tk.row[2];
+        state.row[3] ^= k1.row[3] ^ tk.row[3];
+
+        /* Shift the rows */
+        mantis_shift_rows(&state);
+
+        /* Mix the columns */
+        mantis_mix_columns(&state);
+    }
+
+    /* Half-way there: sbox, mix, sbox */
+    mantis_sbox_state(&state);
+    mantis_mix_columns(&state);
+    mantis_sbox_state(&state);
+
+    /* Convert k1 into k1 XOR alpha for the reverse rounds */
+    k1.row[0] ^= ALPHA_ROW0;
+    k1.row[1] ^= ALPHA_ROW1;
+    k1.row[2] ^= ALPHA_ROW2;
+    k1.row[3] ^= ALPHA_ROW3;
+
+    /* Perform all reverse rounds */
+    for (index = ks->rounds; index > 0; --index) {
+        /* Inverse mix of the columns (same as the forward mix) */
+        mantis_mix_columns(&state);
+
+        /* Inverse shift of the rows */
+        mantis_shift_rows_inverse(&state);
+
+        /* XOR with the key and tweak */
+        state.row[0] ^= k1.row[0] ^ tk.row[0];
+        state.row[1] ^= k1.row[1] ^ tk.row[1];
+        state.row[2] ^= k1.row[2] ^ tk.row[2];
+        state.row[3] ^= k1.row[3] ^ tk.row[3];
+
+        /* Add the round constant */
+        r -= 4;
+        state.row[0] ^= r[0];
+        state.row[1] ^= r[1];
+        state.row[2] ^= r[2];
+        state.row[3] ^= r[3];
+
+        /* Apply the inverse S-box (which is the same as the forward S-box) */
+        mantis_sbox_state(&state);
+
+        /* Update the tweak with the reverse h function */
+        mantis_update_tweak_inverse(&tk);
+    }
+
+    /* XOR the final whitening key k0prime with the state,
+       together with k1alpha and the final tweak value */
+    state.row[0] ^= ks->k0prime.row[0] ^ k1.row[0];
+    state.row[0] ^= tk.row[0];
+    state.row[1] ^= ks->k0prime.row[1] ^ k1.row[1];
+    state.row[1] ^= tk.row[1];
+    state.row[2] ^= ks->k0prime.row[2] ^ k1.row[2];
+    state.row[2] ^= tk.row[2];
+    state.row[3] ^= ks->k0prime.row[3] ^ k1.row[3];
+    state.row[3] ^= tk.row[3];
+
+    /* Write the rows of all sixteen blocks back to memory */
+    skinny_transpose_16x16
+        (tk.row, state.row[0], state.row[1], state.row[2], state.row[3]);
+    _mm256_storeu_si256((__m256i *)output, (__m256i)tk.row[0]);
+    _mm256_storeu_si256(((__m256i *)output) + 1, (__m256i)tk.row[1]);
+    _mm256_storeu_si256(((__m256i *)output) + 2, (__m256i)tk.row[2]);
+    _mm256_storeu_si256(((__m256i *)output) + 3, (__m256i)tk.row[3]);
+}
+
+#else /* !SKINNY_VEC256_MATH */
+
+/* Stubbed out */
+void _mantis_parallel_crypt_vec256
+    (void *output, const void *input, const void *tweak, const MantisKey_t *ks)
+{
+    (void)output;
+    (void)input;
+    (void)tweak;
+    (void)ks;
+}
+
+#endif /* SKINNY_VEC256_MATH */
+
+SKINNY_TARGET_END
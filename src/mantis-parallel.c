@@ -34,6 +34,8 @@ typedef struct
 {
     void (*crypt)(void *output, const void *input, const void *tweak,
                   const MantisKey_t *ks);
+    size_t parallel_size;
+    const char *name;
 
 } MantisParallelECBVtable_t;
 
@@ -41,33 +43,108 @@ void _mantis_parallel_crypt_vec128
     (void *output, const void *input, const void *tweak, const MantisKey_t *ks);
 
 static MantisParallelECBVtable_t const mantis_parallel_ecb_vec128 = {
-    _mantis_parallel_crypt_vec128
+    _mantis_parallel_crypt_vec128,
+    8 * MANTIS_BLOCK_SIZE,
+    "vec128"
+};
+
+void _mantis_parallel_crypt_ssse3
+    (void *output, const void *input, const void *tweak, const MantisKey_t *ks);
+
+static MantisParallelECBVtable_t const mantis_parallel_ecb_ssse3 = {
+    _mantis_parallel_crypt_ssse3,
+    8 * MANTIS_BLOCK_SIZE,
+    "ssse3"
+};
+
+void _mantis_parallel_crypt_vec256
+    (void *output, const void *input, const void *tweak, const MantisKey_t *ks);
+
+static MantisParallelECBVtable_t const mantis_parallel_ecb_vec256 = {
+    _mantis_parallel_crypt_vec256,
+    16 * MANTIS_BLOCK_SIZE,
+    "vec256"
 };
 
 /** @endcond */
 
+/* Lists the parallel back ends that are usable on this platform, in
+   increasing order of preference.  The first entry is always NULL for
+   the non-parallel implementation */
+static unsigned mantis_parallel_ecb_backends
+    (const MantisParallelECBVtable_t **list)
+{
+    unsigned count = 0;
+    list[count++] = 0;
+    if (_skinny_has_vec128())
+        list[count++] = &mantis_parallel_ecb_vec128;
+    if (_skinny_has_vec128_ssse3())
+        list[count++] = &mantis_parallel_ecb_ssse3;
+    if (_skinny_has_vec256())
+        list[count++] = &mantis_parallel_ecb_vec256;
+    return count;
+}
+
+/* Back end that was chosen by the autotuner, which is only valid if
+   mantis_parallel_ecb_is_tuned is non-zero */
+static const MantisParallelECBVtable_t *mantis_parallel_ecb_tuned = 0;
+static int mantis_parallel_ecb_is_tuned = 0;
+
+/* Chooses the best parallel back end for this platform, or NULL if the
+   non-parallel implementation is the best we have */
+static const MantisParallelECBVtable_t *mantis_parallel_ecb_select
+    (size_t *parallel_size)
+{
+    const MantisParallelECBVtable_t *list[SKINNY_AUTOTUNE_MAX_BACKENDS];
+    const MantisParallelECBVtable_t *vtable;
+    if (mantis_parallel_ecb_is_tuned)
+        vtable = mantis_parallel_ecb_tuned;
+    else
+        vtable = list[mantis_parallel_ecb_backends(list) - 1];
+    *parallel_size = vtable ? vtable->parallel_size : 8 * MANTIS_BLOCK_SIZE;
+    return vtable;
+}
+
+/* Name of a parallel back end, where NULL means that the non-parallel
+   implementation is used for all blocks */
+static const char *mantis_parallel_ecb_name
+    (const MantisParallelECBVtable_t *vtable)
+{
+    return vtable ? vtable->name : "default";
+}
+
 int mantis_parallel_ecb_init(MantisParallelECB_t *ecb)
 {
     MantisKey_t *ctx;
+    const MantisParallelECBVtable_t *vtable;
     if ((ctx = calloc(1, sizeof(MantisKey_t))) == NULL)
         return 0;
-    ecb->vtable = 0;
     ecb->ctx = ctx;
-    ecb->parallel_size = 8 * MANTIS_BLOCK_SIZE;
-    if (_skinny_has_vec128())
-        ecb->vtable = &mantis_parallel_ecb_vec128;
+    SKINNY_STAT_ADD(context_allocs, 1);
+    vtable = mantis_parallel_ecb_select(&(ecb->parallel_size));
+    ecb->vtable = vtable;
+    SKINNY_PROBE3(mantis_parallel_ecb_init, ecb,
+                  mantis_parallel_ecb_name(vtable), ecb->parallel_size);
     return 1;
 }
 
 void mantis_parallel_ecb_cleanup(MantisParallelECB_t *ecb)
 {
     if (ecb && ecb->ctx) {
+        SKINNY_PROBE1(mantis_parallel_ecb_cleanup, ecb);
         skinny_cleanse(ecb->ctx, sizeof(MantisKey_t));
         free(ecb->ctx);
         ecb->ctx = 0;
     }
 }
 
+const char *mantis_parallel_ecb_backend_name(const MantisParallelECB_t *ecb)
+{
+    if (!ecb || !ecb->ctx)
+        return 0;
+    return mantis_parallel_ecb_name(ecb->vtable);
+}
+
 int mantis_parallel_ecb_set_key
     (MantisParallelECB_t *ecb, const void *key, unsigned size,
      unsigned rounds, int mode)
@@ -94,17 +171,21 @@ int mantis_parallel_ecb_crypt
 {
     const MantisKey_t *ks;
     const MantisParallelECBVtable_t *vtable;
+    size_t total;
 
     /* Validate the parameters */
     if (!ecb || !ecb->ctx || (size % MANTIS_BLOCK_SIZE) != 0)
         return 0;
     ks = ecb->ctx;
+    total = size;
+    SKINNY_PROBE2(mantis_parallel_ecb_crypt_start, ecb, size);
 
     /* Process major blocks with the vectorized back end */
     vtable = ecb->vtable;
     if (vtable) {
         size_t psize = ecb->parallel_size;
         while (size >= psize) {
+            SKINNY_STAT_ADD(parallel_blocks, psize / MANTIS_BLOCK_SIZE);
             (*(vtable->crypt))(output, input, tweak, ks);
             output += psize;
             input += psize;
@@ -114,6 +195,7 @@ int mantis_parallel_ecb_crypt
     }
 
     /* Process any left-over blocks with the non-parallel implementation */
+    SKINNY_STAT_ADD(tail_blocks, size / MANTIS_BLOCK_SIZE);
     while (size >= MANTIS_BLOCK_SIZE) {
         mantis_ecb_crypt_tweaked(output, input, tweak, ks);
         output += MANTIS_BLOCK_SIZE;
@@ -121,5 +203,166 @@ int mantis_parallel_ecb_crypt
         tweak += MANTIS_BLOCK_SIZE;
         size -= MANTIS_BLOCK_SIZE;
     }
+    SKINNY_PROBE2(mantis_parallel_ecb_crypt_done, ecb, total);
     return 1;
 }
+
+void mantis_ecb_crypt_blocks
+    (void *output, const void *input, const void *tweak, size_t count,
+     const MantisKey_t *ks)
+{
+    const MantisParallelECBVtable_t *vtable;
+    size_t psize;
+
+    /* Process major blocks with the best vectorized back end */
+    vtable = mantis_parallel_ecb_select(&psize);
+    SKINNY_PROBE3(mantis_ecb_crypt_blocks_start, ks, count,
+                  mantis_parallel_ecb_name(vtable));
+    if (vtable) {
+        size_t pcount = psize / MANTIS_BLOCK_SIZE;
+        while (count >= pcount) {
+            SKINNY_STAT_ADD(parallel_blocks, pcount);
+            (*(vtable->crypt))(output, input, tweak, ks);
+            output += psize;
+            input += psize;
+            tweak += psize;
+            count -= pcount;
+        }
+    }
+
+    /* Process any left-over blocks with the non-parallel implementation */
+    SKINNY_STAT_ADD(tail_blocks, count);
+    while (count > 0) {
+        mantis_ecb_crypt_tweaked(output, input, tweak, ks);
+        output += MANTIS_BLOCK_SIZE;
+        input += MANTIS_BLOCK_SIZE;
+        tweak += MANTIS_BLOCK_SIZE;
+        --count;
+    }
+    SKINNY_PROBE1(mantis_ecb_crypt_blocks_done, ks);
+}
+
+/* Number of IDs and tweaks to convert to little-endian at a time */
+#define MANTIS_IDS_CHUNK 64
+
+void mantis_ecb_crypt_ids
+    (uint64_t *output, const uint64_t *input, const uint64_t *tweak,
+     size_t count, const MantisKey_t *ks)
+{
+    uint64_t tweaks[MANTIS_IDS_CHUNK];
+    uint64_t default_tweak;
+    size_t len, index;
+
+#if SKINNY_LITTLE_ENDIAN
+    /* The IDs and tweaks are already in the block format in memory */
+    if (tweak) {
+        mantis_ecb_crypt_blocks(output, input, tweak, count, ks);
+        return;
+    }
+#endif
+
+    /* Pack the tweak from the key schedule into a little-endian block */
+    default_tweak = ((uint64_t)(ks->tweak.row[0])) |
+                   (((uint64_t)(ks->tweak.row[1])) << 16) |
+                   (((uint64_t)(ks->tweak.row[2])) << 32) |
+                   (((uint64_t)(ks->tweak.row[3])) << 48);
+    default_tweak = skinny_le64(default_tweak);
+
+    /* Convert the IDs and tweaks in chunks around the block function */
+    while (count > 0) {
+        len = count < MANTIS_IDS_CHUNK ? count : MANTIS_IDS_CHUNK;
+        for (index = 0; index < len; ++index) {
+            output[index] = skinny_le64(input[index]);
+            tweaks[index] =
+                tweak ? skinny_le64(tweak[index]) : default_tweak;
+        }
+        mantis_ecb_crypt_blocks(output, output, tweaks, len, ks);
+        for (index = 0; index < len; ++index)
+            output[index] = skinny_le64(output[index]);
+        output += len;
+        input += len;
+        if (tweak)
+            tweak += len;
+        count -= len;
+    }
+}
+
+/** @cond */
+
+/**
+ * \brief State for timing a parallel back end with the autotuner.
+ */
+typedef struct
+{
+    const MantisParallelECBVtable_t *vtable;
+    MantisKey_t ks;
+    unsigned char data[SKINNY_AUTOTUNE_SIZE];
+    unsigned char tweak[SKINNY_AUTOTUNE_SIZE];
+
+} MantisParallelECBTune_t;
+
+/** @endcond */
+
+static void mantis_parallel_ecb_time(void *arg)
+{
+    MantisParallelECBTune_t *tune = arg;
+    const MantisParallelECBVtable_t *vtable = tune->vtable;
+    size_t posn;
+    if (vtable) {
+        for (posn = 0; posn < SKINNY_AUTOTUNE_SIZE;
+                posn += vtable->parallel_size) {
+            (*(vtable->crypt))(tune->data + posn, tune->data + posn,
+                               tune->tweak + posn, &(tune->ks));
+        }
+    } else {
+        for (posn = 0; posn < SKINNY_AUTOTUNE_SIZE;
+                posn += MANTIS_BLOCK_SIZE) {
+            mantis_ecb_crypt_tweaked(tune->data + posn, tune->data + posn,
+                                     tune->tweak + posn, &(tune->ks));
+        }
+    }
+}
+
+const char *_mantis_parallel_ecb_autotune(const char *name)
+{
+    const MantisParallelECBVtable_t *list[SKINNY_AUTOTUNE_MAX_BACKENDS];
+    MantisParallelECBTune_t *tune;
+    uint64_t time, best_time = ~((uint64_t)0);
+    unsigned count, index, best;
+
+    /* Select a specific back end by name */
+    count = mantis_parallel_ecb_backends(list);
+    if (name) {
+        for (index = 0; index < count; ++index) {
+            const char *backend = list[index] ? list[index]->name : "default";
+            if (!strcmp(backend, name)) {
+                mantis_parallel_ecb_tuned = list[index];
+                mantis_parallel_ecb_is_tuned = 1;
+                return backend;
+            }
+        }
+        return 0;
+    }
+
+    /* Time each back end, starting with the default choice.  Another
+       back end must be strictly faster to replace the default */
+    best = count - 1;
+    if ((tune = calloc(1, sizeof(MantisParallelECBTune_t))) != NULL) {
+        mantis_set_key(&(tune->ks), tune->data, MANTIS_KEY_SIZE,
+                       MANTIS_MIN_ROUNDS, MANTIS_ENCRYPT);
+        for (index = count; index > 0; ) {
+            --index;
+            tune->vtable = list[index];
+            time = _skinny_autotune_measure(mantis_parallel_ecb_time, tune);
+            if (time < best_time) {
+                best = index;
+                best_time = time;
+            }
+        }
+        skinny_cleanse(tune, sizeof(MantisParallelECBTune_t));
+        free(tune);
+    }
+    mantis_parallel_ecb_tuned = list[best];
+    mantis_parallel_ecb_is_tuned = 1;
+    return list[best] ? list[best]->name : "default";
+}
@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2017 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* Needed for clock_gettime() when compiling in strict C99 mode */
+#define _POSIX_C_SOURCE 200112L
+
+#include "skinny-autotune.h"
+#include "skinny-internal.h"
+#include <stdio.h>
+#include <time.h>
+
+/* Number of times to run each operation, keeping the best time */
+#define SKINNY_AUTOTUNE_RUNS 5
+
+/* Identifier that starts the first line of the cache file */
+#define SKINNY_AUTOTUNE_MAGIC "skinny-autotune-1"
+
+/** @cond */
+
+/**
+ * \brief Information about a dispatcher that can be tuned.
+ */
+typedef struct
+{
+    /** Label for the dispatcher in the cache file */
+    const char *label;
+
+    /** Selects a back end by name, or by timing them if the name is NULL */
+    const char *(*tune)(const char *name);
+
+} SkinnyAutotuner_t;
+
+/** @endcond */
+
+static SkinnyAutotuner_t const skinny_autotuners[] = {
+    {"skinny128-ctr",           _skinny128_ctr_autotune},
+    {"skinny128-parallel-ecb",  _skinny128_parallel_ecb_autotune},
+    {"skinny64-ctr",            _skinny64_ctr_autotune},
+    {"skinny64-parallel-ecb",   _skinny64_parallel_ecb_autotune},
+    {"mantis-ctr",              _mantis_ctr_autotune},
+    {"mantis-parallel-ecb",     _mantis_parallel_ecb_autotune}
+};
+#define SKINNY_AUTOTUNER_COUNT \
+    (sizeof(skinny_autotuners) / sizeof(skinny_autotuners[0]))
+
+/* Gets the current time in nanoseconds */
+static uint64_t skinny_autotune_timestamp(void)
+{
+#if defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)(ts.tv_sec)) * 1000000000U + (uint64_t)(ts.tv_nsec);
+#else
+    return ((uint64_t)clock()) * (1000000000U / CLOCKS_PER_SEC);
+#endif
+}
+
+uint64_t _skinny_autotune_measure(void (*op)(void *arg), void *arg)
+{
+    uint64_t best = 0;
+    uint64_t start, elapsed;
+    unsigned run;
+
+    /* The first run warms up the caches and is not counted */
+    (*op)(arg);
+    for (run = 0; run < SKINNY_AUTOTUNE_RUNS; ++run) {
+        start = skinny_autotune_timestamp();
+        (*op)(arg);
+        elapsed = skinny_autotune_timestamp() - start;
+        if (run == 0 || elapsed < best)
+            best = elapsed;
+    }
+    return best;
+}
+
+/* Formats the header line that identifies the CPU in the cache file.
+   The results are only reused on the same CPU model and stepping with
+   the same set of usable SIMD extensions */
+static void skinny_autotune_header(char *line, size_t size)
+{
+    unsigned features = 0;
+    if (_skinny_has_vec128())
+        features |= 0x01;
+    if (_skinny_has_vec128_ssse3())
+        features |= 0x02;
+    if (_skinny_has_vec256())
+        features |= 0x04;
+    if (_skinny_has_vec512())
+        features |= 0x08;
+    snprintf(line, size, "%s %08lx-%x\n", SKINNY_AUTOTUNE_MAGIC,
+             (unsigned long)_skinny_cpu_signature(), features);
+}
+
+/* Loads the previous results from a cache file.  Returns zero if the
+   file is missing, was written for a different CPU, or names a back end
+   that is not available in this build */
+static int skinny_autotune_load(const char *cache_file)
+{
+    char expected[64];
+    char line[128];
+    char label[64];
+    char name[64];
+    unsigned found = 0;
+    unsigned index;
+    FILE *file;
+    int ok = 1;
+
+    if ((file = fopen(cache_file, "r")) == NULL)
+        return 0;
+    skinny_autotune_header(expected, sizeof(expected));
+    if (!fgets(line, sizeof(line), file) || strcmp(line, expected) != 0) {
+        fclose(file);
+        return 0;
+    }
+    while (ok && fgets(line, sizeof(line), file)) {
+        if (sscanf(line, "%63s %63s", label, name) != 2)
+            continue;
+        ok = 0;
+        for (index = 0; index < SKINNY_AUTOTUNER_COUNT; ++index) {
+            if (!strcmp(label, skinny_autotuners[index].label)) {
+                if ((*(skinny_autotuners[index].tune))(name) != NULL) {
+                    found |= 1U << index;
+                    ok = 1;
+                }
+                break;
+            }
+        }
+    }
+    fclose(file);
+    return ok && found == ((1U << SKINNY_AUTOTUNER_COUNT) - 1);
+}
+
+int skinny_autotune(const char *cache_file)
+{
+    const char *names[SKINNY_AUTOTUNER_COUNT];
+    char header[64];
+    unsigned index;
+    FILE *file;
+    int ok;
+
+    /* Reuse the results from a previous process if we can */
+    if (cache_file && skinny_autotune_load(cache_file))
+        return 1;
+
+    /* Time the back ends for each dispatcher */
+    for (index = 0; index < SKINNY_AUTOTUNER_COUNT; ++index)
+        names[index] = (*(skinny_autotuners[index].tune))(0);
+    if (!cache_file)
+        return 1;
+
+    /* Save the results for next time */
+    if ((file = fopen(cache_file, "w")) == NULL)
+        return 0;
+    skinny_autotune_header(header, sizeof(header));
+    ok = fputs(header, file) >= 0;
+    for (index = 0; index < SKINNY_AUTOTUNER_COUNT; ++index) {
+        if (fprintf(file, "%s %s\n", skinny_autotuners[index].label,
+                    names[index]) < 0)
+            ok = 0;
+    }
+    if (fclose(file) != 0)
+        ok = 0;
+    return ok;
+}
@@ -20,6 +20,7 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+#include "skinny-stats.h"
 #include "skinny-internal.h"
 #include <stdlib.h>
 
@@ -38,7 +39,20 @@
 #include <cpuid.h>
 #endif
 
-int _skinny_has_vec128(void)
+#if SKINNY_X86_CPUID
+
+/* Read the XCR0 register to find out which register states the OS saves.
+   Only call this if CPUID reports that OSXSAVE is enabled */
+STATIC_INLINE uint32_t skinny_xgetbv(void)
+{
+    uint32_t eax, edx;
+    __asm__ __volatile__ ("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return eax;
+}
+
+#endif
+
+static int skinny_detect_vec128(void)
 {
     int detected = 0;
 #if SKINNY_VEC128_MATH
@@ -61,31 +75,147 @@ int _skinny_has_vec128(void)
     return detected;
 }
 
-int _skinny_has_vec256(void)
+static int skinny_detect_vec128_ssse3(void)
+{
+    int detected = 0;
+#if SKINNY_VEC128_SSSE3 && SKINNY_X86_CPUID
+    /* SSSE3 adds the PSHUFB byte shuffle that we use for 4-bit S-boxes */
+    uint32_t eax = 0;
+    uint32_t ebx = 0;
+    uint32_t ecx = 0;
+    uint32_t edx = 0;
+    __cpuid(1, eax, ebx, ecx, edx);
+    detected = (edx & (1 << 26)) != 0 && (ecx & (1 << 9)) != 0;
+#endif
+    return detected;
+}
+
+static int skinny_detect_vec256(void)
 {
     int detected = 0;
-#if SKINNY_VEC256_MATH
-#if SKINNY_X86_CPUID && defined(__AVX2__)
-    /* 256-bit SIMD vectors are available on x86 if we have AVX2 */
+#if SKINNY_X86_CPUID && (SKINNY_X86_TARGETS || defined(__AVX2__))
+    /* 256-bit SIMD vectors are available on x86 if we have AVX2 and
+       the operating system saves the YMM registers on context switch */
     uint32_t eax = 0;
     uint32_t ebx = 0;
     uint32_t ecx = 0;
     uint32_t edx = 0;
-    __cpuid(7, eax, ebx, ecx, edx);
+    __cpuid(1, eax, ebx, ecx, edx);
+    if ((ecx & (1 << 27)) == 0 || (skinny_xgetbv() & 0x06) != 0x06)
+        return 0;
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
     detected = (ebx & (1 << 5)) != 0;
 #endif
+    return detected;
+}
+
+static int skinny_detect_vec512(void)
+{
+    int detected = 0;
+#if SKINNY_X86_CPUID && (SKINNY_X86_TARGETS || \
+        (defined(__AVX512F__) && defined(__AVX512VL__)))
+    /* 512-bit SIMD vectors are available on x86 if we have AVX512F and
+       AVX512VL, and the operating system saves the opmask and ZMM
+       registers in addition to the XMM and YMM registers */
+    uint32_t eax = 0;
+    uint32_t ebx = 0;
+    uint32_t ecx = 0;
+    uint32_t edx = 0;
+    __cpuid(1, eax, ebx, ecx, edx);
+    if ((ecx & (1 << 27)) == 0 || (skinny_xgetbv() & 0xE6) != 0xE6)
+        return 0;
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    detected = (ebx & (1 << 16)) != 0 && (ebx & 0x80000000U) != 0;
 #endif
     return detected;
 }
 
+/* CPUID is slow, and may trap to the hypervisor in virtual machines, so
+   the results are cached.  Racing threads will store the same values */
+static int skinny_has_vec128 = -1;
+static int skinny_has_vec128_ssse3 = -1;
+static int skinny_has_vec256 = -1;
+static int skinny_has_vec512 = -1;
+
+int _skinny_has_vec128(void)
+{
+    if (skinny_has_vec128 < 0)
+        skinny_has_vec128 = skinny_detect_vec128();
+    return skinny_has_vec128;
+}
+
+int _skinny_has_vec128_ssse3(void)
+{
+    if (skinny_has_vec128_ssse3 < 0)
+        skinny_has_vec128_ssse3 = skinny_detect_vec128_ssse3();
+    return skinny_has_vec128_ssse3;
+}
+
+int _skinny_has_vec256(void)
+{
+    if (skinny_has_vec256 < 0)
+        skinny_has_vec256 = skinny_detect_vec256();
+    return skinny_has_vec256;
+}
+
+int _skinny_has_vec512(void)
+{
+    if (skinny_has_vec512 < 0)
+        skinny_has_vec512 = skinny_detect_vec512();
+    return skinny_has_vec512;
+}
+
+uint32_t _skinny_cpu_signature(void)
+{
+    uint32_t eax = 0;
+#if SKINNY_X86_CPUID
+    uint32_t ebx = 0;
+    uint32_t ecx = 0;
+    uint32_t edx = 0;
+    __cpuid(1, eax, ebx, ecx, edx);
+#endif
+    return eax;
+}
+
 void *skinny_calloc(size_t size, void **base_ptr)
 {
-    /* We use 256-bit aligned structures in some of the back ends but
+    /* We use 512-bit aligned structures in some of the back ends but
        calloc() may align to less than that.  This wrapper fixes things */
-    void *ptr = calloc(1, size + 31);
+    void *ptr = calloc(1, size + 63);
     if (ptr) {
         *base_ptr = ptr;
-        ptr = (void *)((((uintptr_t)ptr) + 31) & ~((uintptr_t)31));
+        ptr = (void *)((((uintptr_t)ptr) + 63) & ~((uintptr_t)63));
     }
     return ptr;
 }
+
+#if SKINNY_STATS
+
+SKINNY_THREAD_LOCAL SkinnyStats_t _skinny_stats;
+
+int skinny_stats_snapshot(SkinnyStats_t *stats)
+{
+    if (stats)
+        *stats = _skinny_stats;
+    return 1;
+}
+
+void skinny_stats_reset(void)
+{
+    memset(&_skinny_stats, 0, sizeof(_skinny_stats));
+}
+
+#else /* !SKINNY_STATS */
+
+int skinny_stats_snapshot(SkinnyStats_t *stats)
+{
+    if (stats)
+        memset(stats, 0, sizeof(SkinnyStats_t));
+    return 0;
+}
+
+void skinny_stats_reset(void)
+{
+}
+
+#endif /* !SKINNY_STATS */
@@ -59,10 +59,51 @@
 #define SKINNY_LITTLE_ENDIAN 0
 #endif
 
+/* Define SKINNY_X86_TARGETS to 1 if the compiler can generate code for
+   x86 instruction set extensions on a per-function basis */
+#if (defined(__x86_64) || defined(__x86_64__) || \
+     defined(__i386) || defined(__i386__)) && \
+    (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+#define SKINNY_X86_TARGETS 1
+#else
+#define SKINNY_X86_TARGETS 0
+#endif
+
+/* The 256-bit and 512-bit back ends define SKINNY_TARGET_VEC256 or
+   SKINNY_TARGET_VEC512 before including this header.  On x86, the rest
+   of the source file is then compiled for AVX2 or AVX-512 even if the
+   global compiler flags don't enable it, and _skinny_has_vec256() or
+   _skinny_has_vec512() decides at runtime if the back end is usable.
+   Such source files must end with SKINNY_TARGET_END */
+#if SKINNY_X86_TARGETS && defined(SKINNY_TARGET_VEC512)
+#define SKINNY_TARGET_PUSHED 1
+#if defined(__clang__)
+#pragma clang attribute push \
+    (__attribute__((target("avx2,avx512f,avx512vl"))), apply_to = function)
+#else
+#pragma GCC target("avx2,avx512f,avx512vl")
+#endif
+#elif SKINNY_X86_TARGETS && defined(SKINNY_TARGET_VEC256)
+#define SKINNY_TARGET_PUSHED 1
+#if defined(__clang__)
+#pragma clang attribute push \
+    (__attribute__((target("avx2"))), apply_to = function)
+#else
+#pragma GCC target("avx2")
+#endif
+#else
+#define SKINNY_TARGET_PUSHED 0
+#endif
+#if SKINNY_TARGET_PUSHED && defined(__clang__)
+#define SKINNY_TARGET_END _Pragma("clang attribute pop")
+#else
+#define SKINNY_TARGET_END
+#endif
+
 /* Define SKINNY_VEC128_MATH to 1 if we have 128-bit SIMD Vector Extensions */
 #if defined(__GNUC__) || defined(__clang__)
 #if defined(__SSE2__) || defined(__ARM_NEON) || \
-    defined(__ARM_NEON__) || defined(__ARM_NEON_FP)
+    defined(__ARM_NEON__) || defined(__ARM_NEON_FP) || SKINNY_TARGET_PUSHED
 #define SKINNY_VEC128_MATH 1
 #else
 #define SKINNY_VEC128_MATH 0
@@ -73,7 +114,7 @@
 
 /* Define SKINNY_VEC256_MATH to 1 if we have 256-bit SIMD Vector Extensions */
 #if defined(__GNUC__) || defined(__clang__)
-#if defined(__AVX2__)
+#if defined(__AVX2__) || SKINNY_TARGET_PUSHED
 #define SKINNY_VEC256_MATH 1
 #else
 #define SKINNY_VEC256_MATH 0
@@ -82,6 +123,36 @@
 #define SKINNY_VEC256_MATH 0
 #endif
 
+/* Define SKINNY_VEC512_MATH to 1 if we have 512-bit SIMD Vector Extensions */
+#if defined(__GNUC__) || defined(__clang__)
+#if (defined(__AVX512F__) && defined(__AVX512VL__)) || \
+        (SKINNY_TARGET_PUSHED && defined(SKINNY_TARGET_VEC512))
+#define SKINNY_VEC512_MATH 1
+#else
+#define SKINNY_VEC512_MATH 0
+#endif
+#else
+#define SKINNY_VEC512_MATH 0
+#endif
+
+/* Define SKINNY_VEC128_SSSE3 to 1 if we can compile individual functions
+   with SSSE3 byte shuffles enabled, for selection at runtime */
+#if SKINNY_VEC128_MATH && defined(__SSE2__) && \
+        (defined(__GNUC__) || defined(__clang__))
+#define SKINNY_VEC128_SSSE3 1
+#define SKINNY_TARGET_SSSE3 __attribute__((target("ssse3")))
+#else
+#define SKINNY_VEC128_SSSE3 0
+#define SKINNY_TARGET_SSSE3
+#endif
+
+/* Force inlining of the round functions into their target-specific callers */
+#if defined(__GNUC__) || defined(__clang__)
+#define SKINNY_ALWAYS_INLINE STATIC_INLINE __attribute__((always_inline))
+#else
+#define SKINNY_ALWAYS_INLINE STATIC_INLINE
+#endif
+
 /* Attribute for declaring a vector type with this compiler */
 #if defined(__clang__)
 #define SKINNY_VECTOR_ATTR(words, bytes) __attribute__((ext_vector_type(words)))
@@ -91,6 +162,58 @@
 #define SKINNY_VECTORU_ATTR(words, bytes) __attribute__((vector_size(bytes), aligned(1)))
 #endif
 
+/* Define SKINNY_STATS to 1 to collect per-thread statistics on events
+   that bypass the fast paths; see skinny-stats.h */
+#ifndef SKINNY_STATS
+#define SKINNY_STATS 0
+#endif
+
+/* Storage class for per-thread variables.  The statistics counters must
+   not silently become a shared global, so refuse to build them without it */
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && \
+        !defined(__STDC_NO_THREADS__)
+#define SKINNY_THREAD_LOCAL _Thread_local
+#elif defined(__GNUC__) || defined(__clang__)
+#define SKINNY_THREAD_LOCAL __thread
+#elif defined(_MSC_VER)
+#define SKINNY_THREAD_LOCAL __declspec(thread)
+#elif SKINNY_STATS
+#error "SKINNY_STATS requires compiler support for thread-local variables"
+#else
+#define SKINNY_THREAD_LOCAL
+#endif
+
+#if SKINNY_STATS
+#include "skinny-stats.h"
+extern SKINNY_THREAD_LOCAL SkinnyStats_t _skinny_stats;
+#define SKINNY_STAT_ADD(field, count) \
+    (_skinny_stats.field += (unsigned long long)(count))
+#else
+#define SKINNY_STAT_ADD(field, count) do { ; } while (0)
+#endif
+
+/* Define SKINNY_USDT to 1 to compile in SystemTap/USDT static probe
+   points for the "skinny" provider.  Disabled probes cost a single
+   no-op instruction, and they can be attached to with bpftrace,
+   perf or SystemTap without rebuilding the library */
+#ifndef SKINNY_USDT
+#define SKINNY_USDT 0
+#endif
+
+#if SKINNY_USDT
+#include <sys/sdt.h>
+#define SKINNY_PROBE1(name, a) DTRACE_PROBE1(skinny, name, a)
+#define SKINNY_PROBE2(name, a, b) DTRACE_PROBE2(skinny, name, a, b)
+#define SKINNY_PROBE3(name, a, b, c) DTRACE_PROBE3(skinny, name, a, b, c)
+#else
+/* Reference the arguments so that values kept only for probes do not
+   trigger unused variable warnings */
+#define SKINNY_PROBE1(name, a) do { (void)(a); } while (0)
+#define SKINNY_PROBE2(name, a, b) do { (void)(a); (void)(b); } while (0)
+#define SKINNY_PROBE3(name, a, b, c) \
+    do { (void)(a); (void)(b); (void)(c); } while (0)
+#endif
+
 /* XOR two blocks together of arbitrary size and alignment */
 STATIC_INLINE void skinny_xor
     (void *output, const void *input1, const void *input2, size_t size)
@@ -174,6 +297,19 @@ STATIC_INLINE void skinny64_inc_counter(uint8_t *counter, uint16_t inc)
     }
 }
 
+/* Convert a host-endian 64-bit value to or from little-endian byte order */
+STATIC_INLINE uint64_t skinny_le64(uint64_t x)
+{
+#if SKINNY_LITTLE_ENDIAN
+    return x;
+#else
+    x = ((x & 0x00FF00FF00FF00FFULL) << 8) | ((x >> 8) & 0x00FF00FF00FF00FFULL);
+    x = ((x & 0x0000FFFF0000FFFFULL) << 16) |
+        ((x >> 16) & 0x0000FFFF0000FFFFULL);
+    return (x << 32) | (x >> 32);
+#endif
+}
+
 #define READ_BYTE(ptr,offset) \
     ((uint32_t)(((const uint8_t *)(ptr))[(offset)]))
 
@@ -217,6 +353,22 @@ STATIC_INLINE void skinny64_inc_counter(uint8_t *counter, uint16_t inc)
      (((uint8_t *)(ptr))[(offset) + 6] = (uint8_t)((value) >> 48)), \
      (((uint8_t *)(ptr))[(offset) + 7] = (uint8_t)((value) >> 56)))
 
+/* XOR a 16-bit keystream word into the input and write it to the output */
+STATIC_INLINE void skinny_xor_word16
+    (void *output, const void *input, unsigned offset, uint16_t value)
+{
+    value ^= READ_WORD16(input, offset);
+    WRITE_WORD16(output, offset, value);
+}
+
+/* XOR a 32-bit keystream word into the input and write it to the output */
+STATIC_INLINE void skinny_xor_word32
+    (void *output, const void *input, unsigned offset, uint32_t value)
+{
+    value ^= READ_WORD32(input, offset);
+    WRITE_WORD32(output, offset, value);
+}
+
 STATIC_INLINE void skinny_cleanse(void *ptr, size_t size)
 {
 #if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
@@ -254,14 +406,74 @@ STATIC_INLINE SkinnyVector8x16_t skinny_to_vec8x16(uint16_t x)
     return (SkinnyVector8x16_t){x, x, x, x, x, x, x, x};
 }
 
+/* Transpose four rows of eight 16-bit cells back into eight 64-bit blocks;
+   on exit, out[i] holds the cells of blocks 2 * i and 2 * i + 1 in order */
+STATIC_INLINE void skinny_transpose_8x16
+    (SkinnyVector8x16_t *out, SkinnyVector8x16_t row0,
+     SkinnyVector8x16_t row1, SkinnyVector8x16_t row2,
+     SkinnyVector8x16_t row3)
+{
+#if defined(__clang__)
+    SkinnyVector4x32_t t0 = (SkinnyVector4x32_t)
+        __builtin_shufflevector(row0, row1, 0, 8, 1, 9, 2, 10, 3, 11);
+    SkinnyVector4x32_t t1 = (SkinnyVector4x32_t)
+        __builtin_shufflevector(row0, row1, 4, 12, 5, 13, 6, 14, 7, 15);
+    SkinnyVector4x32_t t2 = (SkinnyVector4x32_t)
+        __builtin_shufflevector(row2, row3, 0, 8, 1, 9, 2, 10, 3, 11);
+    SkinnyVector4x32_t t3 = (SkinnyVector4x32_t)
+        __builtin_shufflevector(row2, row3, 4, 12, 5, 13, 6, 14, 7, 15);
+    out[0] = (SkinnyVector8x16_t)__builtin_shufflevector(t0, t2, 0, 4, 1, 5);
+    out[1] = (SkinnyVector8x16_t)__builtin_shufflevector(t0, t2, 2, 6, 3, 7);
+    out[2] = (SkinnyVector8x16_t)__builtin_shufflevector(t1, t3, 0, 4, 1, 5);
+    out[3] = (SkinnyVector8x16_t)__builtin_shufflevector(t1, t3, 2, 6, 3, 7);
+#else
+    const SkinnyVector8x16_t lo16 = {0, 8, 1, 9, 2, 10, 3, 11};
+    const SkinnyVector8x16_t hi16 = {4, 12, 5, 13, 6, 14, 7, 15};
+    const SkinnyVector4x32_t lo32 = {0, 4, 1, 5};
+    const SkinnyVector4x32_t hi32 = {2, 6, 3, 7};
+    SkinnyVector4x32_t t0 =
+        (SkinnyVector4x32_t)__builtin_shuffle(row0, row1, lo16);
+    SkinnyVector4x32_t t1 =
+        (SkinnyVector4x32_t)__builtin_shuffle(row0, row1, hi16);
+    SkinnyVector4x32_t t2 =
+        (SkinnyVector4x32_t)__builtin_shuffle(row2, row3, lo16);
+    SkinnyVector4x32_t t3 =
+        (SkinnyVector4x32_t)__builtin_shuffle(row2, row3, hi16);
+    out[0] = (SkinnyVector8x16_t)__builtin_shuffle(t0, t2, lo32);
+    out[1] = (SkinnyVector8x16_t)__builtin_shuffle(t0, t2, hi32);
+    out[2] = (SkinnyVector8x16_t)__builtin_shuffle(t1, t3, lo32);
+    out[3] = (SkinnyVector8x16_t)__builtin_shuffle(t1, t3, hi32);
+#endif
+}
+
 #endif /* SKINNY_VEC128_MATH */
 
+#if SKINNY_VEC128_SSSE3
+
+#include <tmmintrin.h>
+
+/* Apply a 4-bit S-box to all nibbles of a vector with two byte shuffles.
+   The "lo" table holds the S-box and "hi" holds it shifted up by 4 bits */
+SKINNY_TARGET_SSSE3 STATIC_INLINE SkinnyVector8x16_t skinny_sbox4_vec128
+    (SkinnyVector8x16_t x, __m128i lo, __m128i hi)
+{
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    __m128i y = (__m128i)x;
+    lo = _mm_shuffle_epi8(lo, _mm_and_si128(y, mask));
+    hi = _mm_shuffle_epi8(hi, _mm_and_si128(_mm_srli_epi16(y, 4), mask));
+    return (SkinnyVector8x16_t)_mm_or_si128(lo, hi);
+}
+
+#endif /* SKINNY_VEC128_SSSE3 */
+
 #if SKINNY_VEC256_MATH
 
 /* Define types that fit within a 256-bit SIMD vector */
 typedef uint32_t SkinnyVector8x32_t SKINNY_VECTOR_ATTR(8, 32);
+typedef uint16_t SkinnyVector16x16_t SKINNY_VECTOR_ATTR(16, 32);
 #if SKINNY_UNALIGNED
 typedef uint32_t SkinnyVector8x32U_t SKINNY_VECTORU_ATTR(8, 32);
+typedef uint16_t SkinnyVector16x16U_t SKINNY_VECTORU_ATTR(16, 32);
 #endif
 
 /* Convert a scalar value into a 8x32 SIMD vector */
@@ -270,15 +482,197 @@ STATIC_INLINE SkinnyVector8x32_t skinny_to_vec8x32(uint32_t x)
     return (SkinnyVector8x32_t){x, x, x, x, x, x, x, x};
 }
 
+/* Convert a scalar value into a 16x16 SIMD vector */
+STATIC_INLINE SkinnyVector16x16_t skinny_to_vec16x16(uint16_t x)
+{
+    return (SkinnyVector16x16_t){x, x, x, x, x, x, x, x,
+                                 x, x, x, x, x, x, x, x};
+}
+
+#include <immintrin.h>
+
+/* Apply a 4-bit S-box to all nibbles of a vector with two byte shuffles.
+   The "lo" table holds the S-box and "hi" holds it shifted up by 4 bits;
+   both tables must be repeated in each 128-bit half of the vector */
+STATIC_INLINE SkinnyVector16x16_t skinny_sbox4_vec256
+    (SkinnyVector16x16_t x, __m256i lo, __m256i hi)
+{
+    const __m256i mask = _mm256_set1_epi8(0x0F);
+    __m256i y = (__m256i)x;
+    lo = _mm256_shuffle_epi8(lo, _mm256_and_si256(y, mask));
+    hi = _mm256_shuffle_epi8
+        (hi, _mm256_and_si256(_mm256_srli_epi16(y, 4), mask));
+    return (SkinnyVector16x16_t)_mm256_or_si256(lo, hi);
+}
+
+/* Load sixteen consecutive 64-bit blocks and transpose them into four rows
+   of sixteen 16-bit cells, where lane i of each row belongs to block i */
+STATIC_INLINE void skinny_load_rows_16x16
+    (SkinnyVector16x16_t *rows, const void *input)
+{
+    __m256i v0 = _mm256_loadu_si256((const __m256i *)input);
+    __m256i v1 = _mm256_loadu_si256(((const __m256i *)input) + 1);
+    __m256i v2 = _mm256_loadu_si256(((const __m256i *)input) + 2);
+    __m256i v3 = _mm256_loadu_si256(((const __m256i *)input) + 3);
+    __m256i t0, t1, t2, t3;
+
+    /* Put blocks 0-7 in the low halves and blocks 8-15 in the high halves */
+    t0 = _mm256_permute2x128_si256(v0, v2, 0x20);
+    t1 = _mm256_permute2x128_si256(v0, v2, 0x31);
+    t2 = _mm256_permute2x128_si256(v1, v3, 0x20);
+    t3 = _mm256_permute2x128_si256(v1, v3, 0x31);
+
+    /* Transpose the 16-bit cells within each 128-bit half */
+    v0 = _mm256_unpacklo_epi16(t0, t1);
+    v1 = _mm256_unpackhi_epi16(t0, t1);
+    v2 = _mm256_unpacklo_epi16(t2, t3);
+    v3 = _mm256_unpackhi_epi16(t2, t3);
+    t0 = _mm256_unpacklo_epi16(v0, v1);
+    t1 = _mm256_unpackhi_epi16(v0, v1);
+    t2 = _mm256_unpacklo_epi16(v2, v3);
+    t3 = _mm256_unpackhi_epi16(v2, v3);
+    rows[0] = (SkinnyVector16x16_t)_mm256_unpacklo_epi64(t0, t2);
+    rows[1] = (SkinnyVector16x16_t)_mm256_unpackhi_epi64(t0, t2);
+    rows[2] = (SkinnyVector16x16_t)_mm256_unpacklo_epi64(t1, t3);
+    rows[3] = (SkinnyVector16x16_t)_mm256_unpackhi_epi64(t1, t3);
+}
+
+/* Transpose four rows of sixteen 16-bit cells back into sixteen 64-bit
+   blocks; on exit, out[i] holds blocks 4 * i to 4 * i + 3 in order */
+STATIC_INLINE void skinny_transpose_16x16
+    (SkinnyVector16x16_t *out, SkinnyVector16x16_t row0,
+     SkinnyVector16x16_t row1, SkinnyVector16x16_t row2,
+     SkinnyVector16x16_t row3)
+{
+    __m256i t0 = _mm256_unpacklo_epi16((__m256i)row0, (__m256i)row1);
+    __m256i t1 = _mm256_unpackhi_epi16((__m256i)row0, (__m256i)row1);
+    __m256i t2 = _mm256_unpacklo_epi16((__m256i)row2, (__m256i)row3);
+    __m256i t3 = _mm256_unpackhi_epi16((__m256i)row2, (__m256i)row3);
+    __m256i v0 = _mm256_unpacklo_epi32(t0, t2);
+    __m256i v1 = _mm256_unpackhi_epi32(t0, t2);
+    __m256i v2 = _mm256_unpacklo_epi32(t1, t3);
+    __m256i v3 = _mm256_unpackhi_epi32(t1, t3);
+    out[0] = (SkinnyVector16x16_t)_mm256_permute2x128_si256(v0, v1, 0x20);
+    out[1] = (SkinnyVector16x16_t)_mm256_permute2x128_si256(v2, v3, 0x20);
+    out[2] = (SkinnyVector16x16_t)_mm256_permute2x128_si256(v0, v1, 0x31);
+    out[3] = (SkinnyVector16x16_t)_mm256_permute2x128_si256(v2, v3, 0x31);
+}
+
 #endif /* SKINNY_VEC256_MATH */
 
+#if SKINNY_VEC512_MATH
+
+/* Define types that fit within a 512-bit SIMD vector */
+typedef uint32_t SkinnyVector16x32_t SKINNY_VECTOR_ATTR(16, 64);
+
+/* Convert a scalar value into a 16x32 SIMD vector */
+STATIC_INLINE SkinnyVector16x32_t skinny_to_vec16x32(uint32_t x)
+{
+    return (SkinnyVector16x32_t){x, x, x, x, x, x, x, x,
+                                 x, x, x, x, x, x, x, x};
+}
+
+/* Evaluate an arbitrary three-input bitwise function with VPTERNLOGD.
+   The "func" truth table is indexed by the bits of (a, b, c) */
+#define skinny_ternlog_16x32(a, b, c, func) \
+    ((SkinnyVector16x32_t)_mm512_ternarylogic_epi32 \
+        ((__m512i)(a), (__m512i)(b), (__m512i)(c), (func)))
+
+/* Load sixteen consecutive 128-bit blocks and transpose them into four
+   rows of sixteen 32-bit words, where lane i of each row belongs to block i */
+STATIC_INLINE void skinny_load_rows_16x32
+    (SkinnyVector16x32_t *rows, const void *input)
+{
+    const __m512i even = _mm512_setr_epi32
+        (0, 4, 8, 12, 16, 20, 24, 28, 1, 5, 9, 13, 17, 21, 25, 29);
+    const __m512i odd = _mm512_setr_epi32
+        (2, 6, 10, 14, 18, 22, 26, 30, 3, 7, 11, 15, 19, 23, 27, 31);
+    __m512i v0 = _mm512_loadu_si512(input);
+    __m512i v1 = _mm512_loadu_si512(((const __m512i *)input) + 1);
+    __m512i v2 = _mm512_loadu_si512(((const __m512i *)input) + 2);
+    __m512i v3 = _mm512_loadu_si512(((const __m512i *)input) + 3);
+    __m512i t0, t1, t2, t3;
+
+    /* Gather rows 0/1 and rows 2/3 of blocks 0-7 and blocks 8-15 */
+    t0 = _mm512_permutex2var_epi32(v0, even, v1);
+    t1 = _mm512_permutex2var_epi32(v0, odd, v1);
+    t2 = _mm512_permutex2var_epi32(v2, even, v3);
+    t3 = _mm512_permutex2var_epi32(v2, odd, v3);
+
+    /* Join the halves for blocks 0-7 and 8-15 into full rows */
+    rows[0] = (SkinnyVector16x32_t)_mm512_shuffle_i64x2(t0, t2, 0x44);
+    rows[1] = (SkinnyVector16x32_t)_mm512_shuffle_i64x2(t0, t2, 0xEE);
+    rows[2] = (SkinnyVector16x32_t)_mm512_shuffle_i64x2(t1, t3, 0x44);
+    rows[3] = (SkinnyVector16x32_t)_mm512_shuffle_i64x2(t1, t3, 0xEE);
+}
+
+/* Transpose four rows of sixteen 32-bit words back into sixteen 128-bit
+   blocks; on exit, out[i] holds blocks 4 * i to 4 * i + 3 in order */
+STATIC_INLINE void skinny_transpose_16x32
+    (__m512i *out, SkinnyVector16x32_t row0, SkinnyVector16x32_t row1,
+     SkinnyVector16x32_t row2, SkinnyVector16x32_t row3)
+{
+    const __m512i lo32 = _mm512_setr_epi32
+        (0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23);
+    const __m512i hi32 = _mm512_setr_epi32
+        (8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31);
+    const __m512i lo64 = _mm512_setr_epi64(0, 8, 1, 9, 2, 10, 3, 11);
+    const __m512i hi64 = _mm512_setr_epi64(4, 12, 5, 13, 6, 14, 7, 15);
+    __m512i t0, t1, t2, t3;
+
+    /* Pair up the words of rows 0/1 and rows 2/3 for each block */
+    t0 = _mm512_permutex2var_epi32((__m512i)row0, lo32, (__m512i)row1);
+    t1 = _mm512_permutex2var_epi32((__m512i)row0, hi32, (__m512i)row1);
+    t2 = _mm512_permutex2var_epi32((__m512i)row2, lo32, (__m512i)row3);
+    t3 = _mm512_permutex2var_epi32((__m512i)row2, hi32, (__m512i)row3);
+
+    /* Interleave the pairs to form complete blocks */
+    out[0] = _mm512_permutex2var_epi64(t0, lo64, t2);
+    out[1] = _mm512_permutex2var_epi64(t0, hi64, t2);
+    out[2] = _mm512_permutex2var_epi64(t1, lo64, t3);
+    out[3] = _mm512_permutex2var_epi64(t1, hi64, t3);
+}
+
+#endif /* SKINNY_VEC512_MATH */
+
 /* Determine if this platform supports 128-bit SIMD vector operations */
 int _skinny_has_vec128(void);
 
+/* Determine if this platform supports SSSE3 byte shuffles on 128-bit vectors */
+int _skinny_has_vec128_ssse3(void);
+
 /* Determine if this platform supports 256-bit SIMD vector operations */
 int _skinny_has_vec256(void);
 
+/* Determine if this platform supports 512-bit SIMD vector operations */
+int _skinny_has_vec512(void);
+
 /* Allocate cleared memory and guarantee SIMD-compatible alignment */
 void *skinny_calloc(size_t size, void **base_ptr);
 
+/* Returns a value that identifies the CPU family, model and stepping,
+   or zero if the platform does not have a way to find out */
+uint32_t _skinny_cpu_signature(void);
+
+/* Maximum number of back ends for a single mode of operation */
+#define SKINNY_AUTOTUNE_MAX_BACKENDS 4
+
+/* Size of the bulk workload that the autotuner uses to time back ends */
+#define SKINNY_AUTOTUNE_SIZE 4096
+
+/* Runs "op" several times and returns the best time in nanoseconds */
+uint64_t _skinny_autotune_measure(void (*op)(void *arg), void *arg);
+
+/* Autotuning hooks for the CTR and parallel ECB dispatchers.  If "name"
+   is not NULL, then the back end with that name is selected.  Otherwise
+   the available back ends are timed and the fastest one is selected.
+   Returns the name of the selected back end, or NULL if "name" is not
+   available on this platform */
+const char *_skinny128_ctr_autotune(const char *name);
+const char *_skinny128_parallel_ecb_autotune(const char *name);
+const char *_skinny64_ctr_autotune(const char *name);
+const char *_skinny64_parallel_ecb_autotune(const char *name);
+const char *_mantis_ctr_autotune(const char *name);
+const char *_mantis_parallel_ecb_autotune(const char *name);
+
 #endif /* SKINNY_INTERNAL_H */
@@ -317,6 +317,7 @@ int skinny128_set_key(Skinny128Key_t *ks, const void *key, unsigned size)
 
     /* Set the key directly with no tweak */
     skinny128_set_key_inner(ks, key, size, 0);
+    SKINNY_PROBE2(skinny128_set_key, ks, size);
     return 1;
 }
 
@@ -334,6 +335,7 @@ int skinny128_set_tweaked_key
 
     /* Set the initial key and tweak value */
     skinny128_set_key_inner(&(ks->ks), key, key_size, ks->tweak);
+    SKINNY_PROBE2(skinny128_set_tweaked_key, ks, key_size);
     return 1;
 }
 
@@ -353,10 +355,12 @@ int skinny128_set_tweak
     memset(ks->tweak + tweak_size, 0, sizeof(ks->tweak) - tweak_size);
 
     /* XOR the original tweak out of the key schedule */
+    SKINNY_STAT_ADD(tweak_rewrites, 1);
     skinny128_xor_tk1(&(ks->ks), tk_prev);
 
     /* XOR the new tweak into the key schedule */
     skinny128_xor_tk1(&(ks->ks), ks->tweak);
+    SKINNY_PROBE2(skinny128_set_tweak, ks, tweak_size);
     return 1;
 }
 
@@ -529,121 +533,206 @@ STATIC_INLINE uint32_t skinny128_inv_sbox(uint32_t x)
 
 #endif
 
+/* Applies the S-box to two rows of the state.  The S-box operates on
+   bytes, so the order in which the rows are paired up does not matter */
+STATIC_INLINE void skinny128_sbox_two(uint32_t *x, uint32_t *y)
+{
+#if SKINNY_64BIT
+    uint64_t pair = skinny128_sbox(*x | (((uint64_t)(*y)) << 32));
+    *x = (uint32_t)pair;
+    *y = (uint32_t)(pair >> 32);
+#else
+    *x = skinny128_sbox(*x);
+    *y = skinny128_sbox(*y);
+#endif
+}
+
+STATIC_INLINE void skinny128_inv_sbox_two(uint32_t *x, uint32_t *y)
+{
+#if SKINNY_64BIT
+    uint64_t pair = skinny128_inv_sbox(*x | (((uint64_t)(*y)) << 32));
+    *x = (uint32_t)pair;
+    *y = (uint32_t)(pair >> 32);
+#else
+    *x = skinny128_inv_sbox(*x);
+    *y = skinny128_inv_sbox(*y);
+#endif
+}
+
+/* Performs a single encryption round on a state that is held in four
+   row words.  The rows are kept in locals rather than Skinny128Cells_t
+   so that the compiler does not bounce the state through memory */
+STATIC_INLINE void skinny128_encrypt_round
+    (uint32_t *row0, uint32_t *row1, uint32_t *row2, uint32_t *row3,
+     const Skinny128HalfCells_t *schedule)
+{
+    uint32_t temp;
+
+    /* Apply the S-box to all bytes in the state */
+    skinny128_sbox_two(row0, row1);
+    skinny128_sbox_two(row2, row3);
+
+    /* Apply the subkey for this round and shift the rows */
+    *row0 ^= schedule->row[0];
+    *row1 = skinny128_rotate_right(*row1 ^ schedule->row[1], 8);
+    *row2 = skinny128_rotate_right(*row2 ^ 0x02, 16);
+    *row3 = skinny128_rotate_right(*row3, 24);
+
+    /* Mix the columns */
+    *row1 ^= *row2;
+    *row2 ^= *row0;
+    temp = *row3 ^ *row2;
+    *row3 = *row2;
+    *row2 = *row1;
+    *row1 = *row0;
+    *row0 = temp;
+}
+
+/* Performs a single decryption round on a state that is held in four
+   row words, with the inverse linear layers folded together */
+STATIC_INLINE void skinny128_decrypt_round
+    (uint32_t *row0, uint32_t *row1, uint32_t *row2, uint32_t *row3,
+     const Skinny128HalfCells_t *schedule)
+{
+    uint32_t temp;
+
+    /* Inverse mix of the columns and inverse shift of the rows,
+       combined with the subkey and round constant for this round */
+    temp = *row1 ^ *row3;
+    *row3 = skinny128_rotate_right(*row0 ^ *row3, 8);
+    *row0 = *row1 ^ schedule->row[0];
+    *row1 = skinny128_rotate_right(temp ^ *row2, 24) ^ schedule->row[1];
+    *row2 = skinny128_rotate_right(temp, 16) ^ 0x02;
+
+    /* Apply the inverse of the S-box to all bytes in the state */
+    skinny128_inv_sbox_two(row0, row1);
+    skinny128_inv_sbox_two(row2, row3);
+}
+
 void skinny128_ecb_encrypt
     (void *output, const void *input, const Skinny128Key_t *ks)
 {
-    Skinny128Cells_t state;
+    uint32_t row0, row1, row2, row3;
     const Skinny128HalfCells_t *schedule;
     unsigned index;
-    uint32_t temp;
 
     /* Read the input buffer and convert little-endian to host-endian */
-    state.row[0] = READ_WORD32(input, 0);
-    state.row[1] = READ_WORD32(input, 4);
-    state.row[2] = READ_WORD32(input, 8);
-    state.row[3] = READ_WORD32(input, 12);
+    row0 = READ_WORD32(input, 0);
+    row1 = READ_WORD32(input, 4);
+    row2 = READ_WORD32(input, 8);
+    row3 = READ_WORD32(input, 12);
 
     /* Perform all encryption rounds */
     schedule = ks->schedule;
-    for (index = ks->rounds; index > 0; --index, ++schedule) {
-        /* Apply the S-box to all bytes in the state */
-#if SKINNY_64BIT
-        state.lrow[0] = skinny128_sbox(state.lrow[0]);
-        state.lrow[1] = skinny128_sbox(state.lrow[1]);
-#else
-        state.row[0] = skinny128_sbox(state.row[0]);
-        state.row[1] = skinny128_sbox(state.row[1]);
-        state.row[2] = skinny128_sbox(state.row[2]);
-        state.row[3] = skinny128_sbox(state.row[3]);
-#endif
-
-        /* Apply the subkey for this round */
-#if SKINNY_64BIT
-        state.lrow[0] ^= schedule->lrow;
-        state.lrow[1] ^= 0x02;
-#else
-        state.row[0] ^= schedule->row[0];
-        state.row[1] ^= schedule->row[1];
-        state.row[2] ^= 0x02;
-#endif
-
-        /* Shift the rows */
-        state.row[1] = skinny128_rotate_right(state.row[1], 8);
-        state.row[2] = skinny128_rotate_right(state.row[2], 16);
-        state.row[3] = skinny128_rotate_right(state.row[3], 24);
-
-        /* Mix the columns */
-        state.row[1] ^= state.row[2];
-        state.row[2] ^= state.row[0];
-        temp = state.row[3] ^ state.row[2];
-        state.row[3] = state.row[2];
-        state.row[2] = state.row[1];
-        state.row[1] = state.row[0];
-        state.row[0] = temp;
-    }
+    for (index = ks->rounds; index > 0; --index, ++schedule)
+        skinny128_encrypt_round(&row0, &row1, &row2, &row3, schedule);
 
     /* Convert host-endian back into little-endian in the output buffer */
-    WRITE_WORD32(output, 0, state.row[0]);
-    WRITE_WORD32(output, 4, state.row[1]);
-    WRITE_WORD32(output, 8, state.row[2]);
-    WRITE_WORD32(output, 12, state.row[3]);
+    WRITE_WORD32(output, 0, row0);
+    WRITE_WORD32(output, 4, row1);
+    WRITE_WORD32(output, 8, row2);
+    WRITE_WORD32(output, 12, row3);
 }
 
 void skinny128_ecb_decrypt
     (void *output, const void *input, const Skinny128Key_t *ks)
 {
-    Skinny128Cells_t state;
+    uint32_t row0, row1, row2, row3;
     const Skinny128HalfCells_t *schedule;
     unsigned index;
-    uint32_t temp;
 
     /* Read the input buffer and convert little-endian to host-endian */
-    state.row[0] = READ_WORD32(input, 0);
-    state.row[1] = READ_WORD32(input, 4);
-    state.row[2] = READ_WORD32(input, 8);
-    state.row[3] = READ_WORD32(input, 12);
+    row0 = READ_WORD32(input, 0);
+    row1 = READ_WORD32(input, 4);
+    row2 = READ_WORD32(input, 8);
+    row3 = READ_WORD32(input, 12);
 
     /* Perform all decryption rounds */
     schedule = &(ks->schedule[ks->rounds - 1]);
-    for (index = ks->rounds; index > 0; --index, --schedule) {
-        /* Inverse mix of the columns */
-        temp = state.row[3];
-        state.row[3] = state.row[0];
-        state.row[0] = state.row[1];
-        state.row[1] = state.row[2];
-        state.row[3] ^= temp;
-        state.row[2] = temp ^ state.row[0];
-        state.row[1] ^= state.row[2];
-
-        /* Inverse shift of the rows */
-        state.row[1] = skinny128_rotate_right(state.row[1], 24);
-        state.row[2] = skinny128_rotate_right(state.row[2], 16);
-        state.row[3] = skinny128_rotate_right(state.row[3], 8);
-
-        /* Apply the subkey for this round */
-#if SKINNY_64BIT
-        state.lrow[0] ^= schedule->lrow;
-#else
-        state.row[0] ^= schedule->row[0];
-        state.row[1] ^= schedule->row[1];
-#endif
-        state.row[2] ^= 0x02;
+    for (index = ks->rounds; index > 0; --index, --schedule)
+        skinny128_decrypt_round(&row0, &row1, &row2, &row3, schedule);
 
-        /* Apply the inverse of the S-box to all bytes in the state */
-#if SKINNY_64BIT
-        state.lrow[0] = skinny128_inv_sbox(state.lrow[0]);
-        state.lrow[1] = skinny128_inv_sbox(state.lrow[1]);
-#else
-        state.row[0] = skinny128_inv_sbox(state.row[0]);
-        state.row[1] = skinny128_inv_sbox(state.row[1]);
-        state.row[2] = skinny128_inv_sbox(state.row[2]);
-        state.row[3] = skinny128_inv_sbox(state.row[3]);
-#endif
+    /* Convert host-endian back into little-endian in the output buffer */
+    WRITE_WORD32(output, 0, row0);
+    WRITE_WORD32(output, 4, row1);
+    WRITE_WORD32(output, 8, row2);
+    WRITE_WORD32(output, 12, row3);
+}
+
+/* The following encrypt or decrypt two blocks at a time with the rounds
+   for both blocks interleaved.  This gives the instruction scheduler
+   independent work to fill the integer pipelines with on platforms
+   that don't have SIMD support.  Two blocks is the sweet spot; with
+   four blocks, the state no longer fits in the register file */
+
+void _skinny128_parallel_encrypt_x2
+    (void *output, const void *input, const Skinny128Key_t *ks)
+{
+    uint32_t a0, a1, a2, a3;
+    uint32_t b0, b1, b2, b3;
+    const Skinny128HalfCells_t *schedule;
+    unsigned index;
+
+    /* Read the rows of both blocks */
+    a0 = READ_WORD32(input, 0);
+    a1 = READ_WORD32(input, 4);
+    a2 = READ_WORD32(input, 8);
+    a3 = READ_WORD32(input, 12);
+    b0 = READ_WORD32(input, 16);
+    b1 = READ_WORD32(input, 20);
+    b2 = READ_WORD32(input, 24);
+    b3 = READ_WORD32(input, 28);
+
+    /* Perform all encryption rounds on the two blocks */
+    schedule = ks->schedule;
+    for (index = ks->rounds; index > 0; --index, ++schedule) {
+        skinny128_encrypt_round(&a0, &a1, &a2, &a3, schedule);
+        skinny128_encrypt_round(&b0, &b1, &b2, &b3, schedule);
     }
 
-    /* Convert host-endian back into little-endian in the output buffer */
-    WRITE_WORD32(output, 0, state.row[0]);
-    WRITE_WORD32(output, 4, state.row[1]);
-    WRITE_WORD32(output, 8, state.row[2]);
-    WRITE_WORD32(output, 12, state.row[3]);
+    /* Write the rows of both blocks back to memory */
+    WRITE_WORD32(output,  0, a0);
+    WRITE_WORD32(output,  4, a1);
+    WRITE_WORD32(output,  8, a2);
+    WRITE_WORD32(output, 12, a3);
+    WRITE_WORD32(output, 16, b0);
+    WRITE_WORD32(output, 20, b1);
+    WRITE_WORD32(output, 24, b2);
+    WRITE_WORD32(output, 28, b3);
+}
+
+void _skinny128_parallel_decrypt_x2
+    (void *output, const void *input, const Skinny128Key_t *ks)
+{
+    uint32_t a0, a1, a2, a3;
+    uint32_t b0, b1, b2, b3;
+    const Skinny128HalfCells_t *schedule;
+    unsigned index;
+
+    /* Read the rows of both blocks */
+    a0 = READ_WORD32(input, 0);
+    a1 = READ_WORD32(input, 4);
+    a2 = READ_WORD32(input, 8);
+    a3 = READ_WORD32(input, 12);
+    b0 = READ_WORD32(input, 16);
+    b1 = READ_WORD32(input, 20);
+    b2 = READ_WORD32(input, 24);
+    b3 = READ_WORD32(input, 28);
+
+    /* Perform all decryption rounds on the two blocks */
+    schedule = &(ks->schedule[ks->rounds - 1]);
+    for (index = ks->rounds; index > 0; --index, --schedule) {
+        skinny128_decrypt_round(&a0, &a1, &a2, &a3, schedule);
+        skinny128_decrypt_round(&b0, &b1, &b2, &b3, schedule);
+    }
+
+    /* Write the rows of both blocks back to memory */
+    WRITE_WORD32(output,  0, a0);
+    WRITE_WORD32(output,  4, a1);
+    WRITE_WORD32(output,  8, a2);
+    WRITE_WORD32(output, 12, a3);
+    WRITE_WORD32(output, 16, b0);
+    WRITE_WORD32(output, 20, b1);
+    WRITE_WORD32(output, 24, b2);
+    WRITE_WORD32(output, 28, b3);
 }
@@ -42,10 +42,16 @@ typedef struct
         (Skinny128CTR_t *ctr, const void *counter, unsigned size);
     int (*encrypt)
         (void *output, const void *input, size_t size, Skinny128CTR_t *ctr);
+    const char *name;
 
 } Skinny128CTRVtable_t;
 
+/* Encrypts two blocks at a time with interleaved scalar code */
+void _skinny128_parallel_encrypt_x2
+    (void *output, const void *input, const Skinny128Key_t *ks);
+
 extern Skinny128CTRVtable_t const _skinny128_ctr_vec128;
 extern Skinny128CTRVtable_t const _skinny128_ctr_vec256;
+extern Skinny128CTRVtable_t const _skinny128_ctr_vec512;
 
 #endif /* SKINNY128_CTR_INTERNAL_H */
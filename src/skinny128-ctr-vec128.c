@@ -36,6 +36,9 @@ typedef struct
     /** Key schedule for Skinny-128, with an optional tweak */
     Skinny128TweakedKey_t kt;
 
+    /** Round keys from kt, pre-broadcast into vectors */
+    SkinnyVector4x32_t schedule[SKINNY128_MAX_ROUNDS][2];
+
     /** Counter values for the next block, pre-formatted into row vectors */
     SkinnyVector4x32_t counter[4];
 
@@ -73,6 +76,22 @@ static void skinny128_ctr_vec128_cleanup(Skinny128CTR_t *ctr)
     }
 }
 
+/* Broadcast the round keys into vectors once when the key or tweak
+   changes, so that the inner loop of the cipher only needs to load them.
+   The round constants are already in rows 0 and 1.  The fixed 0x02 for
+   row 2 is left out: it is rotated and mixed differently from rows 0
+   and 1 so it cannot be merged into their subkeys, and a third vector
+   per round would turn an XOR with a constant into a load and an XOR */
+static void skinny128_ctr_vec128_expand(Skinny128CTRVec128Ctx_t *ctx)
+{
+    const Skinny128HalfCells_t *schedule = ctx->kt.ks.schedule;
+    unsigned index;
+    for (index = 0; index < ctx->kt.ks.rounds; ++index, ++schedule) {
+        ctx->schedule[index][0] = skinny_to_vec4x32(schedule->row[0]);
+        ctx->schedule[index][1] = skinny_to_vec4x32(schedule->row[1]);
+    }
+}
+
 static int skinny128_ctr_vec128_set_key
     (Skinny128CTR_t *ctr, const void *key, unsigned size)
 {
@@ -88,6 +107,7 @@ static int skinny128_ctr_vec128_set_key
     /* Populate the underlying key schedule */
     if (!skinny128_set_key(&(ctx->kt.ks), key, size))
         return 0;
+    skinny128_ctr_vec128_expand(ctx);
 
     /* Reset the keystream */
     ctx->offset = SKINNY128_CTR_BLOCK_SIZE;
@@ -109,6 +129,7 @@ static int skinny128_ctr_vec128_set_tweaked_key
     /* Populate the underlying key schedule */
     if (!skinny128_set_tweaked_key(&(ctx->kt), key, key_size))
         return 0;
+    skinny128_ctr_vec128_expand(ctx);
 
     /* Reset the keystream */
     ctx->offset = SKINNY128_CTR_BLOCK_SIZE;
@@ -128,6 +149,7 @@ static int skinny128_ctr_vec128_set_tweak
     /* Populate the underlying tweak */
     if (!skinny128_set_tweak(&(ctx->kt), tweak, tweak_size))
         return 0;
+    skinny128_ctr_vec128_expand(ctx);
 
     /* Reset the keystream */
     ctx->offset = SKINNY128_CTR_BLOCK_SIZE;
@@ -175,6 +197,8 @@ static int skinny128_ctr_vec128_set_counter
     } else {
         memset(block, 0, SKINNY128_BLOCK_SIZE);
     }
+    SKINNY_STAT_ADD
+        (ctr_discarded_bytes, SKINNY128_CTR_BLOCK_SIZE - ctx->offset);
     ctx->offset = SKINNY128_CTR_BLOCK_SIZE;
 
     /* Load the counter block and convert into row vectors */
@@ -337,26 +361,27 @@ STATIC_INLINE void skinny128_sbox_two
 
 #endif
 
-static void skinny128_ecb_encrypt_four
-    (void *output, const SkinnyVector4x32_t *input, const Skinny128Key_t *ks)
+/* Encrypts four blocks that have already been arranged into row vectors */
+STATIC_INLINE void skinny128_encrypt_rows
+    (SkinnyVector4x32_t *rows, const Skinny128CTRVec128Ctx_t *ctx)
 {
     SkinnyVector4x32_t row0;
     SkinnyVector4x32_t row1;
     SkinnyVector4x32_t row2;
     SkinnyVector4x32_t row3;
-    const Skinny128HalfCells_t *schedule;
+    const SkinnyVector4x32_t (*schedule)[2];
     unsigned index;
     SkinnyVector4x32_t temp;
 
     /* Read the rows of all four counter blocks into memory */
-    row0 = input[0];
-    row1 = input[1];
-    row2 = input[2];
-    row3 = input[3];
+    row0 = rows[0];
+    row1 = rows[1];
+    row2 = rows[2];
+    row3 = rows[3];
 
     /* Perform all encryption rounds on the four blocks in parallel */
-    schedule = ks->schedule;
-    for (index = ks->rounds; index > 0; --index, ++schedule) {
+    schedule = ctx->schedule;
+    for (index = ctx->kt.ks.rounds; index > 0; --index, ++schedule) {
         /* Apply the S-box to all bytes in the state */
 #if SKINNY_64BIT
         skinny128_sbox_four(&row0, &row1, &row2, &row3);
@@ -366,8 +391,8 @@ static void skinny128_ecb_encrypt_four
 #endif
 
         /* Apply the subkey for this round */
-        row0 ^= schedule->row[0];
-        row1 ^= schedule->row[1];
+        row0 ^= (*schedule)[0];
+        row1 ^= (*schedule)[1];
         row2 ^= 0x02;
 
         /* Shift the rows */
@@ -385,33 +410,102 @@ static void skinny128_ecb_encrypt_four
         row0 = temp;
     }
 
+    /* Return the encrypted rows to the caller */
+    rows[0] = row0;
+    rows[1] = row1;
+    rows[2] = row2;
+    rows[3] = row3;
+}
+
+static void skinny128_ecb_encrypt_four
+    (void *output, const SkinnyVector4x32_t *input,
+     const Skinny128CTRVec128Ctx_t *ctx)
+{
+    SkinnyVector4x32_t rows[4];
+
+    /* Encrypt the four counter blocks */
+    rows[0] = input[0];
+    rows[1] = input[1];
+    rows[2] = input[2];
+    rows[3] = input[3];
+    skinny128_encrypt_rows(rows, ctx);
+
     /* Write the rows of all four blocks back to memory */
 #if SKINNY_LITTLE_ENDIAN && SKINNY_UNALIGNED
     *((SkinnyVector4x32U_t *)output) =
-        (SkinnyVector4x32_t){row0[0], row1[0], row2[0], row3[0]};
+        (SkinnyVector4x32_t){rows[0][0], rows[1][0], rows[2][0], rows[3][0]};
     *((SkinnyVector4x32U_t *)(output + 16)) =
-        (SkinnyVector4x32_t){row0[1], row1[1], row2[1], row3[1]};
+        (SkinnyVector4x32_t){rows[0][1], rows[1][1], rows[2][1], rows[3][1]};
     *((SkinnyVector4x32U_t *)(output + 32)) =
-        (SkinnyVector4x32_t){row0[2], row1[2], row2[2], row3[2]};
+        (SkinnyVector4x32_t){rows[0][2], rows[1][2], rows[2][2], rows[3][2]};
     *((SkinnyVector4x32U_t *)(output + 48)) =
-        (SkinnyVector4x32_t){row0[3], row1[3], row2[3], row3[3]};
+        (SkinnyVector4x32_t){rows[0][3], rows[1][3], rows[2][3], rows[3][3]};
 #else
-    WRITE_WORD32(output,  0, row0[0]);
-    WRITE_WORD32(output,  4, row1[0]);
-    WRITE_WORD32(output,  8, row2[0]);
-    WRITE_WORD32(output, 12, row3[0]);
-    WRITE_WORD32(output, 16, row0[1]);
-    WRITE_WORD32(output, 20, row1[1]);
-    WRITE_WORD32(output, 24, row2[1]);
-    WRITE_WORD32(output, 28, row3[1]);
-    WRITE_WORD32(output, 32, row0[2]);
-    WRITE_WORD32(output, 36, row1[2]);
-    WRITE_WORD32(output, 40, row2[2]);
-    WRITE_WORD32(output, 44, row3[2]);
-    WRITE_WORD32(output, 48, row0[3]);
-    WRITE_WORD32(output, 52, row1[3]);
-    WRITE_WORD32(output, 56, row2[3]);
-    WRITE_WORD32(output, 60, row3[3]);
+    WRITE_WORD32(output,  0, rows[0][0]);
+    WRITE_WORD32(output,  4, rows[1][0]);
+    WRITE_WORD32(output,  8, rows[2][0]);
+    WRITE_WORD32(output, 12, rows[3][0]);
+    WRITE_WORD32(output, 16, rows[0][1]);
+    WRITE_WORD32(output, 20, rows[1][1]);
+    WRITE_WORD32(output, 24, rows[2][1]);
+    WRITE_WORD32(output, 28, rows[3][1]);
+    WRITE_WORD32(output, 32, rows[0][2]);
+    WRITE_WORD32(output, 36, rows[1][2]);
+    WRITE_WORD32(output, 40, rows[2][2]);
+    WRITE_WORD32(output, 44, rows[3][2]);
+    WRITE_WORD32(output, 48, rows[0][3]);
+    WRITE_WORD32(output, 52, rows[1][3]);
+    WRITE_WORD32(output, 56, rows[2][3]);
+    WRITE_WORD32(output, 60, rows[3][3]);
+#endif
+}
+
+/* Encrypts four counter blocks and XOR's the keystream directly with
+   four blocks of input, without a round trip through ctx->ecounter */
+static void skinny128_ctr_xor_four
+    (void *output, const void *input, const SkinnyVector4x32_t *counter,
+     const Skinny128CTRVec128Ctx_t *ctx)
+{
+    SkinnyVector4x32_t rows[4];
+
+    /* Encrypt the four counter blocks */
+    rows[0] = counter[0];
+    rows[1] = counter[1];
+    rows[2] = counter[2];
+    rows[3] = counter[3];
+    skinny128_encrypt_rows(rows, ctx);
+
+    /* Transpose the keystream back into blocks and XOR with the input */
+#if SKINNY_LITTLE_ENDIAN && SKINNY_UNALIGNED
+    *((SkinnyVector4x32U_t *)output) =
+        *((const SkinnyVector4x32U_t *)input) ^
+        (SkinnyVector4x32_t){rows[0][0], rows[1][0], rows[2][0], rows[3][0]};
+    *((SkinnyVector4x32U_t *)(output + 16)) =
+        *((const SkinnyVector4x32U_t *)(input + 16)) ^
+        (SkinnyVector4x32_t){rows[0][1], rows[1][1], rows[2][1], rows[3][1]};
+    *((SkinnyVector4x32U_t *)(output + 32)) =
+        *((const SkinnyVector4x32U_t *)(input + 32)) ^
+        (SkinnyVector4x32_t){rows[0][2], rows[1][2], rows[2][2], rows[3][2]};
+    *((SkinnyVector4x32U_t *)(output + 48)) =
+        *((const SkinnyVector4x32U_t *)(input + 48)) ^
+        (SkinnyVector4x32_t){rows[0][3], rows[1][3], rows[2][3], rows[3][3]};
+#else
+    skinny_xor_word32(output, input,  0, rows[0][0]);
+    skinny_xor_word32(output, input,  4, rows[1][0]);
+    skinny_xor_word32(output, input,  8, rows[2][0]);
+    skinny_xor_word32(output, input, 12, rows[3][0]);
+    skinny_xor_word32(output, input, 16, rows[0][1]);
+    skinny_xor_word32(output, input, 20, rows[1][1]);
+    skinny_xor_word32(output, input, 24, rows[2][1]);
+    skinny_xor_word32(output, input, 28, rows[3][1]);
+    skinny_xor_word32(output, input, 32, rows[0][2]);
+    skinny_xor_word32(output, input, 36, rows[1][2]);
+    skinny_xor_word32(output, input, 40, rows[2][2]);
+    skinny_xor_word32(output, input, 44, rows[3][2]);
+    skinny_xor_word32(output, input, 48, rows[0][3]);
+    skinny_xor_word32(output, input, 52, rows[1][3]);
+    skinny_xor_word32(output, input, 56, rows[2][3]);
+    skinny_xor_word32(output, input, 60, rows[3][3]);
 #endif
 }
 
@@ -433,30 +527,24 @@ static int skinny128_ctr_vec128_encrypt
     while (size > 0) {
         if (ctx->offset >= SKINNY128_CTR_BLOCK_SIZE) {
             /* We need a new keystream block */
-            skinny128_ecb_encrypt_four
-                (ctx->ecounter, ctx->counter, &(ctx->kt.ks));
+            if (size >= SKINNY128_CTR_BLOCK_SIZE) {
+                /* XOR an entire keystream block in one go, keeping
+                   the keystream in registers rather than ecounter */
+                skinny128_ctr_xor_four(out, in, ctx->counter, ctx);
+            } else {
+                /* Last partial block in the request */
+                skinny128_ecb_encrypt_four
+                    (ctx->ecounter, ctx->counter, ctx);
+            }
             skinny128_ctr_increment(ctx->counter, 0, 4);
             skinny128_ctr_increment(ctx->counter, 1, 4);
             skinny128_ctr_increment(ctx->counter, 2, 4);
             skinny128_ctr_increment(ctx->counter, 3, 4);
-
-            /* XOR an entire keystream block in one go if possible */
             if (size >= SKINNY128_CTR_BLOCK_SIZE) {
-                skinny128_xor(out, in, ctx->ecounter);
-                skinny128_xor(out + SKINNY128_BLOCK_SIZE,
-                              in + SKINNY128_BLOCK_SIZE,
-                              ctx->ecounter + SKINNY128_BLOCK_SIZE);
-                skinny128_xor(out + SKINNY128_BLOCK_SIZE * 2,
-                              in + SKINNY128_BLOCK_SIZE * 2,
-                              ctx->ecounter + SKINNY128_BLOCK_SIZE * 2);
-                skinny128_xor(out + SKINNY128_BLOCK_SIZE * 3,
-                              in + SKINNY128_BLOCK_SIZE * 3,
-                              ctx->ecounter + SKINNY128_BLOCK_SIZE * 3);
                 out += SKINNY128_CTR_BLOCK_SIZE;
                 in += SKINNY128_CTR_BLOCK_SIZE;
                 size -= SKINNY128_CTR_BLOCK_SIZE;
             } else {
-                /* Last partial block in the request */
                 skinny_xor(out, in, ctx->ecounter, size);
                 ctx->offset = size;
                 break;
@@ -484,7 +572,8 @@ Skinny128CTRVtable_t const _skinny128_ctr_vec128 = {
     skinny128_ctr_vec128_set_tweaked_key,
     skinny128_ctr_vec128_set_tweak,
     skinny128_ctr_vec128_set_counter,
-    skinny128_ctr_vec128_encrypt
+    skinny128_ctr_vec128_encrypt,
+    "vec128"
 };
 
 #else /* !SKINNY_VEC128_MATH */
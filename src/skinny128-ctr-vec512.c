@@ -0,0 +1,471 @@
+/*
+ * Copyright (C) 2017 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#define SKINNY_TARGET_VEC512 1
+
+#include "skinny128-cipher.h"
+#include "skinny128-ctr-internal.h"
+#include "skinny-internal.h"
+#include <stdlib.h>
+
+#if SKINNY_VEC512_MATH
+
+/* This implementation encrypts sixteen blocks at a time */
+#define SKINNY128_CTR_BLOCK_SIZE (SKINNY128_BLOCK_SIZE * 16)
+
+/** Internal state information for Skinny-128 in CTR mode */
+typedef struct
+{
+    /** Key schedule for Skinny-128, with an optional tweak */
+    Skinny128TweakedKey_t kt;
+
+    /** Counter values for the next block, pre-formatted into row vectors */
+    SkinnyVector16x32_t counter[4];
+
+    /** Encrypted counter value for encrypting the current block */
+    unsigned char ecounter[SKINNY128_CTR_BLOCK_SIZE];
+
+    /** Offset into ecounter where the previous request left off */
+    unsigned offset;
+
+    /** Base pointer for unaligned memory allocation */
+    void *base_ptr;
+
+} Skinny128CTRVec512Ctx_t;
+
+static int skinny128_ctr_vec512_init(Skinny128CTR_t *ctr)
+{
+    Skinny128CTRVec512Ctx_t *ctx;
+    void *base_ptr;
+    if ((ctx = skinny_calloc(sizeof(Skinny128CTRVec512Ctx_t), &base_ptr)) == NULL)
+        return 0;
+    ctx->base_ptr = base_ptr;
+    ctx->offset = SKINNY128_CTR_BLOCK_SIZE;
+    ctr->ctx = ctx;
+    return 1;
+}
+
+static void skinny128_ctr_vec512_cleanup(Skinny128CTR_t *ctr)
+{
+    if (ctr->ctx) {
+        Skinny128CTRVec512Ctx_t *ctx = ctr->ctx;
+        void *base_ptr = ctx->base_ptr;
+        skinny_cleanse(ctx, sizeof(Skinny128CTRVec512Ctx_t));
+        free(base_ptr);
+        ctr->ctx = 0;
+    }
+}
+
+static int skinny128_ctr_vec512_set_key
+    (Skinny128CTR_t *ctr, const void *key, unsigned size)
+{
+    Skinny128CTRVec512Ctx_t *ctx;
+
+    /* Validate the parameters */
+    if (!key)
+        return 0;
+    ctx = ctr->ctx;
+    if (!ctx)
+        return 0;
+
+    /* Populate the underlying key schedule */
+    if (!skinny128_set_key(&(ctx->kt.ks), key, size))
+        return 0;
+
+    /* Reset the keystream */
+    ctx->offset = SKINNY128_CTR_BLOCK_SIZE;
+    return 1;
+}
+
+static int skinny128_ctr_vec512_set_tweaked_key
+    (Skinny128CTR_t *ctr, const void *key, unsigned key_size)
+{
+    Skinny128CTRVec512Ctx_t *ctx;
+
+    /* Validate the parameters */
+    if (!key)
+        return 0;
+    ctx = ctr->ctx;
+    if (!ctx)
+        return 0;
+
+    /* Populate the underlying key schedule */
+    if (!skinny128_set_tweaked_key(&(ctx->kt), key, key_size))
+        return 0;
+
+    /* Reset the keystream */
+    ctx->offset = SKINNY128_CTR_BLOCK_SIZE;
+    return 1;
+}
+
+static int skinny128_ctr_vec512_set_tweak
+    (Skinny128CTR_t *ctr, const void *tweak, unsigned tweak_size)
+{
+    Skinny128CTRVec512Ctx_t *ctx;
+
+    /* Validate the parameters */
+    ctx = ctr->ctx;
+    if (!ctx)
+        return 0;
+
+    /* Populate the underlying tweak */
+    if (!skinny128_set_tweak(&(ctx->kt), tweak, tweak_size))
+        return 0;
+
+    /* Reset the keystream */
+    ctx->offset = SKINNY128_CTR_BLOCK_SIZE;
+    return 1;
+}
+
+/* Increment a specific column in an array of row vectors */
+STATIC_INLINE void skinny128_ctr_increment
+    (SkinnyVector16x32_t *counter, unsigned column, unsigned inc)
+{
+    uint8_t *ctr = ((uint8_t *)counter) + column * 4;
+    uint8_t *ptr;
+    unsigned index;
+    for (index = 16; index > 0; ) {
+        --index;
+        ptr = ctr + (index & 0x0C) * 16;
+#if SKINNY_LITTLE_ENDIAN
+        ptr += index & 0x03;
+#else
+        ptr += 3 - (index & 0x03);
+#endif
+        inc += ptr[0];
+        ptr[0] = (uint8_t)inc;
+        inc >>= 8;
+    }
+}
+
+/* Byte-swap all 32-bit words in a vector */
+STATIC_INLINE SkinnyVector16x32_t skinny128_bswap(SkinnyVector16x32_t x)
+{
+    return (((x << 8) | (x >> 24)) & 0x00FF00FFU) |
+           (((x >> 8) | (x << 24)) & 0xFF00FF00U);
+}
+
+/* Increment all sixteen columns of the row vectors at once.  The counter
+   is big-endian, so each 32-bit word is byte-swapped to make it a number */
+STATIC_INLINE void skinny128_ctr_increment_all
+    (SkinnyVector16x32_t *counter, uint32_t inc)
+{
+    SkinnyVector16x32_t row0 = skinny128_bswap(counter[0]);
+    SkinnyVector16x32_t row1 = skinny128_bswap(counter[1]);
+    SkinnyVector16x32_t row2 = skinny128_bswap(counter[2]);
+    SkinnyVector16x32_t row3 = skinny128_bswap(counter[3]);
+    SkinnyVector16x32_t carry;
+
+    /* Add to the least significant row and ripple the carries upwards.
+       Comparison results are all-ones masks, so subtracting adds one */
+    row3 += inc;
+    carry = (SkinnyVector16x32_t)(row3 < inc);
+    row2 -= carry;
+    carry &= (SkinnyVector16x32_t)(row2 == 0);
+    row1 -= carry;
+    carry &= (SkinnyVector16x32_t)(row1 == 0);
+    row0 -= carry;
+
+    /* Swap the bytes back into big-endian order */
+    counter[0] = skinny128_bswap(row0);
+    counter[1] = skinny128_bswap(row1);
+    counter[2] = skinny128_bswap(row2);
+    counter[3] = skinny128_bswap(row3);
+}
+
+static int skinny128_ctr_vec512_set_counter
+    (Skinny128CTR_t *ctr, const void *counter, unsigned size)
+{
+    Skinny128CTRVec512Ctx_t *ctx;
+    unsigned char block[SKINNY128_BLOCK_SIZE];
+    unsigned column;
+
+    /* Validate the parameters */
+    if (size > SKINNY128_BLOCK_SIZE)
+        return 0;
+    ctx = ctr->ctx;
+    if (!ctx)
+        return 0;
+
+    /* Set the counter and reset the keystream to a block boundary */
+    if (counter) {
+        memset(block, 0, SKINNY128_BLOCK_SIZE - size);
+        memcpy(block + SKINNY128_BLOCK_SIZE - size, counter, size);
+    } else {
+        memset(block, 0, SKINNY128_BLOCK_SIZE);
+    }
+    SKINNY_STAT_ADD
+        (ctr_discarded_bytes, SKINNY128_CTR_BLOCK_SIZE - ctx->offset);
+    ctx->offset = SKINNY128_CTR_BLOCK_SIZE;
+
+    /* Load the counter block and convert into row vectors */
+    ctx->counter[0] = skinny_to_vec16x32(READ_WORD32(block,  0));
+    ctx->counter[1] = skinny_to_vec16x32(READ_WORD32(block,  4));
+    ctx->counter[2] = skinny_to_vec16x32(READ_WORD32(block,  8));
+    ctx->counter[3] = skinny_to_vec16x32(READ_WORD32(block, 12));
+
+    /* Increment the second through sixteenth columns of each row vector */
+    for (column = 1; column < 16; ++column)
+        skinny128_ctr_increment(ctx->counter, column, column);
+
+    /* Clean up and exit */
+    skinny_cleanse(block, sizeof(block));
+    return 1;
+}
+
+STATIC_INLINE SkinnyVector16x32_t skinny128_rotate_right
+    (SkinnyVector16x32_t x, unsigned count)
+{
+    /* Note: we are rotating the cells right, which actually moves
+       the values up closer to the MSB.  That is, we do a left shift
+       on the word to rotate the cells in the word right */
+    return (x << count) | (x >> (32 - count));
+}
+
+/* Computes "~(a | b) & mask" with a single VPTERNLOGD instruction */
+STATIC_INLINE SkinnyVector16x32_t skinny128_nor_and
+    (SkinnyVector16x32_t a, SkinnyVector16x32_t b, uint32_t mask)
+{
+    return skinny_ternlog_16x32(a, b, skinny_to_vec16x32(mask), 0x02);
+}
+
+/* Computes "a ^ b ^ c" with a single VPTERNLOGD instruction */
+STATIC_INLINE SkinnyVector16x32_t skinny128_xor3
+    (SkinnyVector16x32_t a, SkinnyVector16x32_t b, SkinnyVector16x32_t c)
+{
+    return skinny_ternlog_16x32(a, b, c, 0x96);
+}
+
+/* Computes "a | (b & mask)" with a single VPTERNLOGD instruction */
+STATIC_INLINE SkinnyVector16x32_t skinny128_or_and
+    (SkinnyVector16x32_t a, SkinnyVector16x32_t b, uint32_t mask)
+{
+    return skinny_ternlog_16x32(a, b, skinny_to_vec16x32(mask), 0xF8);
+}
+
+/* Each NOR/AND/XOR step of the bit-sliced S-box collapses into two
+   ternary logic instructions, and the final bit permutation becomes
+   a chain of shifts merged with masked OR's */
+STATIC_INLINE SkinnyVector16x32_t skinny128_sbox(SkinnyVector16x32_t x)
+{
+    SkinnyVector16x32_t y;
+
+    x ^= skinny128_nor_and(x >> 2, x >> 3, 0x11111111U);
+
+    y = skinny128_nor_and(x << 5, x << 1, 0x20202020U);
+    x = skinny128_xor3
+        (x, skinny128_nor_and(x << 5, x << 4, 0x40404040U), y);
+
+    y = skinny128_nor_and(x << 2, x << 1, 0x80808080U);
+    x = skinny128_xor3
+        (x, skinny128_nor_and(x >> 2, x << 1, 0x02020202U), y);
+
+    y = skinny128_nor_and(x >> 5, x << 1, 0x04040404U);
+    x = skinny128_xor3
+        (x, skinny128_nor_and(x >> 1, x >> 2, 0x08080808U), y);
+
+    y = (x << 1) & 0x10101010U;
+    y = skinny128_or_and(y, x << 2, 0xC8C8C8C8U);
+    y = skinny128_or_and(y, x << 5, 0x20202020U);
+    y = skinny128_or_and(y, x >> 6, 0x02020202U);
+    y = skinny128_or_and(y, x >> 4, 0x04040404U);
+    return skinny128_or_and(y, x >> 2, 0x01010101U);
+}
+
+/* Encrypts sixteen blocks that have already been arranged into row vectors */
+STATIC_INLINE void skinny128_encrypt_rows
+    (SkinnyVector16x32_t *rows, const Skinny128Key_t *ks)
+{
+    SkinnyVector16x32_t row0;
+    SkinnyVector16x32_t row1;
+    SkinnyVector16x32_t row2;
+    SkinnyVector16x32_t row3;
+    const Skinny128HalfCells_t *schedule;
+    unsigned index;
+    SkinnyVector16x32_t temp;
+
+    /* Read the rows of all sixteen counter blocks into memory */
+    row0 = rows[0];
+    row1 = rows[1];
+    row2 = rows[2];
+    row3 = rows[3];
+
+    /* Perform all encryption rounds on the sixteen blocks in parallel */
+    schedule = ks->schedule;
+    for (index = ks->rounds; index > 0; --index, ++schedule) {
+        /* Apply the S-box to all bytes in the state */
+        row0 = skinny128_sbox(row0);
+        row1 = skinny128_sbox(row1);
+        row2 = skinny128_sbox(row2);
+        row3 = skinny128_sbox(row3);
+
+        /* Apply the subkey for this round */
+        row0 ^= schedule->row[0];
+        row1 ^= schedule->row[1];
+        row2 ^= 0x02;
+
+        /* Shift the rows */
+        row1 = skinny128_rotate_right(row1, 8);
+        row2 = skinny128_rotate_right(row2, 16);
+        row3 = skinny128_rotate_right(row3, 24);
+
+        /* Mix the columns */
+        row1 ^= row2;
+        row2 ^= row0;
+        temp = row3 ^ row2;
+        row3 = row2;
+        row2 = row1;
+        row1 = row0;
+        row0 = temp;
+    }
+
+    /* Return the encrypted rows to the caller */
+    rows[0] = row0;
+    rows[1] = row1;
+    rows[2] = row2;
+    rows[3] = row3;
+}
+
+static void skinny128_ecb_encrypt_sixteen
+    (void *output, const SkinnyVector16x32_t *input, const Skinny128Key_t *ks)
+{
+    SkinnyVector16x32_t rows[4];
+    __m512i out[4];
+
+    /* Encrypt the sixteen counter blocks */
+    rows[0] = input[0];
+    rows[1] = input[1];
+    rows[2] = input[2];
+    rows[3] = input[3];
+    skinny128_encrypt_rows(rows, ks);
+
+    /* Write the rows of all sixteen blocks back to memory */
+    skinny_transpose_16x32(out, rows[0], rows[1], rows[2], rows[3]);
+    _mm512_storeu_si512(output, out[0]);
+    _mm512_storeu_si512(((__m512i *)output) + 1, out[1]);
+    _mm512_storeu_si512(((__m512i *)output) + 2, out[2]);
+    _mm512_storeu_si512(((__m512i *)output) + 3, out[3]);
+}
+
+/* Encrypts sixteen counter blocks and XOR's the keystream directly with
+   sixteen blocks of input, without a round trip through ctx->ecounter */
+static void skinny128_ctr_xor_sixteen
+    (void *output, const void *input, const SkinnyVector16x32_t *counter,
+     const Skinny128Key_t *ks)
+{
+    const __m512i *in = (const __m512i *)input;
+    __m512i *out = (__m512i *)output;
+    SkinnyVector16x32_t rows[4];
+    __m512i ks_blocks[4];
+
+    /* Encrypt the sixteen counter blocks */
+    rows[0] = counter[0];
+    rows[1] = counter[1];
+    rows[2] = counter[2];
+    rows[3] = counter[3];
+    skinny128_encrypt_rows(rows, ks);
+
+    /* Transpose the keystream back into blocks and XOR with the input */
+    skinny_transpose_16x32(ks_blocks, rows[0], rows[1], rows[2], rows[3]);
+    _mm512_storeu_si512
+        (out, _mm512_xor_si512(_mm512_loadu_si512(in), ks_blocks[0]));
+    _mm512_storeu_si512
+        (out + 1, _mm512_xor_si512(_mm512_loadu_si512(in + 1), ks_blocks[1]));
+    _mm512_storeu_si512
+        (out + 2, _mm512_xor_si512(_mm512_loadu_si512(in + 2), ks_blocks[2]));
+    _mm512_storeu_si512
+        (out + 3, _mm512_xor_si512(_mm512_loadu_si512(in + 3), ks_blocks[3]));
+}
+
+static int skinny128_ctr_vec512_encrypt
+    (void *output, const void *input, size_t size, Skinny128CTR_t *ctr)
+{
+    Skinny128CTRVec512Ctx_t *ctx;
+    uint8_t *out = (uint8_t *)output;
+    const uint8_t *in = (const uint8_t *)input;
+
+    /* Validate the parameters */
+    if (!output || !input)
+        return 0;
+    ctx = ctr->ctx;
+    if (!ctx)
+        return 0;
+
+    /* Encrypt the input in CTR mode to create the output */
+    while (size > 0) {
+        if (ctx->offset >= SKINNY128_CTR_BLOCK_SIZE) {
+            /* We need a new keystream block */
+            if (size >= SKINNY128_CTR_BLOCK_SIZE) {
+                /* XOR an entire keystream block in one go, keeping
+                   the keystream in registers rather than ecounter */
+                skinny128_ctr_xor_sixteen
+                    (out, in, ctx->counter, &(ctx->kt.ks));
+            } else {
+                /* Last partial block in the request */
+                skinny128_ecb_encrypt_sixteen
+                    (ctx->ecounter, ctx->counter, &(ctx->kt.ks));
+            }
+            skinny128_ctr_increment_all(ctx->counter, 16);
+            if (size >= SKINNY128_CTR_BLOCK_SIZE) {
+                out += SKINNY128_CTR_BLOCK_SIZE;
+                in += SKINNY128_CTR_BLOCK_SIZE;
+                size -= SKINNY128_CTR_BLOCK_SIZE;
+            } else {
+                skinny_xor(out, in, ctx->ecounter, size);
+                ctx->offset = size;
+                break;
+            }
+        } else {
+            /* Left-over keystream data from the last request */
+            size_t temp = SKINNY128_CTR_BLOCK_SIZE - ctx->offset;
+            if (temp > size)
+                temp = size;
+            skinny_xor(out, in, ctx->ecounter + ctx->offset, temp);
+            ctx->offset += temp;
+            out += temp;
+            in += temp;
+            size -= temp;
+        }
+    }
+    return 1;
+}
+
+/** Vtable for the 512-bit SIMD Skinny-128-CTR implementation */
+Skinny128CTRVtable_t const _skinny128_ctr_vec512 = {
+    skinny128_ctr_vec512_init,
+    skinny128_ctr_vec512_cleanup,
+    skinny128_ctr_vec512_set_key,
+    skinny128_ctr_vec512_set_tweaked_key,
+    skinny128_ctr_vec512_set_tweak,
+    skinny128_ctr_vec512_set_counter,
+    skinny128_ctr_vec512_encrypt,
+    "vec512"
+};
+
+#else /* !SKINNY_VEC512_MATH */
+
+/* Stubbed out */
+Skinny128CTRVtable_t const _skinny128_ctr_vec512;
+
+#endif /* !SKINNY_VEC512_MATH */
+
+SKINNY_TARGET_END
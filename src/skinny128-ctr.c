@@ -25,17 +25,20 @@
 #include "skinny-internal.h"
 #include <stdlib.h>
 
+/* The default back end generates two blocks of keystream at a time */
+#define SKINNY128_CTR_BLOCK_SIZE (SKINNY128_BLOCK_SIZE * 2)
+
 /** Internal state information for Skinny-128 in CTR mode */
 typedef struct
 {
     /** Key schedule for Skinny-128, with an optional tweak */
     Skinny128TweakedKey_t kt;
 
-    /** Counter value for the next block */
-    unsigned char counter[SKINNY128_BLOCK_SIZE];
+    /** Counter values for the next two blocks */
+    unsigned char counter[SKINNY128_CTR_BLOCK_SIZE];
 
-    /** Encrypted counter value for encrypting the current block */
-    unsigned char ecounter[SKINNY128_BLOCK_SIZE];
+    /** Encrypted counter values for encrypting the current blocks */
+    unsigned char ecounter[SKINNY128_CTR_BLOCK_SIZE];
 
     /** Offset into ecounter where the previous request left off */
     unsigned offset;
@@ -47,7 +50,7 @@ static int skinny128_ctr_def_init(Skinny128CTR_t *ctr)
     Skinny128CTRCtx_t *ctx;
     if ((ctx = calloc(1, sizeof(Skinny128CTRCtx_t))) == NULL)
         return 0;
-    ctx->offset = SKINNY128_BLOCK_SIZE;
+    ctx->offset = SKINNY128_CTR_BLOCK_SIZE;
     ctr->ctx = ctx;
     return 1;
 }
@@ -77,7 +80,7 @@ static int skinny128_ctr_def_set_key(Skinny128CTR_t *ctr, const void *key, unsig
         return 0;
 
     /* Reset the keystream */
-    ctx->offset = SKINNY128_BLOCK_SIZE;
+    ctx->offset = SKINNY128_CTR_BLOCK_SIZE;
     return 1;
 }
 
@@ -98,7 +101,7 @@ static int skinny128_ctr_def_set_tweaked_key
         return 0;
 
     /* Reset the keystream */
-    ctx->offset = SKINNY128_BLOCK_SIZE;
+    ctx->offset = SKINNY128_CTR_BLOCK_SIZE;
     return 1;
 }
 
@@ -117,7 +120,7 @@ static int skinny128_ctr_def_set_tweak
         return 0;
 
     /* Reset the keystream */
-    ctx->offset = SKINNY128_BLOCK_SIZE;
+    ctx->offset = SKINNY128_CTR_BLOCK_SIZE;
     return 1;
 }
 
@@ -140,7 +143,12 @@ static int skinny128_ctr_def_set_counter
     } else {
         memset(ctx->counter, 0, SKINNY128_BLOCK_SIZE);
     }
-    ctx->offset = SKINNY128_BLOCK_SIZE;
+    memcpy(ctx->counter + SKINNY128_BLOCK_SIZE, ctx->counter,
+           SKINNY128_BLOCK_SIZE);
+    skinny128_inc_counter(ctx->counter + SKINNY128_BLOCK_SIZE, 1);
+    SKINNY_STAT_ADD
+        (ctr_discarded_bytes, SKINNY128_CTR_BLOCK_SIZE - ctx->offset);
+    ctx->offset = SKINNY128_CTR_BLOCK_SIZE;
     return 1;
 }
 
@@ -160,17 +168,22 @@ static int skinny128_ctr_def_encrypt
 
     /* Encrypt the input in CTR mode to create the output */
     while (size > 0) {
-        if (ctx->offset >= SKINNY128_BLOCK_SIZE) {
-            /* We need a new keystream block */
-            skinny128_ecb_encrypt(ctx->ecounter, ctx->counter, &(ctx->kt.ks));
-            skinny128_inc_counter(ctx->counter, 1);
+        if (ctx->offset >= SKINNY128_CTR_BLOCK_SIZE) {
+            /* We need two new keystream blocks */
+            _skinny128_parallel_encrypt_x2
+                (ctx->ecounter, ctx->counter, &(ctx->kt.ks));
+            skinny128_inc_counter(ctx->counter, 2);
+            skinny128_inc_counter(ctx->counter + SKINNY128_BLOCK_SIZE, 2);
 
             /* XOR an entire keystream block in one go if possible */
-            if (size >= SKINNY128_BLOCK_SIZE) {
+            if (size >= SKINNY128_CTR_BLOCK_SIZE) {
                 skinny128_xor(out, in, ctx->ecounter);
-                out += SKINNY128_BLOCK_SIZE;
-                in += SKINNY128_BLOCK_SIZE;
-                size -= SKINNY128_BLOCK_SIZE;
+                skinny128_xor(out + SKINNY128_BLOCK_SIZE,
+                           in + SKINNY128_BLOCK_SIZE,
+                           ctx->ecounter + SKINNY128_BLOCK_SIZE);
+                out += SKINNY128_CTR_BLOCK_SIZE;
+                in += SKINNY128_CTR_BLOCK_SIZE;
+                size -= SKINNY128_CTR_BLOCK_SIZE;
             } else {
                 /* Last partial block in the request */
                 skinny_xor(out, in, ctx->ecounter, size);
@@ -179,7 +192,7 @@ static int skinny128_ctr_def_encrypt
             }
         } else {
             /* Left-over keystream data from the last request */
-            size_t temp = SKINNY128_BLOCK_SIZE - ctx->offset;
+            size_t temp = SKINNY128_CTR_BLOCK_SIZE - ctx->offset;
             if (temp > size)
                 temp = size;
             skinny_xor(out, in, ctx->ecounter + ctx->offset, temp);
@@ -200,13 +213,33 @@ static Skinny128CTRVtable_t const skinny128_ctr_def = {
     skinny128_ctr_def_set_tweaked_key,
     skinny128_ctr_def_set_tweak,
     skinny128_ctr_def_set_counter,
-    skinny128_ctr_def_encrypt
+    skinny128_ctr_def_encrypt,
+    "default"
 };
 
+/* Lists the back ends that are usable on this platform, in increasing
+   order of preference */
+static unsigned skinny128_ctr_backends(const Skinny128CTRVtable_t **list)
+{
+    unsigned count = 0;
+    list[count++] = &skinny128_ctr_def;
+    if (_skinny_has_vec128())
+        list[count++] = &_skinny128_ctr_vec128;
+    if (_skinny_has_vec256())
+        list[count++] = &_skinny128_ctr_vec256;
+    if (_skinny_has_vec512())
+        list[count++] = &_skinny128_ctr_vec512;
+    return count;
+}
+
+/* Back end that was chosen by the autotuner, or NULL if not tuned */
+static const Skinny128CTRVtable_t *skinny128_ctr_tuned = 0;
+
 /* Public API, which redirects to the specific backend implementation */
 
 int skinny128_ctr_init(Skinny128CTR_t *ctr)
 {
+    const Skinny128CTRVtable_t *list[SKINNY_AUTOTUNE_MAX_BACKENDS];
     const Skinny128CTRVtable_t *vtable;
 
     /* Validate the parameter */
@@ -214,26 +247,38 @@ int skinny128_ctr_init(Skinny128CTR_t *ctr)
         return 0;
 
     /* Choose a backend implementation */
-    vtable = &skinny128_ctr_def;
-    if (_skinny_has_vec128())
-        vtable = &_skinny128_ctr_vec128;
-    if (_skinny_has_vec256())
-        vtable = &_skinny128_ctr_vec256;
+    vtable = skinny128_ctr_tuned;
+    if (!vtable)
+        vtable = list[skinny128_ctr_backends(list) - 1];
     ctr->vtable = vtable;
 
     /* Initialize the CTR mode context */
-    return (*(vtable->init))(ctr);
+    if (!(*(vtable->init))(ctr))
+        return 0;
+    SKINNY_STAT_ADD(context_allocs, 1);
+    SKINNY_PROBE2(skinny128_ctr_init, ctr, vtable->name);
+    return 1;
 }
 
 void skinny128_ctr_cleanup(Skinny128CTR_t *ctr)
 {
     if (ctr && ctr->vtable) {
         const Skinny128CTRVtable_t *vtable = ctr->vtable;
+        SKINNY_PROBE1(skinny128_ctr_cleanup, ctr);
         (*(vtable->cleanup))(ctr);
         ctr->vtable = 0;
     }
 }
 
+const char *skinny128_ctr_backend_name(const Skinny128CTR_t *ctr)
+{
+    if (ctr && ctr->vtable) {
+        const Skinny128CTRVtable_t *vtable = ctr->vtable;
+        return vtable->name;
+    }
+    return 0;
+}
+
 int skinny128_ctr_set_key(Skinny128CTR_t *ctr, const void *key, unsigned size)
 {
     if (ctr && ctr->vtable) {
@@ -278,7 +323,79 @@ int skinny128_ctr_encrypt
 {
     if (ctr && ctr->vtable) {
         const Skinny128CTRVtable_t *vtable = ctr->vtable;
-        return (*(vtable->encrypt))(output, input, size, ctr);
+        int result;
+        SKINNY_PROBE3(skinny128_ctr_encrypt_start, ctr, size, vtable->name);
+        result = (*(vtable->encrypt))(output, input, size, ctr);
+        SKINNY_PROBE2(skinny128_ctr_encrypt_done, ctr, size);
+        return result;
     }
     return 0;
 }
+
+/** @cond */
+
+/**
+ * \brief State for timing a CTR back end with the autotuner.
+ */
+typedef struct
+{
+    Skinny128CTR_t ctr;
+    unsigned char data[SKINNY_AUTOTUNE_SIZE];
+
+} Skinny128CTRTune_t;
+
+/** @endcond */
+
+static void skinny128_ctr_time(void *arg)
+{
+    Skinny128CTRTune_t *tune = arg;
+    const Skinny128CTRVtable_t *vtable = tune->ctr.vtable;
+    (*(vtable->encrypt))(tune->data, tune->data, SKINNY_AUTOTUNE_SIZE,
+                         &(tune->ctr));
+}
+
+const char *_skinny128_ctr_autotune(const char *name)
+{
+    const Skinny128CTRVtable_t *list[SKINNY_AUTOTUNE_MAX_BACKENDS];
+    const Skinny128CTRVtable_t *vtable;
+    Skinny128CTRTune_t *tune;
+    uint64_t time, best_time = ~((uint64_t)0);
+    unsigned count, index, best;
+
+    /* Select a specific back end by name */
+    count = skinny128_ctr_backends(list);
+    if (name) {
+        for (index = 0; index < count; ++index) {
+            if (!strcmp(list[index]->name, name)) {
+                skinny128_ctr_tuned = list[index];
+                return list[index]->name;
+            }
+        }
+        return 0;
+    }
+
+    /* Time each back end, starting with the default choice.  Another
+       back end must be strictly faster to replace the default */
+    best = count - 1;
+    if ((tune = calloc(1, sizeof(Skinny128CTRTune_t))) != NULL) {
+        for (index = count; index > 0; ) {
+            --index;
+            vtable = list[index];
+            tune->ctr.vtable = vtable;
+            if (!(*(vtable->init))(&(tune->ctr)))
+                continue;
+            if ((*(vtable->set_key))
+                    (&(tune->ctr), tune->data, SKINNY128_BLOCK_SIZE)) {
+                time = _skinny_autotune_measure(skinny128_ctr_time, tune);
+                if (time < best_time) {
+                    best = index;
+                    best_time = time;
+                }
+            }
+            (*(vtable->cleanup))(&(tune->ctr));
+        }
+        free(tune);
+    }
+    skinny128_ctr_tuned = list[best];
+    return list[best]->name;
+}
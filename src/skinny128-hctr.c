@@ -0,0 +1,322 @@
+/*
+ * Copyright (C) 2017 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "skinny128-hctr.h"
+#include "skinny-internal.h"
+#include <stdlib.h>
+
+/** Internal state information for Skinny-128 in HCTR mode */
+typedef struct
+{
+    /** CTR mode context for the bulk of each page */
+    Skinny128CTR_t ctr;
+
+    /** Tweakable block cipher for the first block of each page */
+    Skinny128TweakedKey_t kt;
+
+    /** Poly1305 hash key in 26-bit limbs */
+    uint32_t r[5];
+
+} Skinny128HCTRCtx_t;
+
+/* Hashes a message with Poly1305, without the final addition of "s".
+   The length of the message in bits is hashed first so that messages
+   of different lengths are independent.  The result is reduced modulo
+   2^130 - 5 and truncated to 128 bits in little-endian order */
+static void skinny128_hctr_hash
+    (uint32_t hash[4], const uint32_t r[5], const uint8_t *data, size_t size)
+{
+    uint32_t r0 = r[0], r1 = r[1], r2 = r[2], r3 = r[3], r4 = r[4];
+    uint32_t s1 = r1 * 5, s2 = r2 * 5, s3 = r3 * 5, s4 = r4 * 5;
+    uint32_t h0 = 0, h1 = 0, h2 = 0, h3 = 0, h4 = 0;
+    uint32_t g0, g1, g2, g3, g4, c, mask, hibit;
+    uint64_t d0, d1, d2, d3, d4;
+    uint64_t bits = ((uint64_t)size) * 8;
+    uint8_t block[16];
+    const uint8_t *m;
+    int length_block = 1;
+
+    while (length_block || size > 0) {
+        /* Get the next block, padding the last one with 0x01 and zeroes */
+        if (length_block) {
+            memset(block, 0, sizeof(block));
+            WRITE_WORD32(block, 0, (uint32_t)bits);
+            WRITE_WORD32(block, 4, (uint32_t)(bits >> 32));
+            m = block;
+            hibit = 1UL << 24;
+            length_block = 0;
+        } else if (size >= 16) {
+            m = data;
+            hibit = 1UL << 24;
+            data += 16;
+            size -= 16;
+        } else {
+            memset(block, 0, sizeof(block));
+            memcpy(block, data, size);
+            block[size] = 0x01;
+            m = block;
+            hibit = 0;
+            size = 0;
+        }
+
+        /* h += m */
+        h0 += READ_WORD32(m, 0) & 0x3FFFFFF;
+        h1 += (READ_WORD32(m, 3) >> 2) & 0x3FFFFFF;
+        h2 += (READ_WORD32(m, 6) >> 4) & 0x3FFFFFF;
+        h3 += (READ_WORD32(m, 9) >> 6) & 0x3FFFFFF;
+        h4 += (READ_WORD32(m, 12) >> 8) | hibit;
+
+        /* h *= r (mod 2^130 - 5) */
+        d0 = ((uint64_t)h0 * r0) + ((uint64_t)h1 * s4) +
+             ((uint64_t)h2 * s3) + ((uint64_t)h3 * s2) + ((uint64_t)h4 * s1);
+        d1 = ((uint64_t)h0 * r1) + ((uint64_t)h1 * r0) +
+             ((uint64_t)h2 * s4) + ((uint64_t)h3 * s3) + ((uint64_t)h4 * s2);
+        d2 = ((uint64_t)h0 * r2) + ((uint64_t)h1 * r1) +
+             ((uint64_t)h2 * r0) + ((uint64_t)h3 * s4) + ((uint64_t)h4 * s3);
+        d3 = ((uint64_t)h0 * r3) + ((uint64_t)h1 * r2) +
+             ((uint64_t)h2 * r1) + ((uint64_t)h3 * r0) + ((uint64_t)h4 * s4);
+        d4 = ((uint64_t)h0 * r4) + ((uint64_t)h1 * r3) +
+             ((uint64_t)h2 * r2) + ((uint64_t)h3 * r1) + ((uint64_t)h4 * r0);
+
+        /* Partial carry propagation */
+        c = (uint32_t)(d0 >> 26); h0 = (uint32_t)d0 & 0x3FFFFFF;
+        d1 += c; c = (uint32_t)(d1 >> 26); h1 = (uint32_t)d1 & 0x3FFFFFF;
+        d2 += c; c = (uint32_t)(d2 >> 26); h2 = (uint32_t)d2 & 0x3FFFFFF;
+        d3 += c; c = (uint32_t)(d3 >> 26); h3 = (uint32_t)d3 & 0x3FFFFFF;
+        d4 += c; c = (uint32_t)(d4 >> 26); h4 = (uint32_t)d4 & 0x3FFFFFF;
+        h0 += c * 5; c = h0 >> 26; h0 &= 0x3FFFFFF;
+        h1 += c;
+    }
+
+    /* Full carry propagation */
+    c = h1 >> 26; h1 &= 0x3FFFFFF;
+    h2 += c; c = h2 >> 26; h2 &= 0x3FFFFFF;
+    h3 += c; c = h3 >> 26; h3 &= 0x3FFFFFF;
+    h4 += c; c = h4 >> 26; h4 &= 0x3FFFFFF;
+    h0 += c * 5; c = h0 >> 26; h0 &= 0x3FFFFFF;
+    h1 += c;
+
+    /* Compute h - p and select it in constant time if h >= p */
+    g0 = h0 + 5; c = g0 >> 26; g0 &= 0x3FFFFFF;
+    g1 = h1 + c; c = g1 >> 26; g1 &= 0x3FFFFFF;
+    g2 = h2 + c; c = g2 >> 26; g2 &= 0x3FFFFFF;
+    g3 = h3 + c; c = g3 >> 26; g3 &= 0x3FFFFFF;
+    g4 = h4 + c - (1UL << 26);
+    mask = (g4 >> 31) - 1;
+    h0 = (h0 & ~mask) | (g0 & mask);
+    h1 = (h1 & ~mask) | (g1 & mask);
+    h2 = (h2 & ~mask) | (g2 & mask);
+    h3 = (h3 & ~mask) | (g3 & mask);
+    h4 = (h4 & ~mask) | (g4 & mask);
+
+    /* Truncate to 128 bits */
+    hash[0] = h0 | (h1 << 26);
+    hash[1] = (h1 >> 6) | (h2 << 20);
+    hash[2] = (h2 >> 12) | (h3 << 14);
+    hash[3] = (h3 >> 18) | (h4 << 8);
+    skinny_cleanse(block, sizeof(block));
+}
+
+/* Adds or subtracts a hash value to a block modulo 2^128, in place */
+static void skinny128_hctr_add
+    (uint8_t *block, const uint32_t hash[4], int subtract)
+{
+    uint64_t carry = 0;
+    unsigned posn;
+    for (posn = 0; posn < 4; ++posn) {
+        if (subtract) {
+            carry = (uint64_t)READ_WORD32(block, posn * 4) - hash[posn] -
+                    carry;
+            WRITE_WORD32(block, posn * 4, (uint32_t)carry);
+            carry = (carry >> 32) & 1;
+        } else {
+            carry += (uint64_t)READ_WORD32(block, posn * 4) + hash[posn];
+            WRITE_WORD32(block, posn * 4, (uint32_t)carry);
+            carry >>= 32;
+        }
+    }
+}
+
+int skinny128_hctr_init(Skinny128HCTR_t *hctr)
+{
+    Skinny128HCTRCtx_t *ctx;
+    if (!hctr)
+        return 0;
+    if ((ctx = calloc(1, sizeof(Skinny128HCTRCtx_t))) == NULL)
+        return 0;
+    if (!skinny128_ctr_init(&(ctx->ctr))) {
+        free(ctx);
+        return 0;
+    }
+    hctr->ctx = ctx;
+    return 1;
+}
+
+void skinny128_hctr_cleanup(Skinny128HCTR_t *hctr)
+{
+    if (hctr && hctr->ctx) {
+        Skinny128HCTRCtx_t *ctx = hctr->ctx;
+        skinny128_ctr_cleanup(&(ctx->ctr));
+        skinny_cleanse(ctx, sizeof(Skinny128HCTRCtx_t));
+        free(ctx);
+        hctr->ctx = 0;
+    }
+}
+
+int skinny128_hctr_set_key
+    (Skinny128HCTR_t *hctr, const void *key, unsigned size)
+{
+    Skinny128HCTRCtx_t *ctx;
+    Skinny128Key_t ks;
+    uint8_t subkeys[5][SKINNY128_BLOCK_SIZE];
+    unsigned index;
+    int ok;
+
+    /* Validate the parameters */
+    if (!hctr || !hctr->ctx || !key)
+        return 0;
+    ctx = hctr->ctx;
+
+    /* Derive the subkeys by encrypting the blocks 1, 2, 3, ... */
+    if (!skinny128_set_key(&ks, key, size))
+        return 0;
+    memset(subkeys, 0, sizeof(subkeys));
+    for (index = 0; index < 5; ++index) {
+        subkeys[index][SKINNY128_BLOCK_SIZE - 1] = (uint8_t)(index + 1);
+        skinny128_ecb_encrypt(subkeys[index], subkeys[index], &ks);
+    }
+
+    /* The first two subkeys are for CTR mode, the next two are for
+       the tweakable block cipher, and the last is the hash key */
+    ok = skinny128_ctr_set_key(&(ctx->ctr), subkeys[0],
+                               2 * SKINNY128_BLOCK_SIZE);
+    ok &= skinny128_set_tweaked_key(&(ctx->kt), subkeys[2],
+                                    2 * SKINNY128_BLOCK_SIZE);
+    ctx->r[0] = READ_WORD32(subkeys[4], 0) & 0x3FFFFFF;
+    ctx->r[1] = (READ_WORD32(subkeys[4], 3) >> 2) & 0x3FFFF03;
+    ctx->r[2] = (READ_WORD32(subkeys[4], 6) >> 4) & 0x3FFC0FF;
+    ctx->r[3] = (READ_WORD32(subkeys[4], 9) >> 6) & 0x3F03FFF;
+    ctx->r[4] = (READ_WORD32(subkeys[4], 12) >> 8) & 0x00FFFFF;
+    skinny_cleanse(&ks, sizeof(ks));
+    skinny_cleanse(subkeys, sizeof(subkeys));
+    return ok;
+}
+
+int skinny128_hctr_encrypt
+    (void *output, const void *input, size_t page_size,
+     const void *tweaks, size_t count, Skinny128HCTR_t *hctr)
+{
+    Skinny128HCTRCtx_t *ctx;
+    uint8_t block[SKINNY128_BLOCK_SIZE];
+    uint32_t hash[4];
+    size_t rest;
+
+    /* Validate the parameters */
+    if (!hctr || !hctr->ctx || !tweaks || page_size < SKINNY128_BLOCK_SIZE)
+        return 0;
+    ctx = hctr->ctx;
+    rest = page_size - SKINNY128_BLOCK_SIZE;
+
+    while (count > 0) {
+        /* Add the hash of the rest of the page to the first block */
+        memcpy(block, input, SKINNY128_BLOCK_SIZE);
+        skinny128_hctr_hash
+            (hash, ctx->r, ((const uint8_t *)input) + SKINNY128_BLOCK_SIZE,
+             rest);
+        skinny128_hctr_add(block, hash, 0);
+
+        /* Encrypt the first block with the page tweak */
+        skinny128_set_tweak(&(ctx->kt), tweaks, SKINNY128_HCTR_TWEAK_SIZE);
+        skinny128_ecb_encrypt(block, block, &(ctx->kt.ks));
+
+        /* Encrypt the rest of the page in CTR mode */
+        skinny128_ctr_set_counter(&(ctx->ctr), block, SKINNY128_BLOCK_SIZE);
+        skinny128_ctr_encrypt
+            (((uint8_t *)output) + SKINNY128_BLOCK_SIZE,
+             ((const uint8_t *)input) + SKINNY128_BLOCK_SIZE,
+             rest, &(ctx->ctr));
+
+        /* Subtract the hash of the ciphertext from the first block */
+        skinny128_hctr_hash
+            (hash, ctx->r, ((const uint8_t *)output) + SKINNY128_BLOCK_SIZE,
+             rest);
+        skinny128_hctr_add(block, hash, 1);
+        memcpy(output, block, SKINNY128_BLOCK_SIZE);
+
+        output += page_size;
+        input += page_size;
+        tweaks += SKINNY128_HCTR_TWEAK_SIZE;
+        --count;
+    }
+    skinny_cleanse(block, sizeof(block));
+    return 1;
+}
+
+int skinny128_hctr_decrypt
+    (void *output, const void *input, size_t page_size,
+     const void *tweaks, size_t count, Skinny128HCTR_t *hctr)
+{
+    Skinny128HCTRCtx_t *ctx;
+    uint8_t block[SKINNY128_BLOCK_SIZE];
+    uint32_t hash[4];
+    size_t rest;
+
+    /* Validate the parameters */
+    if (!hctr || !hctr->ctx || !tweaks || page_size < SKINNY128_BLOCK_SIZE)
+        return 0;
+    ctx = hctr->ctx;
+    rest = page_size - SKINNY128_BLOCK_SIZE;
+
+    while (count > 0) {
+        /* Add the hash of the ciphertext back to the first block */
+        memcpy(block, input, SKINNY128_BLOCK_SIZE);
+        skinny128_hctr_hash
+            (hash, ctx->r, ((const uint8_t *)input) + SKINNY128_BLOCK_SIZE,
+             rest);
+        skinny128_hctr_add(block, hash, 0);
+
+        /* Decrypt the rest of the page in CTR mode */
+        skinny128_ctr_set_counter(&(ctx->ctr), block, SKINNY128_BLOCK_SIZE);
+        skinny128_ctr_encrypt
+            (((uint8_t *)output) + SKINNY128_BLOCK_SIZE,
+             ((const uint8_t *)input) + SKINNY128_BLOCK_SIZE,
+             rest, &(ctx->ctr));
+
+        /* Decrypt the first block with the page tweak */
+        skinny128_set_tweak(&(ctx->kt), tweaks, SKINNY128_HCTR_TWEAK_SIZE);
+        skinny128_ecb_decrypt(block, block, &(ctx->kt.ks));
+
+        /* Subtract the hash of the plaintext from the first block */
+        skinny128_hctr_hash
+            (hash, ctx->r, ((const uint8_t *)output) + SKINNY128_BLOCK_SIZE,
+             rest);
+        skinny128_hctr_add(block, hash, 1);
+        memcpy(output, block, SKINNY128_BLOCK_SIZE);
+
+        output += page_size;
+        input += page_size;
+        tweaks += SKINNY128_HCTR_TWEAK_SIZE;
+        --count;
+    }
+    skinny_cleanse(block, sizeof(block));
+    return 1;
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2017 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "skinny128-kdf.h"
+#include "skinny128-parallel.h"
+#include "skinny-internal.h"
+
+/* Number of labels to process at once; a multiple of every parallel size */
+#define SKINNY128_KDF_BATCH 64
+
+/* Offsets of the fields in the tweakey after the padded master key */
+#define SKINNY128_KDF_TK_INDEX          32
+#define SKINNY128_KDF_TK_KEY_SIZE       33
+#define SKINNY128_KDF_TK_SUBKEY_SIZE    34
+
+int skinny128_kdf_set_key(Skinny128KDF_t *kdf, const void *key, unsigned size)
+{
+    /* Validate the parameters */
+    if (!kdf || !key || size < 16 || size > 32)
+        return 0;
+
+    /* The tweakey starts with the master key padded to 32 bytes and
+       its size.  The block index and subkey size are added later */
+    memset(kdf->tk, 0, sizeof(kdf->tk));
+    memcpy(kdf->tk, key, size);
+    kdf->tk[SKINNY128_KDF_TK_KEY_SIZE] = (uint8_t)size;
+    return 1;
+}
+
+int skinny128_kdf_derive
+    (void *subkeys, unsigned subkey_size, const void *labels,
+     size_t count, const Skinny128KDF_t *kdf)
+{
+    uint8_t batch[SKINNY128_KDF_BATCH * SKINNY128_BLOCK_SIZE];
+    Skinny128Key_t ks[SKINNY128_KDF_MAX_SUBKEY_SIZE / SKINNY128_BLOCK_SIZE];
+    uint8_t tk[SKINNY128_KDF_TWEAKEY_SIZE];
+    uint8_t *out = (uint8_t *)subkeys;
+    const uint8_t *in = (const uint8_t *)labels;
+    unsigned index, offset, len, blocks;
+    size_t n;
+
+    /* Validate the parameters */
+    if (!subkeys || !labels || !kdf || subkey_size < 1 ||
+            subkey_size > SKINNY128_KDF_MAX_SUBKEY_SIZE)
+        return 0;
+
+    /* Expand the key schedule for each block of the subkey, binding
+       the block index and the subkey size into the tweakey */
+    blocks = (subkey_size + SKINNY128_BLOCK_SIZE - 1) / SKINNY128_BLOCK_SIZE;
+    memcpy(tk, kdf->tk, sizeof(tk));
+    tk[SKINNY128_KDF_TK_SUBKEY_SIZE] = (uint8_t)subkey_size;
+    for (index = 0; index < blocks; ++index) {
+        tk[SKINNY128_KDF_TK_INDEX] = (uint8_t)(index + 1);
+        skinny128_set_key(&(ks[index]), tk, sizeof(tk));
+    }
+    skinny_cleanse(tk, sizeof(tk));
+
+    /* 16-byte subkeys can be encrypted directly into the output buffer */
+    if (subkey_size == SKINNY128_BLOCK_SIZE) {
+        skinny128_ecb_encrypt_blocks(out, in, count, &(ks[0]));
+        skinny_cleanse(ks, sizeof(ks));
+        return 1;
+    }
+
+    /* Encrypt a batch of labels with each key schedule in turn and then
+       scatter the results into the subkeys */
+    while (count > 0) {
+        n = count;
+        if (n > SKINNY128_KDF_BATCH)
+            n = SKINNY128_KDF_BATCH;
+        for (offset = 0; offset < subkey_size;
+                offset += SKINNY128_BLOCK_SIZE) {
+            skinny128_ecb_encrypt_blocks
+                (batch, in, n, &(ks[offset / SKINNY128_BLOCK_SIZE]));
+            len = subkey_size - offset;
+            if (len > SKINNY128_BLOCK_SIZE)
+                len = SKINNY128_BLOCK_SIZE;
+            for (index = 0; index < n; ++index) {
+                memcpy(out + index * subkey_size + offset,
+                       batch + index * SKINNY128_BLOCK_SIZE, len);
+            }
+        }
+        out += n * subkey_size;
+        in += n * SKINNY128_KDF_LABEL_SIZE;
+        count -= n;
+    }
+    skinny_cleanse(batch, sizeof(batch));
+    skinny_cleanse(ks, sizeof(ks));
+    return 1;
+}
+
+int skinny128_kdf_derive_keys
+    (Skinny128Key_t *schedules, unsigned key_size, const void *labels,
+     size_t count, const Skinny128KDF_t *kdf)
+{
+    uint8_t keys[SKINNY128_KDF_BATCH * SKINNY128_KDF_MAX_SUBKEY_SIZE];
+    const uint8_t *in = (const uint8_t *)labels;
+    unsigned index;
+    size_t n;
+    int ok = 1;
+
+    /* Validate the parameters */
+    if (!schedules || !labels || !kdf || key_size < 16 ||
+            key_size > SKINNY128_KDF_MAX_SUBKEY_SIZE)
+        return 0;
+
+    /* Derive the keys a batch at a time and expand each batch while
+       the raw key material is still in the cache */
+    while (count > 0 && ok) {
+        n = count;
+        if (n > SKINNY128_KDF_BATCH)
+            n = SKINNY128_KDF_BATCH;
+        ok = skinny128_kdf_derive(keys, key_size, in, n, kdf);
+        for (index = 0; ok && index < n; ++index)
+            ok = skinny128_set_key(schedules++, keys + index * key_size,
+                                   key_size);
+        in += n * SKINNY128_KDF_LABEL_SIZE;
+        count -= n;
+    }
+    skinny_cleanse(keys, sizeof(keys));
+    return ok;
+}
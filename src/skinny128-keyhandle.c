@@ -0,0 +1,330 @@
+/*
+ * Copyright (C) 2017 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#if !defined(_POSIX_C_SOURCE) && (defined(__unix__) || defined(__APPLE__))
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "skinny128-keyhandle.h"
+#include "skinny128-parallel.h"
+#include "skinny-internal.h"
+#include <stdlib.h>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sched.h>
+#define skinny_yield() sched_yield()
+#else
+#define skinny_yield() do { ; } while (0)
+#endif
+
+#if defined(__ATOMIC_SEQ_CST)
+#define SKINNY_HAVE_ATOMICS 1
+#define skinny_atomic_load(ptr) __atomic_load_n((ptr), __ATOMIC_SEQ_CST)
+#define skinny_atomic_store(ptr, value) \
+    __atomic_store_n((ptr), (value), __ATOMIC_SEQ_CST)
+#define skinny_atomic_exchange(ptr, value) \
+    __atomic_exchange_n((ptr), (value), __ATOMIC_SEQ_CST)
+#define skinny_atomic_add(ptr, value) \
+    __atomic_fetch_add((ptr), (value), __ATOMIC_SEQ_CST)
+#define skinny_atomic_sub(ptr, value) \
+    __atomic_fetch_sub((ptr), (value), __ATOMIC_SEQ_CST)
+#define skinny_atomic_try_lock(ptr) \
+    (!__atomic_test_and_set((ptr), __ATOMIC_ACQUIRE))
+#define skinny_atomic_unlock(ptr) __atomic_clear((ptr), __ATOMIC_RELEASE)
+#else
+#define SKINNY_HAVE_ATOMICS 0
+#endif
+
+/** One published version of the key schedule */
+typedef struct
+{
+    /** Expanded key schedule for this version */
+    Skinny128Key_t ks;
+
+    /** Base pointer for freeing this version */
+    void *base;
+
+} Skinny128KeyVersion_t;
+
+/** Reader count for one epoch, padded to a cache line of its own so
+    that readers of different epochs do not contend with each other */
+typedef struct
+{
+    /** Number of readers that entered in an epoch of this parity */
+    unsigned long count;
+
+    /** Padding out to 64 bytes */
+    unsigned char pad[64 - sizeof(unsigned long)];
+
+} Skinny128KeyReaders_t;
+
+/** Internal state information for a shared Skinny-128 key handle */
+typedef struct
+{
+    /** Reader counts for even and odd epochs */
+    Skinny128KeyReaders_t readers[2];
+
+    /** Currently published key schedule */
+    Skinny128KeyVersion_t *current;
+
+    /** Epoch number, which is incremented on every key rotation */
+    unsigned epoch;
+
+    /** Flag that serializes writers */
+    unsigned char lock;
+
+    /** Base pointer for freeing this context */
+    void *base;
+
+} Skinny128KeyHandleCtx_t;
+
+/** Number of blocks of keystream to generate at once in CTR mode */
+#define SKINNY128_KEY_HANDLE_CTR_BLOCKS 16
+
+static Skinny128KeyVersion_t *skinny128_key_version_new
+    (const void *key, unsigned size)
+{
+    Skinny128KeyVersion_t *version;
+    void *base;
+    if ((version = skinny_calloc(sizeof(Skinny128KeyVersion_t), &base)) == 0)
+        return 0;
+    version->base = base;
+    if (!skinny128_set_key(&(version->ks), key, size)) {
+        free(base);
+        return 0;
+    }
+    return version;
+}
+
+static void skinny128_key_version_free(Skinny128KeyVersion_t *version)
+{
+    void *base = version->base;
+    skinny_cleanse(version, sizeof(Skinny128KeyVersion_t));
+    free(base);
+}
+
+int skinny128_key_handle_init
+    (Skinny128KeyHandle_t *handle, const void *key, unsigned size)
+{
+#if SKINNY_HAVE_ATOMICS
+    Skinny128KeyHandleCtx_t *ctx;
+    void *base;
+
+    /* Validate the parameters */
+    if (!handle)
+        return 0;
+    handle->ctx = 0;
+    if (!key)
+        return 0;
+
+    /* Allocate the context and the first version of the key schedule */
+    if ((ctx = skinny_calloc(sizeof(Skinny128KeyHandleCtx_t), &base)) == 0)
+        return 0;
+    ctx->base = base;
+    if ((ctx->current = skinny128_key_version_new(key, size)) == 0) {
+        free(base);
+        return 0;
+    }
+    handle->ctx = ctx;
+    return 1;
+#else
+    (void)key;
+    (void)size;
+    if (handle)
+        handle->ctx = 0;
+    return 0;
+#endif
+}
+
+void skinny128_key_handle_cleanup(Skinny128KeyHandle_t *handle)
+{
+    Skinny128KeyHandleCtx_t *ctx;
+    if (handle && handle->ctx) {
+        ctx = handle->ctx;
+        skinny128_key_version_free(ctx->current);
+        free(ctx->base);
+        handle->ctx = 0;
+    }
+}
+
+#if SKINNY_HAVE_ATOMICS
+
+int skinny128_key_handle_rotate
+    (Skinny128KeyHandle_t *handle, const void *key, unsigned size)
+{
+    Skinny128KeyHandleCtx_t *ctx;
+    Skinny128KeyVersion_t *version;
+    unsigned epoch;
+
+    /* Validate the parameters */
+    if (!handle || !handle->ctx || !key)
+        return 0;
+    ctx = handle->ctx;
+
+    /* Expand the new key schedule before anyone can see it */
+    if ((version = skinny128_key_version_new(key, size)) == 0)
+        return 0;
+
+    /* Publish the new key schedule and start a new epoch.  Readers that
+       enter from now on will see the new key schedule */
+    while (!skinny_atomic_try_lock(&(ctx->lock)))
+        skinny_yield();
+    version = skinny_atomic_exchange(&(ctx->current), version);
+    epoch = skinny_atomic_load(&(ctx->epoch));
+    skinny_atomic_store(&(ctx->epoch), epoch + 1);
+
+    /* Wait for the readers from the previous epoch to leave.  They are
+       the only ones that could still be using the old key schedule */
+    while (skinny_atomic_load(&(ctx->readers[epoch & 1].count)) != 0)
+        skinny_yield();
+    skinny_atomic_unlock(&(ctx->lock));
+
+    /* Destroy the old key schedule */
+    skinny128_key_version_free(version);
+    return 1;
+}
+
+const Skinny128Key_t *skinny128_key_handle_acquire
+    (Skinny128KeyHandle_t *handle, unsigned *token)
+{
+    Skinny128KeyHandleCtx_t *ctx = handle->ctx;
+    Skinny128KeyVersion_t *version;
+    unsigned epoch;
+
+    /* Register as a reader of the current epoch.  If a writer started
+       a new epoch in the meantime then try again, because the writer
+       may not have seen us before it stopped waiting */
+    for (;;) {
+        epoch = skinny_atomic_load(&(ctx->epoch));
+        skinny_atomic_add(&(ctx->readers[epoch & 1].count), 1);
+        if (skinny_atomic_load(&(ctx->epoch)) == epoch)
+            break;
+        skinny_atomic_sub(&(ctx->readers[epoch & 1].count), 1);
+    }
+    version = skinny_atomic_load(&(ctx->current));
+    *token = epoch & 1;
+    return &(version->ks);
+}
+
+void skinny128_key_handle_release
+    (Skinny128KeyHandle_t *handle, unsigned token)
+{
+    Skinny128KeyHandleCtx_t *ctx = handle->ctx;
+    skinny_atomic_sub(&(ctx->readers[token & 1].count), 1);
+}
+
+#else /* !SKINNY_HAVE_ATOMICS */
+
+int skinny128_key_handle_rotate
+    (Skinny128KeyHandle_t *handle, const void *key, unsigned size)
+{
+    (void)handle;
+    (void)key;
+    (void)size;
+    return 0;
+}
+
+const Skinny128Key_t *skinny128_key_handle_acquire
+    (Skinny128KeyHandle_t *handle, unsigned *token)
+{
+    (void)handle;
+    *token = 0;
+    return 0;
+}
+
+void skinny128_key_handle_release
+    (Skinny128KeyHandle_t *handle, unsigned token)
+{
+    (void)handle;
+    (void)token;
+}
+
+#endif /* !SKINNY_HAVE_ATOMICS */
+
+int skinny128_key_handle_ecb_encrypt
+    (void *output, const void *input, size_t size,
+     Skinny128KeyHandle_t *handle)
+{
+    const Skinny128Key_t *ks;
+    unsigned token;
+    if (!handle || !handle->ctx || (size % SKINNY128_BLOCK_SIZE) != 0)
+        return 0;
+    ks = skinny128_key_handle_acquire(handle, &token);
+    skinny128_ecb_encrypt_blocks
+        (output, input, size / SKINNY128_BLOCK_SIZE, ks);
+    skinny128_key_handle_release(handle, token);
+    return 1;
+}
+
+int skinny128_key_handle_ecb_decrypt
+    (void *output, const void *input, size_t size,
+     Skinny128KeyHandle_t *handle)
+{
+    const Skinny128Key_t *ks;
+    unsigned token;
+    if (!handle || !handle->ctx || (size % SKINNY128_BLOCK_SIZE) != 0)
+        return 0;
+    ks = skinny128_key_handle_acquire(handle, &token);
+    skinny128_ecb_decrypt_blocks
+        (output, input, size / SKINNY128_BLOCK_SIZE, ks);
+    skinny128_key_handle_release(handle, token);
+    return 1;
+}
+
+int skinny128_key_handle_ctr_encrypt
+    (void *output, const void *input, size_t size, void *counter,
+     Skinny128KeyHandle_t *handle)
+{
+    uint8_t keystream[SKINNY128_KEY_HANDLE_CTR_BLOCKS * SKINNY128_BLOCK_SIZE];
+    uint8_t *out = (uint8_t *)output;
+    const uint8_t *in = (const uint8_t *)input;
+    const Skinny128Key_t *ks;
+    unsigned token;
+    size_t blocks, index, len;
+
+    /* Validate the parameters */
+    if (!handle || !handle->ctx || !counter)
+        return 0;
+
+    /* Generate the keystream a batch of counter blocks at a time */
+    ks = skinny128_key_handle_acquire(handle, &token);
+    while (size > 0) {
+        blocks = (size + SKINNY128_BLOCK_SIZE - 1) / SKINNY128_BLOCK_SIZE;
+        if (blocks > SKINNY128_KEY_HANDLE_CTR_BLOCKS)
+            blocks = SKINNY128_KEY_HANDLE_CTR_BLOCKS;
+        for (index = 0; index < blocks; ++index) {
+            memcpy(keystream + index * SKINNY128_BLOCK_SIZE, counter,
+                   SKINNY128_BLOCK_SIZE);
+            skinny128_inc_counter((uint8_t *)counter, 1);
+        }
+        skinny128_ecb_encrypt_blocks(keystream, keystream, blocks, ks);
+        len = blocks * SKINNY128_BLOCK_SIZE;
+        if (len > size)
+            len = size;
+        skinny_xor(out, in, keystream, len);
+        out += len;
+        in += len;
+        size -= len;
+    }
+    skinny128_key_handle_release(handle, token);
+    skinny_cleanse(keystream, sizeof(keystream));
+    return 1;
+}
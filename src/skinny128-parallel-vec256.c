@@ -20,6 +20,8 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+#define SKINNY_TARGET_VEC256 1
+
 #include "skinny128-parallel.h"
 #include "skinny-internal.h"
 
@@ -436,3 +438,5 @@ void _skinny128_parallel_decrypt_vec256
 }
 
 #endif /* !SKINNY_VEC256_MATH */
+
+SKINNY_TARGET_END
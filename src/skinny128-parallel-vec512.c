@@ -0,0 +1,256 @@
+/*
+ * Copyright (C) 2017 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#define SKINNY_TARGET_VEC512 1
+
+#include "skinny128-parallel.h"
+#include "skinny-internal.h"
+
+#if SKINNY_VEC512_MATH
+
+STATIC_INLINE SkinnyVector16x32_t skinny128_rotate_right
+    (SkinnyVector16x32_t x, unsigned count)
+{
+    /* Note: we are rotating the cells right, which actually moves
+       the values up closer to the MSB.  That is, we do a left shift
+       on the word to rotate the cells in the word right */
+    return (x << count) | (x >> (32 - count));
+}
+
+/* Computes "~(a | b) & mask" with a single VPTERNLOGD instruction */
+STATIC_INLINE SkinnyVector16x32_t skinny128_nor_and
+    (SkinnyVector16x32_t a, SkinnyVector16x32_t b, uint32_t mask)
+{
+    return skinny_ternlog_16x32(a, b, skinny_to_vec16x32(mask), 0x02);
+}
+
+/* Computes "a ^ b ^ c" with a single VPTERNLOGD instruction */
+STATIC_INLINE SkinnyVector16x32_t skinny128_xor3
+    (SkinnyVector16x32_t a, SkinnyVector16x32_t b, SkinnyVector16x32_t c)
+{
+    return skinny_ternlog_16x32(a, b, c, 0x96);
+}
+
+/* Computes "a | (b & mask)" with a single VPTERNLOGD instruction */
+STATIC_INLINE SkinnyVector16x32_t skinny128_or_and
+    (SkinnyVector16x32_t a, SkinnyVector16x32_t b, uint32_t mask)
+{
+    return skinny_ternlog_16x32(a, b, skinny_to_vec16x32(mask), 0xF8);
+}
+
+/* Each NOR/AND/XOR step of the bit-sliced S-box collapses into two
+   ternary logic instructions, and the final bit permutation becomes
+   a chain of shifts merged with masked OR's */
+STATIC_INLINE SkinnyVector16x32_t skinny128_sbox(SkinnyVector16x32_t x)
+{
+    SkinnyVector16x32_t y;
+
+    x ^= skinny128_nor_and(x >> 2, x >> 3, 0x11111111U);
+
+    y = skinny128_nor_and(x << 5, x << 1, 0x20202020U);
+    x = skinny128_xor3
+        (x, skinny128_nor_and(x << 5, x << 4, 0x40404040U), y);
+
+    y = skinny128_nor_and(x << 2, x << 1, 0x80808080U);
+    x = skinny128_xor3
+        (x, skinny128_nor_and(x >> 2, x << 1, 0x02020202U), y);
+
+    y = skinny128_nor_and(x >> 5, x << 1, 0x04040404U);
+    x = skinny128_xor3
+        (x, skinny128_nor_and(x >> 1, x >> 2, 0x08080808U), y);
+
+    y = (x << 1) & 0x10101010U;
+    y = skinny128_or_and(y, x << 2, 0xC8C8C8C8U);
+    y = skinny128_or_and(y, x << 5, 0x20202020U);
+    y = skinny128_or_and(y, x >> 6, 0x02020202U);
+    y = skinny128_or_and(y, x >> 4, 0x04040404U);
+    return skinny128_or_and(y, x >> 2, 0x01010101U);
+}
+
+STATIC_INLINE SkinnyVector16x32_t skinny128_inv_sbox(SkinnyVector16x32_t x)
+{
+    SkinnyVector16x32_t y;
+
+    y = skinny128_nor_and(x >> 1, x >> 3, 0x01010101U);
+    x = skinny128_xor3
+        (x, skinny128_nor_and(x >> 2, x >> 3, 0x10101010U), y);
+
+    y = skinny128_nor_and(x >> 6, x >> 1, 0x02020202U);
+    x = skinny128_xor3
+        (x, skinny128_nor_and(x >> 1, x >> 2, 0x08080808U), y);
+
+    y = skinny128_nor_and(x << 2, x << 1, 0x80808080U);
+    x = skinny128_xor3
+        (x, skinny128_nor_and(x >> 1, x << 2, 0x04040404U), y);
+
+    y = skinny128_nor_and(x << 5, x << 1, 0x20202020U);
+    x = skinny128_xor3
+        (x, skinny128_nor_and(x << 4, x << 5, 0x40404040U), y);
+
+    y = (x << 2) & 0x04040404U;
+    y = skinny128_or_and(y, x << 4, 0x40404040U);
+    y = skinny128_or_and(y, x << 6, 0x80808080U);
+    y = skinny128_or_and(y, x >> 5, 0x01010101U);
+    y = skinny128_or_and(y, x >> 2, 0x32323232U);
+    return skinny128_or_and(y, x >> 1, 0x08080808U);
+}
+
+/* Write the rows of all sixteen blocks back to memory */
+STATIC_INLINE void skinny128_store_rows
+    (void *output, SkinnyVector16x32_t row0, SkinnyVector16x32_t row1,
+     SkinnyVector16x32_t row2, SkinnyVector16x32_t row3)
+{
+    __m512i out[4];
+    skinny_transpose_16x32(out, row0, row1, row2, row3);
+    _mm512_storeu_si512(output, out[0]);
+    _mm512_storeu_si512(((__m512i *)output) + 1, out[1]);
+    _mm512_storeu_si512(((__m512i *)output) + 2, out[2]);
+    _mm512_storeu_si512(((__m512i *)output) + 3, out[3]);
+}
+
+void _skinny128_parallel_encrypt_vec512
+    (void *output, const void *input, const Skinny128Key_t *ks)
+{
+    SkinnyVector16x32_t rows[4];
+    SkinnyVector16x32_t row0;
+    SkinnyVector16x32_t row1;
+    SkinnyVector16x32_t row2;
+    SkinnyVector16x32_t row3;
+    const Skinny128HalfCells_t *schedule;
+    unsigned index;
+    SkinnyVector16x32_t temp;
+
+    /* Read the rows of all sixteen blocks into memory */
+    skinny_load_rows_16x32(rows, input);
+    row0 = rows[0];
+    row1 = rows[1];
+    row2 = rows[2];
+    row3 = rows[3];
+
+    /* Perform all encryption rounds on the sixteen blocks in parallel */
+    schedule = ks->schedule;
+    for (index = ks->rounds; index > 0; --index, ++schedule) {
+        /* Apply the S-box to all bytes in the state */
+        row0 = skinny128_sbox(row0);
+        row1 = skinny128_sbox(row1);
+        row2 = skinny128_sbox(row2);
+        row3 = skinny128_sbox(row3);
+
+        /* Apply the subkey for this round */
+        row0 ^= schedule->row[0];
+        row1 ^= schedule->row[1];
+        row2 ^= 0x02;
+
+        /* Shift the rows */
+        row1 = skinny128_rotate_right(row1, 8);
+        row2 = skinny128_rotate_right(row2, 16);
+        row3 = skinny128_rotate_right(row3, 24);
+
+        /* Mix the columns */
+        row1 ^= row2;
+        row2 ^= row0;
+        temp = row3 ^ row2;
+        row3 = row2;
+        row2 = row1;
+        row1 = row0;
+        row0 = temp;
+    }
+
+    /* Write the rows of all sixteen blocks back to memory */
+    skinny128_store_rows(output, row0, row1, row2, row3);
+}
+
+void _skinny128_parallel_decrypt_vec512
+    (void *output, const void *input, const Skinny128Key_t *ks)
+{
+    SkinnyVector16x32_t rows[4];
+    SkinnyVector16x32_t row0;
+    SkinnyVector16x32_t row1;
+    SkinnyVector16x32_t row2;
+    SkinnyVector16x32_t row3;
+    const Skinny128HalfCells_t *schedule;
+    unsigned index;
+    SkinnyVector16x32_t temp;
+
+    /* Read the rows of all sixteen blocks into memory */
+    skinny_load_rows_16x32(rows, input);
+    row0 = rows[0];
+    row1 = rows[1];
+    row2 = rows[2];
+    row3 = rows[3];
+
+    /* Perform all decryption rounds on the sixteen blocks in parallel */
+    schedule = &(ks->schedule[ks->rounds - 1]);
+    for (index = ks->rounds; index > 0; --index, --schedule) {
+        /* Inverse mix of the columns */
+        temp = row3;
+        row3 = row0;
+        row0 = row1;
+        row1 = row2;
+        row3 ^= temp;
+        row2 = temp ^ row0;
+        row1 ^= row2;
+
+        /* Inverse shift of the rows */
+        row1 = skinny128_rotate_right(row1, 24);
+        row2 = skinny128_rotate_right(row2, 16);
+        row3 = skinny128_rotate_right(row3, 8);
+
+        /* Apply the subkey for this round */
+        row0 ^= schedule->row[0];
+        row1 ^= schedule->row[1];
+        row2 ^= 0x02;
+
+        /* Apply the inverse S-box to all bytes in the state */
+        row0 = skinny128_inv_sbox(row0);
+        row1 = skinny128_inv_sbox(row1);
+        row2 = skinny128_inv_sbox(row2);
+        row3 = skinny128_inv_sbox(row3);
+    }
+
+    /* Write the rows of all sixteen blocks back to memory */
+    skinny128_store_rows(output, row0, row1, row2, row3);
+}
+
+#else /* !SKINNY_VEC512_MATH */
+
+/* Stubbed out */
+
+void _skinny128_parallel_encrypt_vec512
+    (void *output, const void *input, const Skinny128Key_t *ks)
+{
+    (void)output;
+    (void)input;
+    (void)ks;
+}
+
+void _skinny128_parallel_decrypt_vec512
+    (void *output, const void *input, const Skinny128Key_t *ks)
+{
+    (void)output;
+    (void)input;
+    (void)ks;
+}
+
+#endif /* !SKINNY_VEC512_MATH */
+
+SKINNY_TARGET_END
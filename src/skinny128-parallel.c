@@ -34,9 +34,23 @@ typedef struct
 {
     void (*encrypt)(void *output, const void *input, const Skinny128Key_t *ks);
     void (*decrypt)(void *output, const void *input, const Skinny128Key_t *ks);
+    size_t parallel_size;
+    const char *name;
 
 } Skinny128ParallelECBVtable_t;
 
+void _skinny128_parallel_encrypt_x2
+    (void *output, const void *input, const Skinny128Key_t *ks);
+void _skinny128_parallel_decrypt_x2
+    (void *output, const void *input, const Skinny128Key_t *ks);
+
+static Skinny128ParallelECBVtable_t const skinny128_parallel_ecb_x2 = {
+    _skinny128_parallel_encrypt_x2,
+    _skinny128_parallel_decrypt_x2,
+    2 * SKINNY128_BLOCK_SIZE,
+    "x2"
+};
+
 void _skinny128_parallel_encrypt_vec128
     (void *output, const void *input, const Skinny128Key_t *ks);
 void _skinny128_parallel_decrypt_vec128
@@ -44,7 +58,9 @@ void _skinny128_parallel_decrypt_vec128
 
 static Skinny128ParallelECBVtable_t const skinny128_parallel_ecb_vec128 = {
     _skinny128_parallel_encrypt_vec128,
-    _skinny128_parallel_decrypt_vec128
+    _skinny128_parallel_decrypt_vec128,
+    4 * SKINNY128_BLOCK_SIZE,
+    "vec128"
 };
 
 void _skinny128_parallel_encrypt_vec256
@@ -54,37 +70,93 @@ void _skinny128_parallel_decrypt_vec256
 
 static Skinny128ParallelECBVtable_t const skinny128_parallel_ecb_vec256 = {
     _skinny128_parallel_encrypt_vec256,
-    _skinny128_parallel_decrypt_vec256
+    _skinny128_parallel_decrypt_vec256,
+    8 * SKINNY128_BLOCK_SIZE,
+    "vec256"
+};
+
+void _skinny128_parallel_encrypt_vec512
+    (void *output, const void *input, const Skinny128Key_t *ks);
+void _skinny128_parallel_decrypt_vec512
+    (void *output, const void *input, const Skinny128Key_t *ks);
+
+static Skinny128ParallelECBVtable_t const skinny128_parallel_ecb_vec512 = {
+    _skinny128_parallel_encrypt_vec512,
+    _skinny128_parallel_decrypt_vec512,
+    16 * SKINNY128_BLOCK_SIZE,
+    "vec512"
 };
 
 /** @endcond */
 
+/* Lists the parallel back ends that are usable on this platform, in
+   increasing order of preference.  Without SIMD support, we fall back
+   to interleaving two blocks in scalar registers */
+static unsigned skinny128_parallel_ecb_backends
+    (const Skinny128ParallelECBVtable_t **list)
+{
+    unsigned count = 0;
+    list[count++] = &skinny128_parallel_ecb_x2;
+    if (_skinny_has_vec128())
+        list[count++] = &skinny128_parallel_ecb_vec128;
+    if (_skinny_has_vec256())
+        list[count++] = &skinny128_parallel_ecb_vec256;
+    if (_skinny_has_vec512())
+        list[count++] = &skinny128_parallel_ecb_vec512;
+    return count;
+}
+
+/* Back end that was chosen by the autotuner, or NULL if not tuned */
+static const Skinny128ParallelECBVtable_t *skinny128_parallel_ecb_tuned = 0;
+
+/* Chooses the best parallel back end for this platform */
+static const Skinny128ParallelECBVtable_t *skinny128_parallel_ecb_select
+    (size_t *parallel_size)
+{
+    const Skinny128ParallelECBVtable_t *list[SKINNY_AUTOTUNE_MAX_BACKENDS];
+    const Skinny128ParallelECBVtable_t *vtable;
+    vtable = skinny128_parallel_ecb_tuned;
+    if (!vtable)
+        vtable = list[skinny128_parallel_ecb_backends(list) - 1];
+    *parallel_size = vtable->parallel_size;
+    return vtable;
+}
+
 int skinny128_parallel_ecb_init(Skinny128ParallelECB_t *ecb)
 {
     Skinny128Key_t *ctx;
+    const Skinny128ParallelECBVtable_t *vtable;
     if ((ctx = calloc(1, sizeof(Skinny128Key_t))) == NULL)
         return 0;
-    ecb->vtable = 0;
     ecb->ctx = ctx;
-    ecb->parallel_size = 4 * SKINNY128_BLOCK_SIZE;
-    if (_skinny_has_vec128())
-        ecb->vtable = &skinny128_parallel_ecb_vec128;
-    if (_skinny_has_vec256()) {
-        ecb->vtable = &skinny128_parallel_ecb_vec256;
-        ecb->parallel_size = 8 * SKINNY128_BLOCK_SIZE;
-    }
+    SKINNY_STAT_ADD(context_allocs, 1);
+    vtable = skinny128_parallel_ecb_select(&(ecb->parallel_size));
+    ecb->vtable = vtable;
+    SKINNY_PROBE3(skinny128_parallel_ecb_init, ecb,
+                  vtable->name, ecb->parallel_size);
     return 1;
 }
 
 void skinny128_parallel_ecb_cleanup(Skinny128ParallelECB_t *ecb)
 {
     if (ecb && ecb->ctx) {
+        SKINNY_PROBE1(skinny128_parallel_ecb_cleanup, ecb);
         skinny_cleanse(ecb->ctx, sizeof(Skinny128Key_t));
         free(ecb->ctx);
         ecb->ctx = 0;
     }
 }
 
+const char *skinny128_parallel_ecb_backend_name
+    (const Skinny128ParallelECB_t *ecb)
+{
+    const Skinny128ParallelECBVtable_t *vtable;
+    if (!ecb || !ecb->ctx)
+        return 0;
+    vtable = ecb->vtable;
+    return vtable->name;
+}
+
 int skinny128_parallel_ecb_set_key
     (Skinny128ParallelECB_t *ecb, const void *key, unsigned size)
 {
@@ -101,17 +173,21 @@ int skinny128_parallel_ecb_encrypt
 {
     const Skinny128Key_t *ks;
     const Skinny128ParallelECBVtable_t *vtable;
+    size_t total;
 
     /* Validate the parameters */
     if (!ecb || !ecb->ctx || (size % SKINNY128_BLOCK_SIZE) != 0)
         return 0;
     ks = ecb->ctx;
+    total = size;
+    SKINNY_PROBE2(skinny128_parallel_ecb_encrypt_start, ecb, size);
 
     /* Process major blocks with the vectorized back end */
     vtable = ecb->vtable;
     if (vtable) {
         size_t psize = ecb->parallel_size;
         while (size >= psize) {
+            SKINNY_STAT_ADD(parallel_blocks, psize / SKINNY128_BLOCK_SIZE);
             (*(vtable->encrypt))(output, input, ks);
             output += psize;
             input += psize;
@@ -120,12 +196,14 @@ int skinny128_parallel_ecb_encrypt
     }
 
     /* Process any left-over blocks with the non-parallel implementation */
+    SKINNY_STAT_ADD(tail_blocks, size / SKINNY128_BLOCK_SIZE);
     while (size >= SKINNY128_BLOCK_SIZE) {
         skinny128_ecb_encrypt(output, input, ks);
         output += SKINNY128_BLOCK_SIZE;
         input += SKINNY128_BLOCK_SIZE;
         size -= SKINNY128_BLOCK_SIZE;
     }
+    SKINNY_PROBE2(skinny128_parallel_ecb_encrypt_done, ecb, total);
     return 1;
 }
 
@@ -135,17 +213,21 @@ int skinny128_parallel_ecb_decrypt
 {
     const Skinny128Key_t *ks;
     const Skinny128ParallelECBVtable_t *vtable;
+    size_t total;
 
     /* Validate the parameters */
     if (!ecb || !ecb->ctx || (size % SKINNY128_BLOCK_SIZE) != 0)
         return 0;
     ks = ecb->ctx;
+    total = size;
+    SKINNY_PROBE2(skinny128_parallel_ecb_decrypt_start, ecb, size);
 
     /* Process major blocks with the vectorized back end */
     vtable = ecb->vtable;
     if (vtable) {
         size_t psize = ecb->parallel_size;
         while (size >= psize) {
+            SKINNY_STAT_ADD(parallel_blocks, psize / SKINNY128_BLOCK_SIZE);
             (*(vtable->decrypt))(output, input, ks);
             output += psize;
             input += psize;
@@ -154,11 +236,145 @@ int skinny128_parallel_ecb_decrypt
     }
 
     /* Process any left-over blocks with the non-parallel implementation */
+    SKINNY_STAT_ADD(tail_blocks, size / SKINNY128_BLOCK_SIZE);
     while (size >= SKINNY128_BLOCK_SIZE) {
         skinny128_ecb_decrypt(output, input, ks);
         output += SKINNY128_BLOCK_SIZE;
         input += SKINNY128_BLOCK_SIZE;
         size -= SKINNY128_BLOCK_SIZE;
     }
+    SKINNY_PROBE2(skinny128_parallel_ecb_decrypt_done, ecb, total);
     return 1;
 }
+
+void skinny128_ecb_encrypt_blocks
+    (void *output, const void *input, size_t count, const Skinny128Key_t *ks)
+{
+    const Skinny128ParallelECBVtable_t *vtable;
+    size_t psize;
+
+    /* Process major blocks with the best vectorized back end */
+    vtable = skinny128_parallel_ecb_select(&psize);
+    SKINNY_PROBE3(skinny128_ecb_encrypt_blocks_start, ks, count,
+                  vtable->name);
+    if (vtable) {
+        size_t pcount = psize / SKINNY128_BLOCK_SIZE;
+        while (count >= pcount) {
+            SKINNY_STAT_ADD(parallel_blocks, pcount);
+            (*(vtable->encrypt))(output, input, ks);
+            output += psize;
+            input += psize;
+            count -= pcount;
+        }
+    }
+
+    /* Process any left-over blocks with the non-parallel implementation */
+    SKINNY_STAT_ADD(tail_blocks, count);
+    while (count > 0) {
+        skinny128_ecb_encrypt(output, input, ks);
+        output += SKINNY128_BLOCK_SIZE;
+        input += SKINNY128_BLOCK_SIZE;
+        --count;
+    }
+    SKINNY_PROBE1(skinny128_ecb_encrypt_blocks_done, ks);
+}
+
+void skinny128_ecb_decrypt_blocks
+    (void *output, const void *input, size_t count, const Skinny128Key_t *ks)
+{
+    const Skinny128ParallelECBVtable_t *vtable;
+    size_t psize;
+
+    /* Process major blocks with the best vectorized back end */
+    vtable = skinny128_parallel_ecb_select(&psize);
+    SKINNY_PROBE3(skinny128_ecb_decrypt_blocks_start, ks, count,
+                  vtable->name);
+    if (vtable) {
+        size_t pcount = psize / SKINNY128_BLOCK_SIZE;
+        while (count >= pcount) {
+            SKINNY_STAT_ADD(parallel_blocks, pcount);
+            (*(vtable->decrypt))(output, input, ks);
+            output += psize;
+            input += psize;
+            count -= pcount;
+        }
+    }
+
+    /* Process any left-over blocks with the non-parallel implementation */
+    SKINNY_STAT_ADD(tail_blocks, count);
+    while (count > 0) {
+        skinny128_ecb_decrypt(output, input, ks);
+        output += SKINNY128_BLOCK_SIZE;
+        input += SKINNY128_BLOCK_SIZE;
+        --count;
+    }
+    SKINNY_PROBE1(skinny128_ecb_decrypt_blocks_done, ks);
+}
+
+/** @cond */
+
+/**
+ * \brief State for timing a parallel back end with the autotuner.
+ */
+typedef struct
+{
+    const Skinny128ParallelECBVtable_t *vtable;
+    Skinny128Key_t ks;
+    unsigned char data[SKINNY_AUTOTUNE_SIZE];
+
+} Skinny128ParallelECBTune_t;
+
+/** @endcond */
+
+static void skinny128_parallel_ecb_time(void *arg)
+{
+    Skinny128ParallelECBTune_t *tune = arg;
+    const Skinny128ParallelECBVtable_t *vtable = tune->vtable;
+    size_t posn;
+    for (posn = 0; posn < SKINNY_AUTOTUNE_SIZE;
+            posn += vtable->parallel_size) {
+        (*(vtable->encrypt))(tune->data + posn, tune->data + posn,
+                             &(tune->ks));
+    }
+}
+
+const char *_skinny128_parallel_ecb_autotune(const char *name)
+{
+    const Skinny128ParallelECBVtable_t *list[SKINNY_AUTOTUNE_MAX_BACKENDS];
+    Skinny128ParallelECBTune_t *tune;
+    uint64_t time, best_time = ~((uint64_t)0);
+    unsigned count, index, best;
+
+    /* Select a specific back end by name */
+    count = skinny128_parallel_ecb_backends(list);
+    if (name) {
+        for (index = 0; index < count; ++index) {
+            if (!strcmp(list[index]->name, name)) {
+                skinny128_parallel_ecb_tuned = list[index];
+                return list[index]->name;
+            }
+        }
+        return 0;
+    }
+
+    /* Time each back end, starting with the default choice.  Another
+       back end must be strictly faster to replace the default */
+    best = count - 1;
+    if ((tune = calloc(1, sizeof(Skinny128ParallelECBTune_t))) != NULL) {
+        skinny128_set_key(&(tune->ks), tune->data, SKINNY128_BLOCK_SIZE);
+        for (index = count; index > 0; ) {
+            --index;
+            tune->vtable = list[index];
+            time = _skinny_autotune_measure
+                (skinny128_parallel_ecb_time, tune);
+            if (time < best_time) {
+                best = index;
+                best_time = time;
+            }
+        }
+        skinny_cleanse(tune, sizeof(Skinny128ParallelECBTune_t));
+        free(tune);
+    }
+    skinny128_parallel_ecb_tuned = list[best];
+    return list[best]->name;
+}
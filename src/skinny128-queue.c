@@ -0,0 +1,415 @@
+/*
+ * Copyright (C) 2017 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#if !defined(_POSIX_C_SOURCE) && (defined(__unix__) || defined(__APPLE__))
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "skinny128-queue.h"
+#include "skinny128-parallel.h"
+#include "skinny-internal.h"
+#include <stdlib.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SKINNY_HAVE_PTHREADS 1
+#include <pthread.h>
+#include <time.h>
+#else
+#define SKINNY_HAVE_PTHREADS 0
+#endif
+
+/* Batching deadlines are measured on the monotonic clock so that a step
+   in the wall clock cannot stretch or collapse them.  macOS does not
+   have pthread_condattr_setclock(), so it falls back to the wall clock */
+#if SKINNY_HAVE_PTHREADS && defined(CLOCK_MONOTONIC) && !defined(__APPLE__)
+#define SKINNY128_QUEUE_CLOCK CLOCK_MONOTONIC
+#define SKINNY128_QUEUE_SET_CLOCK 1
+#else
+#define SKINNY128_QUEUE_CLOCK CLOCK_REALTIME
+#define SKINNY128_QUEUE_SET_CLOCK 0
+#endif
+
+#if SKINNY_HAVE_PTHREADS
+
+/** Maximum number of blocks that a worker takes in one batch */
+#define SKINNY128_QUEUE_MAX_BLOCKS (SKINNY128_QUEUE_BATCH_BLOCKS * 4)
+
+/** Maximum number of jobs that a worker takes in one batch */
+#define SKINNY128_QUEUE_MAX_JOBS 256
+
+/** Internal state information for a Skinny-128 job queue */
+typedef struct
+{
+    /** Protects all of the fields below and the jobs in the queue */
+    pthread_mutex_t mutex;
+
+    /** Signalled when there is work for the workers to look at */
+    pthread_cond_t work;
+
+    /** Signalled when jobs are done */
+    pthread_cond_t done;
+
+    /** First and last pending jobs */
+    Skinny128Job_t *head;
+    Skinny128Job_t *tail;
+
+    /** Number of blocks in the pending jobs */
+    size_t pending_blocks;
+
+    /** Maximum delay before starting on a job, in microseconds */
+    unsigned max_delay;
+
+    /** Non-zero when the queue is being shut down */
+    int stopping;
+
+    /** Worker threads */
+    unsigned num_threads;
+    pthread_t *threads;
+
+} Skinny128QueueCtx_t;
+
+/* Gets the current time in microseconds */
+static unsigned long long skinny128_queue_now(void)
+{
+    struct timespec ts;
+    clock_gettime(SKINNY128_QUEUE_CLOCK, &ts);
+    return ((unsigned long long)ts.tv_sec) * 1000000ULL +
+           (unsigned long long)(ts.tv_nsec / 1000);
+}
+
+/* Takes a batch of jobs off the front of the queue.  Must be called
+   with the mutex held */
+static unsigned skinny128_queue_take
+    (Skinny128QueueCtx_t *ctx, Skinny128Job_t **jobs)
+{
+    Skinny128Job_t *job;
+    size_t blocks = 0;
+    size_t job_blocks;
+    unsigned count = 0;
+    while ((job = ctx->head) != 0 && count < SKINNY128_QUEUE_MAX_JOBS) {
+        job_blocks = job->size / SKINNY128_BLOCK_SIZE;
+        if (count > 0 && (blocks + job_blocks) > SKINNY128_QUEUE_MAX_BLOCKS)
+            break;
+        ctx->head = job->next;
+        ctx->pending_blocks -= job_blocks;
+        blocks += job_blocks;
+        jobs[count++] = job;
+    }
+    if (!ctx->head)
+        ctx->tail = 0;
+    return count;
+}
+
+/* Processes a batch of jobs.  Small jobs that share a key schedule and
+   direction are packed into a single run of blocks */
+static void skinny128_queue_process(Skinny128Job_t **jobs, unsigned count)
+{
+    uint8_t staging[SKINNY128_QUEUE_MAX_BLOCKS * SKINNY128_BLOCK_SIZE];
+    uint8_t handled[SKINNY128_QUEUE_MAX_JOBS];
+    Skinny128Job_t *job;
+    Skinny128Job_t *leader;
+    unsigned index, posn;
+    size_t staged;
+    int used_staging = 0;
+
+    memset(handled, 0, count);
+    for (index = 0; index < count; ++index) {
+        if (handled[index])
+            continue;
+        leader = jobs[index];
+
+        /* Gather the small jobs with the same key schedule and direction */
+        staged = 0;
+        for (posn = index; posn < count; ++posn) {
+            job = jobs[posn];
+            if (handled[posn] || job->ks != leader->ks ||
+                    job->direction != leader->direction)
+                continue;
+            handled[posn] = 1;
+            if (job->size >= SKINNY128_QUEUE_BATCH_BLOCKS *
+                                SKINNY128_BLOCK_SIZE) {
+                /* Large jobs already fill the lanes by themselves */
+                if (job->direction == SKINNY128_JOB_DECRYPT) {
+                    skinny128_ecb_decrypt_blocks
+                        (job->output, job->input,
+                         job->size / SKINNY128_BLOCK_SIZE, job->ks);
+                } else {
+                    skinny128_ecb_encrypt_blocks
+                        (job->output, job->input,
+                         job->size / SKINNY128_BLOCK_SIZE, job->ks);
+                }
+            } else {
+                memcpy(staging + staged, job->input, job->size);
+                staged += job->size;
+            }
+        }
+        if (!staged)
+            continue;
+        used_staging = 1;
+
+        /* Process the packed blocks in one call */
+        if (leader->direction == SKINNY128_JOB_DECRYPT) {
+            skinny128_ecb_decrypt_blocks
+                (staging, staging, staged / SKINNY128_BLOCK_SIZE, leader->ks);
+        } else {
+            skinny128_ecb_encrypt_blocks
+                (staging, staging, staged / SKINNY128_BLOCK_SIZE, leader->ks);
+        }
+
+        /* Scatter the results back to the jobs in the same order */
+        staged = 0;
+        for (posn = index; posn < count; ++posn) {
+            job = jobs[posn];
+            if (job->ks != leader->ks || job->direction != leader->direction ||
+                    job->size >= SKINNY128_QUEUE_BATCH_BLOCKS *
+                                    SKINNY128_BLOCK_SIZE)
+                continue;
+            memcpy(job->output, staging + staged, job->size);
+            staged += job->size;
+        }
+    }
+    if (used_staging)
+        skinny_cleanse(staging, sizeof(staging));
+}
+
+static void *skinny128_queue_worker(void *arg)
+{
+    Skinny128QueueCtx_t *ctx = (Skinny128QueueCtx_t *)arg;
+    Skinny128Job_t *jobs[SKINNY128_QUEUE_MAX_JOBS];
+    Skinny128JobCallback_t callbacks[SKINNY128_QUEUE_MAX_JOBS];
+    unsigned long long now;
+    struct timespec ts;
+    unsigned count, index;
+
+    pthread_mutex_lock(&(ctx->mutex));
+    for (;;) {
+        /* Wait until there is a full batch or the oldest job is due */
+        if (!ctx->head) {
+            if (ctx->stopping)
+                break;
+            pthread_cond_wait(&(ctx->work), &(ctx->mutex));
+            continue;
+        }
+        if (!ctx->stopping &&
+                ctx->pending_blocks < SKINNY128_QUEUE_BATCH_BLOCKS) {
+            now = skinny128_queue_now();
+            if (now < ctx->head->deadline) {
+                ts.tv_sec = (time_t)(ctx->head->deadline / 1000000ULL);
+                ts.tv_nsec = (long)((ctx->head->deadline % 1000000ULL) * 1000);
+                pthread_cond_timedwait(&(ctx->work), &(ctx->mutex), &ts);
+                continue;
+            }
+        }
+
+        /* Take a batch and let another worker look at what is left */
+        count = skinny128_queue_take(ctx, jobs);
+        if (ctx->head)
+            pthread_cond_signal(&(ctx->work));
+        pthread_mutex_unlock(&(ctx->mutex));
+
+        /* Process the batch and mark the jobs as done.  The callbacks
+           are fetched first because a job may be freed by its owner
+           as soon as it is done */
+        skinny128_queue_process(jobs, count);
+        pthread_mutex_lock(&(ctx->mutex));
+        for (index = 0; index < count; ++index) {
+            callbacks[index] = jobs[index]->callback;
+            jobs[index]->done = 1;
+        }
+        pthread_cond_broadcast(&(ctx->done));
+        pthread_mutex_unlock(&(ctx->mutex));
+
+        /* Invoke the callbacks outside the lock.  The job is not touched
+           again afterwards, so the callback may free or reuse it */
+        for (index = 0; index < count; ++index) {
+            if (callbacks[index])
+                (*(callbacks[index]))(jobs[index]);
+        }
+        pthread_mutex_lock(&(ctx->mutex));
+    }
+    pthread_mutex_unlock(&(ctx->mutex));
+    return 0;
+}
+
+int skinny128_queue_init
+    (Skinny128Queue_t *queue, unsigned threads, unsigned max_delay_us)
+{
+    Skinny128QueueCtx_t *ctx;
+#if SKINNY128_QUEUE_SET_CLOCK
+    pthread_condattr_t attr;
+#endif
+    unsigned index;
+
+    /* Validate the parameters */
+    if (!queue)
+        return 0;
+    queue->ctx = 0;
+    if (!threads)
+        return 0;
+
+    /* Allocate the context */
+    if ((ctx = calloc(1, sizeof(Skinny128QueueCtx_t))) == 0)
+        return 0;
+    if ((ctx->threads = calloc(threads, sizeof(pthread_t))) == 0) {
+        free(ctx);
+        return 0;
+    }
+    pthread_mutex_init(&(ctx->mutex), 0);
+#if SKINNY128_QUEUE_SET_CLOCK
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, SKINNY128_QUEUE_CLOCK);
+    pthread_cond_init(&(ctx->work), &attr);
+    pthread_condattr_destroy(&attr);
+#else
+    pthread_cond_init(&(ctx->work), 0);
+#endif
+    pthread_cond_init(&(ctx->done), 0);
+    ctx->max_delay = max_delay_us;
+    queue->ctx = ctx;
+
+    /* Start the worker threads */
+    for (index = 0; index < threads; ++index) {
+        if (pthread_create(&(ctx->threads[index]), 0,
+                           skinny128_queue_worker, ctx) != 0) {
+            skinny128_queue_cleanup(queue);
+            return 0;
+        }
+        ++(ctx->num_threads);
+    }
+    return 1;
+}
+
+void skinny128_queue_cleanup(Skinny128Queue_t *queue)
+{
+    Skinny128QueueCtx_t *ctx;
+    unsigned index;
+    if (queue && queue->ctx) {
+        ctx = queue->ctx;
+
+        /* Stop the workers once they have drained the queue */
+        pthread_mutex_lock(&(ctx->mutex));
+        ctx->stopping = 1;
+        pthread_cond_broadcast(&(ctx->work));
+        pthread_mutex_unlock(&(ctx->mutex));
+        for (index = 0; index < ctx->num_threads; ++index)
+            pthread_join(ctx->threads[index], 0);
+
+        /* Free the context */
+        pthread_cond_destroy(&(ctx->done));
+        pthread_cond_destroy(&(ctx->work));
+        pthread_mutex_destroy(&(ctx->mutex));
+        free(ctx->threads);
+        free(ctx);
+        queue->ctx = 0;
+    }
+}
+
+int skinny128_queue_submit(Skinny128Queue_t *queue, Skinny128Job_t *job)
+{
+    Skinny128QueueCtx_t *ctx;
+
+    /* Validate the parameters */
+    if (!queue || !queue->ctx || !job || !job->ks)
+        return 0;
+    if ((job->size % SKINNY128_BLOCK_SIZE) != 0)
+        return 0;
+    if (job->size && (!job->output || !job->input))
+        return 0;
+    ctx = queue->ctx;
+
+    /* Add the job to the end of the queue */
+    job->done = 0;
+    job->next = 0;
+    job->deadline = skinny128_queue_now() + ctx->max_delay;
+    pthread_mutex_lock(&(ctx->mutex));
+    if (ctx->tail)
+        ctx->tail->next = job;
+    else
+        ctx->head = job;
+    ctx->tail = job;
+    ctx->pending_blocks += job->size / SKINNY128_BLOCK_SIZE;
+
+    /* Wake a worker if this job starts a new deadline or fills a batch.
+       Otherwise the workers are already waiting for the oldest job */
+    if (ctx->head == job ||
+            ctx->pending_blocks >= SKINNY128_QUEUE_BATCH_BLOCKS)
+        pthread_cond_signal(&(ctx->work));
+    pthread_mutex_unlock(&(ctx->mutex));
+    return 1;
+}
+
+int skinny128_queue_poll(Skinny128Queue_t *queue, const Skinny128Job_t *job)
+{
+    Skinny128QueueCtx_t *ctx = queue->ctx;
+    int done;
+    pthread_mutex_lock(&(ctx->mutex));
+    done = job->done;
+    pthread_mutex_unlock(&(ctx->mutex));
+    return done;
+}
+
+void skinny128_queue_wait(Skinny128Queue_t *queue, const Skinny128Job_t *job)
+{
+    Skinny128QueueCtx_t *ctx = queue->ctx;
+    pthread_mutex_lock(&(ctx->mutex));
+    while (!job->done)
+        pthread_cond_wait(&(ctx->done), &(ctx->mutex));
+    pthread_mutex_unlock(&(ctx->mutex));
+}
+
+#else /* !SKINNY_HAVE_PTHREADS */
+
+int skinny128_queue_init
+    (Skinny128Queue_t *queue, unsigned threads, unsigned max_delay_us)
+{
+    (void)threads;
+    (void)max_delay_us;
+    if (queue)
+        queue->ctx = 0;
+    return 0;
+}
+
+void skinny128_queue_cleanup(Skinny128Queue_t *queue)
+{
+    (void)queue;
+}
+
+int skinny128_queue_submit(Skinny128Queue_t *queue, Skinny128Job_t *job)
+{
+    (void)queue;
+    (void)job;
+    return 0;
+}
+
+int skinny128_queue_poll(Skinny128Queue_t *queue, const Skinny128Job_t *job)
+{
+    (void)queue;
+    return job->done;
+}
+
+void skinny128_queue_wait(Skinny128Queue_t *queue, const Skinny128Job_t *job)
+{
+    (void)queue;
+    (void)job;
+}
+
+#endif /* !SKINNY_HAVE_PTHREADS */
@@ -285,6 +285,7 @@ int skinny64_set_key(Skinny64Key_t *ks, const void *key, unsigned size)
 
     /* Set the key directly with no tweak */
     skinny64_set_key_inner(ks, key, size, 0);
+    SKINNY_PROBE2(skinny64_set_key, ks, size);
     return 1;
 }
 
@@ -302,6 +303,7 @@ int skinny64_set_tweaked_key
 
     /* Set the initial key and tweak value */
     skinny64_set_key_inner(&(ks->ks), key, key_size, ks->tweak);
+    SKINNY_PROBE2(skinny64_set_tweaked_key, ks, key_size);
     return 1;
 }
 
@@ -321,10 +323,12 @@ int skinny64_set_tweak
     memset(ks->tweak + tweak_size, 0, sizeof(ks->tweak) - tweak_size);
 
     /* XOR the original tweak out of the key schedule */
+    SKINNY_STAT_ADD(tweak_rewrites, 1);
     skinny64_xor_tk1(&(ks->ks), tk_prev);
 
     /* XOR the new tweak into the key schedule */
     skinny64_xor_tk1(&(ks->ks), ks->tweak);
+    SKINNY_PROBE2(skinny64_set_tweak, ks, tweak_size);
     return 1;
 }
 
@@ -444,140 +448,184 @@ STATIC_INLINE uint32_t skinny64_inv_sbox(uint32_t x)
 
 #endif
 
-void skinny64_ecb_encrypt
-    (void *output, const void *input, const Skinny64Key_t *ks)
+/* Loads a block into the state and converts little-endian to host-endian */
+STATIC_INLINE void skinny64_load_state
+    (Skinny64Cells_t *state, const void *input, unsigned offset)
 {
-    Skinny64Cells_t state;
-    const Skinny64HalfCells_t *schedule;
-    unsigned index;
-    uint32_t temp;
+#if SKINNY_64BIT && SKINNY_LITTLE_ENDIAN
+    state->llrow = READ_WORD64(input, offset);
+#elif SKINNY_LITTLE_ENDIAN
+    state->lrow[0] = READ_WORD32(input, offset);
+    state->lrow[1] = READ_WORD32(input, offset + 4);
+#else
+    state->row[0] = READ_WORD16(input, offset);
+    state->row[1] = READ_WORD16(input, offset + 2);
+    state->row[2] = READ_WORD16(input, offset + 4);
+    state->row[3] = READ_WORD16(input, offset + 6);
+#endif
+}
 
-    /* Read the input buffer and convert little-endian to host-endian */
+/* Converts the state back into little-endian in an output buffer */
+STATIC_INLINE void skinny64_store_state
+    (void *output, unsigned offset, const Skinny64Cells_t *state)
+{
 #if SKINNY_64BIT && SKINNY_LITTLE_ENDIAN
-    state.llrow = READ_WORD64(input, 0);
+    WRITE_WORD64(output, offset, state->llrow);
 #elif SKINNY_LITTLE_ENDIAN
-    state.lrow[0] = READ_WORD32(input, 0);
-    state.lrow[1] = READ_WORD32(input, 4);
+    WRITE_WORD32(output, offset, state->lrow[0]);
+    WRITE_WORD32(output, offset + 4, state->lrow[1]);
 #else
-    state.row[0] = READ_WORD16(input, 0);
-    state.row[1] = READ_WORD16(input, 2);
-    state.row[2] = READ_WORD16(input, 4);
-    state.row[3] = READ_WORD16(input, 6);
+    WRITE_WORD16(output, offset, state->row[0]);
+    WRITE_WORD16(output, offset + 2, state->row[1]);
+    WRITE_WORD16(output, offset + 4, state->row[2]);
+    WRITE_WORD16(output, offset + 6, state->row[3]);
 #endif
+}
 
-    /* Perform all encryption rounds */
-    schedule = ks->schedule;
-    for (index = ks->rounds; index > 0; --index, ++schedule) {
-        /* Apply the S-box to all bytes in the state */
+/* Performs a single encryption round on the state */
+STATIC_INLINE void skinny64_encrypt_round
+    (Skinny64Cells_t *state, const Skinny64HalfCells_t *schedule)
+{
+    uint32_t temp;
+
+    /* Apply the S-box to all bytes in the state */
 #if SKINNY_64BIT
-        state.llrow = skinny64_sbox(state.llrow);
+    state->llrow = skinny64_sbox(state->llrow);
 #else
-        state.lrow[0] = skinny64_sbox(state.lrow[0]);
-        state.lrow[1] = skinny64_sbox(state.lrow[1]);
+    state->lrow[0] = skinny64_sbox(state->lrow[0]);
+    state->lrow[1] = skinny64_sbox(state->lrow[1]);
 #endif
 
-        /* Apply the subkey for this round */
+    /* Apply the subkey for this round */
 #if SKINNY_64BIT && SKINNY_LITTLE_ENDIAN
-        state.llrow ^= schedule->lrow | 0x2000000000ULL;
+    state->llrow ^= schedule->lrow | 0x2000000000ULL;
 #else
-        state.lrow[0] ^= schedule->lrow;
-        state.row[2] ^= 0x20;
+    state->lrow[0] ^= schedule->lrow;
+    state->row[2] ^= 0x20;
 #endif
 
-        /* Shift the rows */
-        state.row[1] = skinny64_rotate_right(state.row[1], 4);
-        state.row[2] = skinny64_rotate_right(state.row[2], 8);
-        state.row[3] = skinny64_rotate_right(state.row[3], 12);
-
-        /* Mix the columns */
-        state.row[1] ^= state.row[2];
-        state.row[2] ^= state.row[0];
-        temp = state.row[3] ^ state.row[2];
-        state.row[3] = state.row[2];
-        state.row[2] = state.row[1];
-        state.row[1] = state.row[0];
-        state.row[0] = temp;
-    }
+    /* Shift the rows */
+    state->row[1] = skinny64_rotate_right(state->row[1], 4);
+    state->row[2] = skinny64_rotate_right(state->row[2], 8);
+    state->row[3] = skinny64_rotate_right(state->row[3], 12);
+
+    /* Mix the columns */
+    state->row[1] ^= state->row[2];
+    state->row[2] ^= state->row[0];
+    temp = state->row[3] ^ state->row[2];
+    state->row[3] = state->row[2];
+    state->row[2] = state->row[1];
+    state->row[1] = state->row[0];
+    state->row[0] = temp;
+}
+
+/* Performs a single decryption round on the state */
+STATIC_INLINE void skinny64_decrypt_round
+    (Skinny64Cells_t *state, const Skinny64HalfCells_t *schedule)
+{
+    uint32_t temp;
 
-    /* Convert host-endian back into little-endian in the output buffer */
+    /* Inverse mix of the columns */
+    temp = state->row[3];
+    state->row[3] = state->row[0];
+    state->row[0] = state->row[1];
+    state->row[1] = state->row[2];
+    state->row[3] ^= temp;
+    state->row[2] = temp ^ state->row[0];
+    state->row[1] ^= state->row[2];
+
+    /* Inverse shift of the rows */
+    state->row[1] = skinny64_rotate_right(state->row[1], 12);
+    state->row[2] = skinny64_rotate_right(state->row[2], 8);
+    state->row[3] = skinny64_rotate_right(state->row[3], 4);
+
+    /* Apply the subkey for this round */
 #if SKINNY_64BIT && SKINNY_LITTLE_ENDIAN
-    WRITE_WORD64(output, 0, state.llrow);
-#elif SKINNY_LITTLE_ENDIAN
-    WRITE_WORD32(output, 0, state.lrow[0]);
-    WRITE_WORD32(output, 4, state.lrow[1]);
+    state->llrow ^= schedule->lrow | 0x2000000000ULL;
+#else
+    state->lrow[0] ^= schedule->lrow;
+    state->row[2] ^= 0x20;
+#endif
+
+    /* Apply the inverse of the S-box to all bytes in the state */
+#if SKINNY_64BIT
+    state->llrow = skinny64_inv_sbox(state->llrow);
 #else
-    WRITE_WORD16(output, 0, state.row[0]);
-    WRITE_WORD16(output, 2, state.row[1]);
-    WRITE_WORD16(output, 4, state.row[2]);
-    WRITE_WORD16(output, 6, state.row[3]);
+    state->lrow[0] = skinny64_inv_sbox(state->lrow[0]);
+    state->lrow[1] = skinny64_inv_sbox(state->lrow[1]);
 #endif
 }
 
-void skinny64_ecb_decrypt
+void skinny64_ecb_encrypt
     (void *output, const void *input, const Skinny64Key_t *ks)
 {
     Skinny64Cells_t state;
     const Skinny64HalfCells_t *schedule;
     unsigned index;
-    uint32_t temp;
 
-    /* Read the input buffer and convert little-endian to host-endian */
-#if SKINNY_64BIT && SKINNY_LITTLE_ENDIAN
-    state.llrow = READ_WORD64(input, 0);
-#elif SKINNY_LITTLE_ENDIAN
-    state.lrow[0] = READ_WORD32(input, 0);
-    state.lrow[1] = READ_WORD32(input, 4);
-#else
-    state.row[0] = READ_WORD16(input, 0);
-    state.row[1] = READ_WORD16(input, 2);
-    state.row[2] = READ_WORD16(input, 4);
-    state.row[3] = READ_WORD16(input, 6);
-#endif
+    /* Perform all encryption rounds */
+    skinny64_load_state(&state, input, 0);
+    schedule = ks->schedule;
+    for (index = ks->rounds; index > 0; --index, ++schedule)
+        skinny64_encrypt_round(&state, schedule);
+    skinny64_store_state(output, 0, &state);
+}
+
+void skinny64_ecb_decrypt
+    (void *output, const void *input, const Skinny64Key_t *ks)
+{
+    Skinny64Cells_t state;
+    const Skinny64HalfCells_t *schedule;
+    unsigned index;
 
     /* Perform all decryption rounds */
+    skinny64_load_state(&state, input, 0);
     schedule = &(ks->schedule[ks->rounds - 1]);
-    for (index = ks->rounds; index > 0; --index, --schedule) {
-        /* Inverse mix of the columns */
-        temp = state.row[3];
-        state.row[3] = state.row[0];
-        state.row[0] = state.row[1];
-        state.row[1] = state.row[2];
-        state.row[3] ^= temp;
-        state.row[2] = temp ^ state.row[0];
-        state.row[1] ^= state.row[2];
-
-        /* Inverse shift of the rows */
-        state.row[1] = skinny64_rotate_right(state.row[1], 12);
-        state.row[2] = skinny64_rotate_right(state.row[2], 8);
-        state.row[3] = skinny64_rotate_right(state.row[3], 4);
-
-        /* Apply the subkey for this round */
-#if SKINNY_64BIT && SKINNY_LITTLE_ENDIAN
-        state.llrow ^= schedule->lrow | 0x2000000000ULL;
-#else
-        state.lrow[0] ^= schedule->lrow;
-        state.row[2] ^= 0x20;
-#endif
+    for (index = ks->rounds; index > 0; --index, --schedule)
+        skinny64_decrypt_round(&state, schedule);
+    skinny64_store_state(output, 0, &state);
+}
 
-        /* Apply the inverse of the S-box to all bytes in the state */
-#if SKINNY_64BIT
-        state.llrow = skinny64_inv_sbox(state.llrow);
-#else
-        state.lrow[0] = skinny64_inv_sbox(state.lrow[0]);
-        state.lrow[1] = skinny64_inv_sbox(state.lrow[1]);
-#endif
+/* The following encrypt or decrypt two blocks at a time with the rounds
+   for both blocks interleaved, to keep the integer pipelines busy on
+   platforms that don't have SIMD support */
+
+void _skinny64_parallel_encrypt_x2
+    (void *output, const void *input, const Skinny64Key_t *ks)
+{
+    Skinny64Cells_t state1;
+    Skinny64Cells_t state2;
+    const Skinny64HalfCells_t *schedule;
+    unsigned index;
+
+    /* Perform all encryption rounds on the two blocks */
+    skinny64_load_state(&state1, input, 0);
+    skinny64_load_state(&state2, input, SKINNY64_BLOCK_SIZE);
+    schedule = ks->schedule;
+    for (index = ks->rounds; index > 0; --index, ++schedule) {
+        skinny64_encrypt_round(&state1, schedule);
+        skinny64_encrypt_round(&state2, schedule);
     }
+    skinny64_store_state(output, 0, &state1);
+    skinny64_store_state(output, SKINNY64_BLOCK_SIZE, &state2);
+}
 
-    /* Convert host-endian back into little-endian in the output buffer */
-#if SKINNY_64BIT && SKINNY_LITTLE_ENDIAN
-    WRITE_WORD64(output, 0, state.llrow);
-#elif SKINNY_LITTLE_ENDIAN
-    WRITE_WORD32(output, 0, state.lrow[0]);
-    WRITE_WORD32(output, 4, state.lrow[1]);
-#else
-    WRITE_WORD16(output, 0, state.row[0]);
-    WRITE_WORD16(output, 2, state.row[1]);
-    WRITE_WORD16(output, 4, state.row[2]);
-    WRITE_WORD16(output, 6, state.row[3]);
-#endif
+void _skinny64_parallel_decrypt_x2
+    (void *output, const void *input, const Skinny64Key_t *ks)
+{
+    Skinny64Cells_t state1;
+    Skinny64Cells_t state2;
+    const Skinny64HalfCells_t *schedule;
+    unsigned index;
+
+    /* Perform all decryption rounds on the two blocks */
+    skinny64_load_state(&state1, input, 0);
+    skinny64_load_state(&state2, input, SKINNY64_BLOCK_SIZE);
+    schedule = &(ks->schedule[ks->rounds - 1]);
+    for (index = ks->rounds; index > 0; --index, --schedule) {
+        skinny64_decrypt_round(&state1, schedule);
+        skinny64_decrypt_round(&state2, schedule);
+    }
+    skinny64_store_state(output, 0, &state1);
+    skinny64_store_state(output, SKINNY64_BLOCK_SIZE, &state2);
 }
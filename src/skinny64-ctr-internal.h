@@ -42,9 +42,16 @@ typedef struct
         (Skinny64CTR_t *ctr, const void *counter, unsigned size);
     int (*encrypt)
         (void *output, const void *input, size_t size, Skinny64CTR_t *ctr);
+    const char *name;
 
 } Skinny64CTRVtable_t;
 
+/* Encrypts two blocks at a time with interleaved scalar code */
+void _skinny64_parallel_encrypt_x2
+    (void *output, const void *input, const Skinny64Key_t *ks);
+
 extern Skinny64CTRVtable_t const _skinny64_ctr_vec128;
+extern Skinny64CTRVtable_t const _skinny64_ctr_ssse3;
+extern Skinny64CTRVtable_t const _skinny64_ctr_vec256;
 
 #endif /* SKINNY64_CTR_INTERNAL_H */
@@ -36,6 +36,9 @@ typedef struct
     /** Key schedule for Skinny-64, with an optional tweak */
     Skinny64TweakedKey_t kt;
 
+    /** Round keys from kt, pre-broadcast into vectors */
+    SkinnyVector8x16_t schedule[SKINNY64_MAX_ROUNDS][2];
+
     /** Counter values for the next block, pre-formatted into row vectors */
     SkinnyVector8x16_t counter[4];
 
@@ -73,6 +76,22 @@ static void skinny64_ctr_vec128_cleanup(Skinny64CTR_t *ctr)
     }
 }
 
+/* Broadcast the round keys into vectors once when the key or tweak
+   changes, so that the inner loop of the cipher only needs to load them.
+   The round constants are already in rows 0 and 1.  The fixed 0x20 for
+   row 2 is left out: it is rotated and mixed differently from rows 0
+   and 1 so it cannot be merged into their subkeys, and a third vector
+   per round would turn an XOR with a constant into a load and an XOR */
+static void skinny64_ctr_vec128_expand(Skinny64CTRVec128Ctx_t *ctx)
+{
+    const Skinny64HalfCells_t *schedule = ctx->kt.ks.schedule;
+    unsigned index;
+    for (index = 0; index < ctx->kt.ks.rounds; ++index, ++schedule) {
+        ctx->schedule[index][0] = skinny_to_vec8x16(schedule->row[0]);
+        ctx->schedule[index][1] = skinny_to_vec8x16(schedule->row[1]);
+    }
+}
+
 static int skinny64_ctr_vec128_set_key(Skinny64CTR_t *ctr, const void *key, unsigned size)
 {
     Skinny64CTRVec128Ctx_t *ctx;
@@ -87,6 +106,7 @@ static int skinny64_ctr_vec128_set_key(Skinny64CTR_t *ctr, const void *key, unsi
     /* Populate the underlying key schedule */
     if (!skinny64_set_key(&(ctx->kt.ks), key, size))
         return 0;
+    skinny64_ctr_vec128_expand(ctx);
 
     /* Reset the keystream */
     ctx->offset = SKINNY64_CTR_BLOCK_SIZE;
@@ -108,6 +128,7 @@ static int skinny64_ctr_vec128_set_tweaked_key
     /* Populate the underlying key schedule */
     if (!skinny64_set_tweaked_key(&(ctx->kt), key, key_size))
         return 0;
+    skinny64_ctr_vec128_expand(ctx);
 
     /* Reset the keystream */
     ctx->offset = SKINNY64_CTR_BLOCK_SIZE;
@@ -127,6 +148,7 @@ static int skinny64_ctr_vec128_set_tweak
     /* Populate the underlying tweak */
     if (!skinny64_set_tweak(&(ctx->kt), tweak, tweak_size))
         return 0;
+    skinny64_ctr_vec128_expand(ctx);
 
     /* Reset the keystream */
     ctx->offset = SKINNY64_CTR_BLOCK_SIZE;
@@ -174,6 +196,7 @@ static int skinny64_ctr_vec128_set_counter
     } else {
         memset(block, 0, SKINNY64_BLOCK_SIZE);
     }
+    SKINNY_STAT_ADD(ctr_discarded_bytes, SKINNY64_CTR_BLOCK_SIZE - ctx->offset);
     ctx->offset = SKINNY64_CTR_BLOCK_SIZE;
 
     /* Load the counter block and convert into row vectors */
@@ -219,35 +242,64 @@ STATIC_INLINE SkinnyVector8x16_t skinny64_sbox(SkinnyVector8x16_t x)
     return ~x;
 }
 
-static void skinny64_ecb_encrypt_eight
-    (void *output, const SkinnyVector8x16_t *input, const Skinny64Key_t *ks)
+#if SKINNY_VEC128_SSSE3
+
+/* Nibble lookup tables for the S-box, for use with PSHUFB */
+#define SKINNY64_SBOX_LO \
+    _mm_setr_epi8(0x0C, 0x06, 0x09, 0x00, 0x01, 0x0A, 0x02, 0x0B, \
+                  0x03, 0x08, 0x05, 0x0D, 0x04, 0x0E, 0x07, 0x0F)
+#define SKINNY64_SBOX_HI \
+    _mm_setr_epi8(0xC0, 0x60, 0x90, 0x00, 0x10, 0xA0, 0x20, 0xB0, \
+                  0x30, 0x80, 0x50, 0xD0, 0x40, 0xE0, 0x70, 0xF0)
+
+#endif /* SKINNY_VEC128_SSSE3 */
+
+/* Encrypts eight blocks that have already been arranged into row vectors */
+SKINNY_ALWAYS_INLINE void skinny64_encrypt_rows
+    (SkinnyVector8x16_t *rows, const Skinny64CTRVec128Ctx_t *ctx, int ssse3)
 {
     SkinnyVector8x16_t row0;
     SkinnyVector8x16_t row1;
     SkinnyVector8x16_t row2;
     SkinnyVector8x16_t row3;
-    const Skinny64HalfCells_t *schedule;
+    const SkinnyVector8x16_t (*schedule)[2];
     unsigned index;
     SkinnyVector8x16_t temp;
+#if SKINNY_VEC128_SSSE3
+    const __m128i lo = SKINNY64_SBOX_LO;
+    const __m128i hi = SKINNY64_SBOX_HI;
+#else
+    (void)ssse3;
+#endif
 
     /* Read the rows of all eight counter blocks into memory */
-    row0 = input[0];
-    row1 = input[1];
-    row2 = input[2];
-    row3 = input[3];
+    row0 = rows[0];
+    row1 = rows[1];
+    row2 = rows[2];
+    row3 = rows[3];
 
     /* Perform all encryption rounds */
-    schedule = ks->schedule;
-    for (index = ks->rounds; index > 0; --index, ++schedule) {
+    schedule = ctx->schedule;
+    for (index = ctx->kt.ks.rounds; index > 0; --index, ++schedule) {
         /* Apply the S-box to all bytes in the state */
-        row0 = skinny64_sbox(row0);
-        row1 = skinny64_sbox(row1);
-        row2 = skinny64_sbox(row2);
-        row3 = skinny64_sbox(row3);
+#if SKINNY_VEC128_SSSE3
+        if (ssse3) {
+            row0 = skinny_sbox4_vec128(row0, lo, hi);
+            row1 = skinny_sbox4_vec128(row1, lo, hi);
+            row2 = skinny_sbox4_vec128(row2, lo, hi);
+            row3 = skinny_sbox4_vec128(row3, lo, hi);
+        } else
+#endif
+        {
+            row0 = skinny64_sbox(row0);
+            row1 = skinny64_sbox(row1);
+            row2 = skinny64_sbox(row2);
+            row3 = skinny64_sbox(row3);
+        }
 
         /* Apply the subkey for this round */
-        row0 ^= schedule->row[0];
-        row1 ^= schedule->row[1];
+        row0 ^= (*schedule)[0];
+        row1 ^= (*schedule)[1];
         row2 ^= 0x20;
 
         /* Shift the rows */
@@ -265,61 +317,147 @@ static void skinny64_ecb_encrypt_eight
         row0 = temp;
     }
 
+    /* Return the encrypted rows to the caller */
+    rows[0] = row0;
+    rows[1] = row1;
+    rows[2] = row2;
+    rows[3] = row3;
+}
+
+SKINNY_ALWAYS_INLINE void skinny64_ecb_encrypt_eight
+    (void *output, const SkinnyVector8x16_t *input,
+     const Skinny64CTRVec128Ctx_t *ctx, int ssse3)
+{
+    SkinnyVector8x16_t rows[4];
+
+    /* Encrypt the eight counter blocks */
+    rows[0] = input[0];
+    rows[1] = input[1];
+    rows[2] = input[2];
+    rows[3] = input[3];
+    skinny64_encrypt_rows(rows, ctx, ssse3);
+
     /* Write the rows of all eight blocks back to memory.
        Note: In this case, direct WRITE_WORD16() calls seem to give
        better performance than rearranging the vectors and performing
        an unaligned vector write */
 #if 0 /* SKINNY_LITTLE_ENDIAN && SKINNY_UNALIGNED */
     *((SkinnyVector8x16U_t *)output) =
-        (SkinnyVector8x16_t){row0[0], row1[0], row2[0], row3[0],
-                             row0[1], row1[1], row2[1], row3[1]};
+        (SkinnyVector8x16_t){rows[0][0], rows[1][0], rows[2][0], rows[3][0],
+                             rows[0][1], rows[1][1], rows[2][1], rows[3][1]};
     *((SkinnyVector8x16U_t *)(output + 16)) =
-        (SkinnyVector8x16_t){row0[2], row1[2], row2[2], row3[2],
-                             row0[3], row1[3], row2[3], row3[3]};
+        (SkinnyVector8x16_t){rows[0][2], rows[1][2], rows[2][2], rows[3][2],
+                             rows[0][3], rows[1][3], rows[2][3], rows[3][3]};
     *((SkinnyVector8x16U_t *)(output + 32)) =
-        (SkinnyVector8x16_t){row0[4], row1[4], row2[4], row3[4],
-                             row0[5], row1[5], row2[5], row3[5]};
+        (SkinnyVector8x16_t){rows[0][4], rows[1][4], rows[2][4], rows[3][4],
+                             rows[0][5], rows[1][5], rows[2][5], rows[3][5]};
     *((SkinnyVector8x16U_t *)(output + 48)) =
-        (SkinnyVector8x16_t){row0[6], row1[6], row2[6], row3[6],
-                             row0[7], row1[7], row2[7], row3[7]};
+        (SkinnyVector8x16_t){rows[0][6], rows[1][6], rows[2][6], rows[3][6],
+                             rows[0][7], rows[1][7], rows[2][7], rows[3][7]};
 #else
-    WRITE_WORD16(output,  0, row0[0]);
-    WRITE_WORD16(output,  2, row1[0]);
-    WRITE_WORD16(output,  4, row2[0]);
-    WRITE_WORD16(output,  6, row3[0]);
-    WRITE_WORD16(output,  8, row0[1]);
-    WRITE_WORD16(output, 10, row1[1]);
-    WRITE_WORD16(output, 12, row2[1]);
-    WRITE_WORD16(output, 14, row3[1]);
-    WRITE_WORD16(output, 16, row0[2]);
-    WRITE_WORD16(output, 18, row1[2]);
-    WRITE_WORD16(output, 20, row2[2]);
-    WRITE_WORD16(output, 22, row3[2]);
-    WRITE_WORD16(output, 24, row0[3]);
-    WRITE_WORD16(output, 26, row1[3]);
-    WRITE_WORD16(output, 28, row2[3]);
-    WRITE_WORD16(output, 30, row3[3]);
-    WRITE_WORD16(output, 32, row0[4]);
-    WRITE_WORD16(output, 34, row1[4]);
-    WRITE_WORD16(output, 36, row2[4]);
-    WRITE_WORD16(output, 38, row3[4]);
-    WRITE_WORD16(output, 40, row0[5]);
-    WRITE_WORD16(output, 42, row1[5]);
-    WRITE_WORD16(output, 44, row2[5]);
-    WRITE_WORD16(output, 46, row3[5]);
-    WRITE_WORD16(output, 48, row0[6]);
-    WRITE_WORD16(output, 50, row1[6]);
-    WRITE_WORD16(output, 52, row2[6]);
-    WRITE_WORD16(output, 54, row3[6]);
-    WRITE_WORD16(output, 56, row0[7]);
-    WRITE_WORD16(output, 58, row1[7]);
-    WRITE_WORD16(output, 60, row2[7]);
-    WRITE_WORD16(output, 62, row3[7]);
+    WRITE_WORD16(output,  0, rows[0][0]);
+    WRITE_WORD16(output,  2, rows[1][0]);
+    WRITE_WORD16(output,  4, rows[2][0]);
+    WRITE_WORD16(output,  6, rows[3][0]);
+    WRITE_WORD16(output,  8, rows[0][1]);
+    WRITE_WORD16(output, 10, rows[1][1]);
+    WRITE_WORD16(output, 12, rows[2][1]);
+    WRITE_WORD16(output, 14, rows[3][1]);
+    WRITE_WORD16(output, 16, rows[0][2]);
+    WRITE_WORD16(output, 18, rows[1][2]);
+    WRITE_WORD16(output, 20, rows[2][2]);
+    WRITE_WORD16(output, 22, rows[3][2]);
+    WRITE_WORD16(output, 24, rows[0][3]);
+    WRITE_WORD16(output, 26, rows[1][3]);
+    WRITE_WORD16(output, 28, rows[2][3]);
+    WRITE_WORD16(output, 30, rows[3][3]);
+    WRITE_WORD16(output, 32, rows[0][4]);
+    WRITE_WORD16(output, 34, rows[1][4]);
+    WRITE_WORD16(output, 36, rows[2][4]);
+    WRITE_WORD16(output, 38, rows[3][4]);
+    WRITE_WORD16(output, 40, rows[0][5]);
+    WRITE_WORD16(output, 42, rows[1][5]);
+    WRITE_WORD16(output, 44, rows[2][5]);
+    WRITE_WORD16(output, 46, rows[3][5]);
+    WRITE_WORD16(output, 48, rows[0][6]);
+    WRITE_WORD16(output, 50, rows[1][6]);
+    WRITE_WORD16(output, 52, rows[2][6]);
+    WRITE_WORD16(output, 54, rows[3][6]);
+    WRITE_WORD16(output, 56, rows[0][7]);
+    WRITE_WORD16(output, 58, rows[1][7]);
+    WRITE_WORD16(output, 60, rows[2][7]);
+    WRITE_WORD16(output, 62, rows[3][7]);
 #endif
 }
 
-static int skinny64_ctr_vec128_encrypt
-    (void *output, const void *input, size_t size, Skinny64CTR_t *ctr)
+/* Encrypts eight counter blocks and XOR's the keystream directly with
+   eight blocks of input, without a round trip through ctx->ecounter */
+SKINNY_ALWAYS_INLINE void skinny64_ctr_xor_eight
+    (void *output, const void *input, const SkinnyVector8x16_t *counter,
+     const Skinny64CTRVec128Ctx_t *ctx, int ssse3)
+{
+    SkinnyVector8x16_t rows[4];
+#if SKINNY_LITTLE_ENDIAN && SKINNY_UNALIGNED
+    SkinnyVector8x16_t blocks[4];
+#endif
+
+    /* Encrypt the eight counter blocks */
+    rows[0] = counter[0];
+    rows[1] = counter[1];
+    rows[2] = counter[2];
+    rows[3] = counter[3];
+    skinny64_encrypt_rows(rows, ctx, ssse3);
+
+    /* Transpose the keystream back into blocks and XOR with the input */
+#if SKINNY_LITTLE_ENDIAN && SKINNY_UNALIGNED
+    skinny_transpose_8x16(blocks, rows[0], rows[1], rows[2], rows[3]);
+    *((SkinnyVector8x16U_t *)output) =
+        *((const SkinnyVector8x16U_t *)input) ^ blocks[0];
+    *((SkinnyVector8x16U_t *)(output + 16)) =
+        *((const SkinnyVector8x16U_t *)(input + 16)) ^ blocks[1];
+    *((SkinnyVector8x16U_t *)(output + 32)) =
+        *((const SkinnyVector8x16U_t *)(input + 32)) ^ blocks[2];
+    *((SkinnyVector8x16U_t *)(output + 48)) =
+        *((const SkinnyVector8x16U_t *)(input + 48)) ^ blocks[3];
+#else
+    skinny_xor_word16(output, input,  0, rows[0][0]);
+    skinny_xor_word16(output, input,  2, rows[1][0]);
+    skinny_xor_word16(output, input,  4, rows[2][0]);
+    skinny_xor_word16(output, input,  6, rows[3][0]);
+    skinny_xor_word16(output, input,  8, rows[0][1]);
+    skinny_xor_word16(output, input, 10, rows[1][1]);
+    skinny_xor_word16(output, input, 12, rows[2][1]);
+    skinny_xor_word16(output, input, 14, rows[3][1]);
+    skinny_xor_word16(output, input, 16, rows[0][2]);
+    skinny_xor_word16(output, input, 18, rows[1][2]);
+    skinny_xor_word16(output, input, 20, rows[2][2]);
+    skinny_xor_word16(output, input, 22, rows[3][2]);
+    skinny_xor_word16(output, input, 24, rows[0][3]);
+    skinny_xor_word16(output, input, 26, rows[1][3]);
+    skinny_xor_word16(output, input, 28, rows[2][3]);
+    skinny_xor_word16(output, input, 30, rows[3][3]);
+    skinny_xor_word16(output, input, 32, rows[0][4]);
+    skinny_xor_word16(output, input, 34, rows[1][4]);
+    skinny_xor_word16(output, input, 36, rows[2][4]);
+    skinny_xor_word16(output, input, 38, rows[3][4]);
+    skinny_xor_word16(output, input, 40, rows[0][5]);
+    skinny_xor_word16(output, input, 42, rows[1][5]);
+    skinny_xor_word16(output, input, 44, rows[2][5]);
+    skinny_xor_word16(output, input, 46, rows[3][5]);
+    skinny_xor_word16(output, input, 48, rows[0][6]);
+    skinny_xor_word16(output, input, 50, rows[1][6]);
+    skinny_xor_word16(output, input, 52, rows[2][6]);
+    skinny_xor_word16(output, input, 54, rows[3][6]);
+    skinny_xor_word16(output, input, 56, rows[0][7]);
+    skinny_xor_word16(output, input, 58, rows[1][7]);
+    skinny_xor_word16(output, input, 60, rows[2][7]);
+    skinny_xor_word16(output, input, 62, rows[3][7]);
+#endif
+}
+
+SKINNY_ALWAYS_INLINE int skinny64_ctr_vec128_process
+    (void *output, const void *input, size_t size, Skinny64CTR_t *ctr,
+     int ssse3)
 {
     Skinny64CTRVec128Ctx_t *ctx;
     uint8_t *out = (uint8_t *)output;
@@ -336,8 +474,16 @@ static int skinny64_ctr_vec128_encrypt
     while (size > 0) {
         if (ctx->offset >= SKINNY64_CTR_BLOCK_SIZE) {
             /* We need a new keystream block */
-            skinny64_ecb_encrypt_eight
-                (ctx->ecounter, ctx->counter, &(ctx->kt.ks));
+            if (size >= SKINNY64_CTR_BLOCK_SIZE) {
+                /* XOR an entire keystream block in one go, keeping
+                   the keystream in registers rather than ecounter */
+                skinny64_ctr_xor_eight
+                    (out, in, ctx->counter, ctx, ssse3);
+            } else {
+                /* Last partial block in the request */
+                skinny64_ecb_encrypt_eight
+                    (ctx->ecounter, ctx->counter, ctx, ssse3);
+            }
             skinny64_ctr_increment(ctx->counter, 0, 8);
             skinny64_ctr_increment(ctx->counter, 1, 8);
             skinny64_ctr_increment(ctx->counter, 2, 8);
@@ -346,36 +492,11 @@ static int skinny64_ctr_vec128_encrypt
             skinny64_ctr_increment(ctx->counter, 5, 8);
             skinny64_ctr_increment(ctx->counter, 6, 8);
             skinny64_ctr_increment(ctx->counter, 7, 8);
-
-            /* XOR an entire keystream block in one go if possible */
             if (size >= SKINNY64_CTR_BLOCK_SIZE) {
-                skinny64_xor(out, in, ctx->ecounter);
-                skinny64_xor(out + SKINNY64_BLOCK_SIZE,
-                             in + SKINNY64_BLOCK_SIZE,
-                             ctx->ecounter + SKINNY64_BLOCK_SIZE);
-                skinny64_xor(out + SKINNY64_BLOCK_SIZE * 2,
-                             in + SKINNY64_BLOCK_SIZE * 2,
-                             ctx->ecounter + SKINNY64_BLOCK_SIZE * 2);
-                skinny64_xor(out + SKINNY64_BLOCK_SIZE * 3,
-                             in + SKINNY64_BLOCK_SIZE * 3,
-                             ctx->ecounter + SKINNY64_BLOCK_SIZE * 3);
-                skinny64_xor(out + SKINNY64_BLOCK_SIZE * 4,
-                             in + SKINNY64_BLOCK_SIZE * 4,
-                             ctx->ecounter + SKINNY64_BLOCK_SIZE * 4);
-                skinny64_xor(out + SKINNY64_BLOCK_SIZE * 5,
-                             in + SKINNY64_BLOCK_SIZE * 5,
-                             ctx->ecounter + SKINNY64_BLOCK_SIZE * 5);
-                skinny64_xor(out + SKINNY64_BLOCK_SIZE * 6,
-                             in + SKINNY64_BLOCK_SIZE * 6,
-                             ctx->ecounter + SKINNY64_BLOCK_SIZE * 6);
-                skinny64_xor(out + SKINNY64_BLOCK_SIZE * 7,
-                             in + SKINNY64_BLOCK_SIZE * 7,
-                             ctx->ecounter + SKINNY64_BLOCK_SIZE * 7);
                 out += SKINNY64_CTR_BLOCK_SIZE;
                 in += SKINNY64_CTR_BLOCK_SIZE;
                 size -= SKINNY64_CTR_BLOCK_SIZE;
             } else {
-                /* Last partial block in the request */
                 skinny_xor(out, in, ctx->ecounter, size);
                 ctx->offset = size;
                 break;
@@ -395,7 +516,13 @@ static int skinny64_ctr_vec128_encrypt
     return 1;
 }
 
-/** Vtable for the 128-bit SIMD Skinny-128-CTR implementation */
+static int skinny64_ctr_vec128_encrypt
+    (void *output, const void *input, size_t size, Skinny64CTR_t *ctr)
+{
+    return skinny64_ctr_vec128_process(output, input, size, ctr, 0);
+}
+
+/** Vtable for the 128-bit SIMD Skinny-64-CTR implementation */
 Skinny64CTRVtable_t const _skinny64_ctr_vec128 = {
     skinny64_ctr_vec128_init,
     skinny64_ctr_vec128_cleanup,
@@ -403,12 +530,42 @@ Skinny64CTRVtable_t const _skinny64_ctr_vec128 = {
     skinny64_ctr_vec128_set_tweaked_key,
     skinny64_ctr_vec128_set_tweak,
     skinny64_ctr_vec128_set_counter,
-    skinny64_ctr_vec128_encrypt
+    skinny64_ctr_vec128_encrypt,
+    "vec128"
+};
+
+#if SKINNY_VEC128_SSSE3
+
+SKINNY_TARGET_SSSE3 static int skinny64_ctr_ssse3_encrypt
+    (void *output, const void *input, size_t size, Skinny64CTR_t *ctr)
+{
+    return skinny64_ctr_vec128_process(output, input, size, ctr, 1);
+}
+
+/** Vtable for the SSSE3 Skinny-64-CTR implementation */
+Skinny64CTRVtable_t const _skinny64_ctr_ssse3 = {
+    skinny64_ctr_vec128_init,
+    skinny64_ctr_vec128_cleanup,
+    skinny64_ctr_vec128_set_key,
+    skinny64_ctr_vec128_set_tweaked_key,
+    skinny64_ctr_vec128_set_tweak,
+    skinny64_ctr_vec128_set_counter,
+    skinny64_ctr_ssse3_encrypt,
+    "ssse3"
 };
 
+#endif /* SKINNY_VEC128_SSSE3 */
+
 #else /* !SKINNY_VEC128_MATH */
 
 /* Stubbed out */
 Skinny64CTRVtable_t const _skinny64_ctr_vec128;
 
 #endif /* !SKINNY_VEC128_MATH */
+
+#if !SKINNY_VEC128_SSSE3
+
+/* Stubbed out */
+Skinny64CTRVtable_t const _skinny64_ctr_ssse3;
+
+#endif /* !SKINNY_VEC128_SSSE3 */
@@ -0,0 +1,446 @@
+/*
+ * Copyright (C) 2017 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#define SKINNY_TARGET_VEC256 1
+
+#include "skinny64-cipher.h"
+#include "skinny64-ctr-internal.h"
+#include "skinny-internal.h"
+#include <stdlib.h>
+
+#if SKINNY_VEC256_MATH
+
+/* This implementation encrypts sixteen blocks at a time */
+#define SKINNY64_CTR_BLOCK_SIZE (SKINNY64_BLOCK_SIZE * 16)
+
+/** Internal state information for Skinny-64 in CTR mode */
+typedef struct
+{
+    /** Key schedule for Skinny-64, with an optional tweak */
+    Skinny64TweakedKey_t kt;
+
+    /** Round keys from kt, pre-broadcast into vectors */
+    SkinnyVector16x16_t schedule[SKINNY64_MAX_ROUNDS][2];
+
+    /** Counter values for the next block, pre-formatted into row vectors */
+    SkinnyVector16x16_t counter[4];
+
+    /** Encrypted counter value for encrypting the current block */
+    unsigned char ecounter[SKINNY64_CTR_BLOCK_SIZE];
+
+    /** Offset into ecounter where the previous request left off */
+    unsigned offset;
+
+    /** Base pointer for unaligned memory allocation */
+    void *base_ptr;
+
+} Skinny64CTRVec256Ctx_t;
+
+static int skinny64_ctr_vec256_init(Skinny64CTR_t *ctr)
+{
+    Skinny64CTRVec256Ctx_t *ctx;
+    void *base_ptr;
+    if ((ctx = skinny_calloc(sizeof(Skinny64CTRVec256Ctx_t), &base_ptr)) == NULL)
+        return 0;
+    ctx->base_ptr = base_ptr;
+    ctx->offset = SKINNY64_CTR_BLOCK_SIZE;
+    ctr->ctx = ctx;
+    return 1;
+}
+
+static void skinny64_ctr_vec256_cleanup(Skinny64CTR_t *ctr)
+{
+    if (ctr->ctx) {
+        Skinny64CTRVec256Ctx_t *ctx = ctr->ctx;
+        void *base_ptr = ctx->base_ptr;
+        skinny_cleanse(ctx, sizeof(Skinny64CTRVec256Ctx_t));
+        free(base_ptr);
+        ctr->ctx = 0;
+    }
+}
+
+/* Broadcast the round keys into vectors once when the key or tweak
+   changes, so that the inner loop of the cipher only needs to load them.
+   The round constants are already in rows 0 and 1.  The fixed 0x20 for
+   row 2 is left out: it is rotated and mixed differently from rows 0
+   and 1 so it cannot be merged into their subkeys, and a third vector
+   per round would turn an XOR with a constant into a load and an XOR */
+static void skinny64_ctr_vec256_expand(Skinny64CTRVec256Ctx_t *ctx)
+{
+    const Skinny64HalfCells_t *schedule = ctx->kt.ks.schedule;
+    unsigned index;
+    for (index = 0; index < ctx->kt.ks.rounds; ++index, ++schedule) {
+        ctx->schedule[index][0] = skinny_to_vec16x16(schedule->row[0]);
+        ctx->schedule[index][1] = skinny_to_vec16x16(schedule->row[1]);
+    }
+}
+
+static int skinny64_ctr_vec256_set_key(Skinny64CTR_t *ctr, const void *key, unsigned size)
+{
+    Skinny64CTRVec256Ctx_t *ctx;
+
+    /* Validate the parameters */
+    if (!key)
+        return 0;
+    ctx = ctr->ctx;
+    if (!ctx)
+        return 0;
+
+    /* Populate the underlying key schedule */
+    if (!skinny64_set_key(&(ctx->kt.ks), key, size))
+        return 0;
+    skinny64_ctr_vec256_expand(ctx);
+
+    /* Reset the keystream */
+    ctx->offset = SKINNY64_CTR_BLOCK_SIZE;
+    return 1;
+}
+
+static int skinny64_ctr_vec256_set_tweaked_key
+    (Skinny64CTR_t *ctr, const void *key, unsigned key_size)
+{
+    Skinny64CTRVec256Ctx_t *ctx;
+
+    /* Validate the parameters */
+    if (!key)
+        return 0;
+    ctx = ctr->ctx;
+    if (!ctx)
+        return 0;
+
+    /* Populate the underlying key schedule */
+    if (!skinny64_set_tweaked_key(&(ctx->kt), key, key_size))
+        return 0;
+    skinny64_ctr_vec256_expand(ctx);
+
+    /* Reset the keystream */
+    ctx->offset = SKINNY64_CTR_BLOCK_SIZE;
+    return 1;
+}
+
+static int skinny64_ctr_vec256_set_tweak
+    (Skinny64CTR_t *ctr, const void *tweak, unsigned tweak_size)
+{
+    Skinny64CTRVec256Ctx_t *ctx;
+
+    /* Validate the parameters */
+    ctx = ctr->ctx;
+    if (!ctx)
+        return 0;
+
+    /* Populate the underlying tweak */
+    if (!skinny64_set_tweak(&(ctx->kt), tweak, tweak_size))
+        return 0;
+    skinny64_ctr_vec256_expand(ctx);
+
+    /* Reset the keystream */
+    ctx->offset = SKINNY64_CTR_BLOCK_SIZE;
+    return 1;
+}
+
+/* Increment a specific column in an array of row vectors */
+STATIC_INLINE void skinny64_ctr_increment
+    (SkinnyVector16x16_t *counter, unsigned column, unsigned inc)
+{
+    uint8_t *ctr = ((uint8_t *)counter) + column * 2;
+    uint8_t *ptr;
+    unsigned index;
+    for (index = 8; index > 0; ) {
+        --index;
+        ptr = ctr + (index & 0x06) * 16;
+#if SKINNY_LITTLE_ENDIAN
+        ptr += index & 0x01;
+#else
+        ptr += 1 - (index & 0x01);
+#endif
+        inc += ptr[0];
+        ptr[0] = (uint8_t)inc;
+        inc >>= 8;
+    }
+}
+
+/* Increment all sixteen columns of the row vectors at once.  The counter
+   is big-endian, so each 16-bit cell is byte-swapped to make it a number */
+STATIC_INLINE void skinny64_ctr_increment_all
+    (SkinnyVector16x16_t *counter, uint16_t inc)
+{
+    SkinnyVector16x16_t row0 = (counter[0] << 8) | (counter[0] >> 8);
+    SkinnyVector16x16_t row1 = (counter[1] << 8) | (counter[1] >> 8);
+    SkinnyVector16x16_t row2 = (counter[2] << 8) | (counter[2] >> 8);
+    SkinnyVector16x16_t row3 = (counter[3] << 8) | (counter[3] >> 8);
+    SkinnyVector16x16_t carry;
+
+    /* Add to the least significant row and ripple the carries upwards.
+       Comparison results are all-ones masks, so subtracting adds one */
+    row3 += inc;
+    carry = (SkinnyVector16x16_t)(row3 < inc);
+    row2 -= carry;
+    carry &= (SkinnyVector16x16_t)(row2 == 0);
+    row1 -= carry;
+    carry &= (SkinnyVector16x16_t)(row1 == 0);
+    row0 -= carry;
+
+    /* Swap the bytes back into big-endian order */
+    counter[0] = (row0 << 8) | (row0 >> 8);
+    counter[1] = (row1 << 8) | (row1 >> 8);
+    counter[2] = (row2 << 8) | (row2 >> 8);
+    counter[3] = (row3 << 8) | (row3 >> 8);
+}
+
+static int skinny64_ctr_vec256_set_counter
+    (Skinny64CTR_t *ctr, const void *counter, unsigned size)
+{
+    Skinny64CTRVec256Ctx_t *ctx;
+    unsigned char block[SKINNY64_BLOCK_SIZE];
+    unsigned column;
+
+    /* Validate the parameters */
+    if (size > SKINNY64_BLOCK_SIZE)
+        return 0;
+    ctx = ctr->ctx;
+    if (!ctx)
+        return 0;
+
+    /* Set the counter and reset the keystream to a block boundary */
+    if (counter) {
+        memset(block, 0, SKINNY64_BLOCK_SIZE - size);
+        memcpy(block + SKINNY64_BLOCK_SIZE - size, counter, size);
+    } else {
+        memset(block, 0, SKINNY64_BLOCK_SIZE);
+    }
+    SKINNY_STAT_ADD(ctr_discarded_bytes, SKINNY64_CTR_BLOCK_SIZE - ctx->offset);
+    ctx->offset = SKINNY64_CTR_BLOCK_SIZE;
+
+    /* Load the counter block and convert into row vectors */
+    ctx->counter[0] = skinny_to_vec16x16(READ_WORD16(block, 0));
+    ctx->counter[1] = skinny_to_vec16x16(READ_WORD16(block, 2));
+    ctx->counter[2] = skinny_to_vec16x16(READ_WORD16(block, 4));
+    ctx->counter[3] = skinny_to_vec16x16(READ_WORD16(block, 6));
+
+    /* Increment the second through sixteenth columns of each row vector */
+    for (column = 1; column < 16; ++column)
+        skinny64_ctr_increment(ctx->counter, column, column);
+
+    /* Clean up and exit */
+    skinny_cleanse(block, sizeof(block));
+    return 1;
+}
+
+STATIC_INLINE SkinnyVector16x16_t skinny64_rotate_right
+    (SkinnyVector16x16_t x, unsigned count)
+{
+    return (x >> count) | (x << (16 - count));
+}
+
+/* Nibble lookup tables for the S-box, for use with VPSHUFB */
+#define SKINNY64_SBOX_LO \
+    _mm256_setr_epi8(0x0C, 0x06, 0x09, 0x00, 0x01, 0x0A, 0x02, 0x0B, \
+                     0x03, 0x08, 0x05, 0x0D, 0x04, 0x0E, 0x07, 0x0F, \
+                     0x0C, 0x06, 0x09, 0x00, 0x01, 0x0A, 0x02, 0x0B, \
+                     0x03, 0x08, 0x05, 0x0D, 0x04, 0x0E, 0x07, 0x0F)
+#define SKINNY64_SBOX_HI \
+    _mm256_setr_epi8(0xC0, 0x60, 0x90, 0x00, 0x10, 0xA0, 0x20, 0xB0, \
+                     0x30, 0x80, 0x50, 0xD0, 0x40, 0xE0, 0x70, 0xF0, \
+                     0xC0, 0x60, 0x90, 0x00, 0x10, 0xA0, 0x20, 0xB0, \
+                     0x30, 0x80, 0x50, 0xD0, 0x40, 0xE0, 0x70, 0xF0)
+
+/* Encrypts sixteen blocks that have already been arranged into row vectors */
+STATIC_INLINE void skinny64_encrypt_rows
+    (SkinnyVector16x16_t *rows, const Skinny64CTRVec256Ctx_t *ctx)
+{
+    SkinnyVector16x16_t row0;
+    SkinnyVector16x16_t row1;
+    SkinnyVector16x16_t row2;
+    SkinnyVector16x16_t row3;
+    const SkinnyVector16x16_t (*schedule)[2];
+    unsigned index;
+    SkinnyVector16x16_t temp;
+    const __m256i lo = SKINNY64_SBOX_LO;
+    const __m256i hi = SKINNY64_SBOX_HI;
+
+    /* Read the rows of all sixteen counter blocks into memory */
+    row0 = rows[0];
+    row1 = rows[1];
+    row2 = rows[2];
+    row3 = rows[3];
+
+    /* Perform all encryption rounds */
+    schedule = ctx->schedule;
+    for (index = ctx->kt.ks.rounds; index > 0; --index, ++schedule) {
+        /* Apply the S-box to all bytes in the state */
+        row0 = skinny_sbox4_vec256(row0, lo, hi);
+        row1 = skinny_sbox4_vec256(row1, lo, hi);
+        row2 = skinny_sbox4_vec256(row2, lo, hi);
+        row3 = skinny_sbox4_vec256(row3, lo, hi);
+
+        /* Apply the subkey for this round */
+        row0 ^= (*schedule)[0];
+        row1 ^= (*schedule)[1];
+        row2 ^= 0x20;
+
+        /* Shift the rows */
+        row1 = skinny64_rotate_right(row1, 4);
+        row2 = skinny64_rotate_right(row2, 8);
+        row3 = skinny64_rotate_right(row3, 12);
+
+        /* Mix the columns */
+        row1 ^= row2;
+        row2 ^= row0;
+        temp = row3 ^ row2;
+        row3 = row2;
+        row2 = row1;
+        row1 = row0;
+        row0 = temp;
+    }
+
+    /* Return the encrypted rows to the caller */
+    rows[0] = row0;
+    rows[1] = row1;
+    rows[2] = row2;
+    rows[3] = row3;
+}
+
+static void skinny64_ecb_encrypt_sixteen
+    (void *output, const SkinnyVector16x16_t *input,
+     const Skinny64CTRVec256Ctx_t *ctx)
+{
+    SkinnyVector16x16_t rows[4];
+    SkinnyVector16x16_t blocks[4];
+
+    /* Encrypt the sixteen counter blocks */
+    rows[0] = input[0];
+    rows[1] = input[1];
+    rows[2] = input[2];
+    rows[3] = input[3];
+    skinny64_encrypt_rows(rows, ctx);
+
+    /* Write the rows of all sixteen blocks back to memory */
+    skinny_transpose_16x16(blocks, rows[0], rows[1], rows[2], rows[3]);
+    _mm256_storeu_si256((__m256i *)output, (__m256i)blocks[0]);
+    _mm256_storeu_si256(((__m256i *)output) + 1, (__m256i)blocks[1]);
+    _mm256_storeu_si256(((__m256i *)output) + 2, (__m256i)blocks[2]);
+    _mm256_storeu_si256(((__m256i *)output) + 3, (__m256i)blocks[3]);
+}
+
+/* Encrypts sixteen counter blocks and XOR's the keystream directly with
+   sixteen blocks of input, without a round trip through ctx->ecounter */
+static void skinny64_ctr_xor_sixteen
+    (void *output, const void *input, const SkinnyVector16x16_t *counter,
+     const Skinny64CTRVec256Ctx_t *ctx)
+{
+    SkinnyVector16x16_t rows[4];
+    SkinnyVector16x16_t blocks[4];
+    const __m256i *in = (const __m256i *)input;
+    __m256i *out = (__m256i *)output;
+
+    /* Encrypt the sixteen counter blocks */
+    rows[0] = counter[0];
+    rows[1] = counter[1];
+    rows[2] = counter[2];
+    rows[3] = counter[3];
+    skinny64_encrypt_rows(rows, ctx);
+
+    /* Transpose the keystream back into blocks and XOR with the input */
+    skinny_transpose_16x16(blocks, rows[0], rows[1], rows[2], rows[3]);
+    _mm256_storeu_si256(out, _mm256_xor_si256
+        (_mm256_loadu_si256(in), (__m256i)blocks[0]));
+    _mm256_storeu_si256(out + 1, _mm256_xor_si256
+        (_mm256_loadu_si256(in + 1), (__m256i)blocks[1]));
+    _mm256_storeu_si256(out + 2, _mm256_xor_si256
+        (_mm256_loadu_si256(in + 2), (__m256i)blocks[2]));
+    _mm256_storeu_si256(out + 3, _mm256_xor_si256
+        (_mm256_loadu_si256(in + 3), (__m256i)blocks[3]));
+}
+
+static int skinny64_ctr_vec256_encrypt
+    (void *output, const void *input, size_t size, Skinny64CTR_t *ctr)
+{
+    Skinny64CTRVec256Ctx_t *ctx;
+    uint8_t *out = (uint8_t *)output;
+    const uint8_t *in = (const uint8_t *)input;
+
+    /* Validate the parameters */
+    if (!output || !input)
+        return 0;
+    ctx = ctr->ctx;
+    if (!ctx)
+        return 0;
+
+    /* Encrypt the input in CTR mode to create the output */
+    while (size > 0) {
+        if (ctx->offset >= SKINNY64_CTR_BLOCK_SIZE) {
+            /* We need a new keystream block */
+            if (size >= SKINNY64_CTR_BLOCK_SIZE) {
+                /* XOR an entire keystream block in one go, keeping
+                   the keystream in registers rather than ecounter */
+                skinny64_ctr_xor_sixteen
+                    (out, in, ctx->counter, ctx);
+            } else {
+                /* Last partial block in the request */
+                skinny64_ecb_encrypt_sixteen
+                    (ctx->ecounter, ctx->counter, ctx);
+            }
+            skinny64_ctr_increment_all(ctx->counter, 16);
+            if (size >= SKINNY64_CTR_BLOCK_SIZE) {
+                out += SKINNY64_CTR_BLOCK_SIZE;
+                in += SKINNY64_CTR_BLOCK_SIZE;
+                size -= SKINNY64_CTR_BLOCK_SIZE;
+            } else {
+                skinny_xor(out, in, ctx->ecounter, size);
+                ctx->offset = size;
+                break;
+            }
+        } else {
+            /* Left-over keystream data from the last request */
+            size_t temp = SKINNY64_CTR_BLOCK_SIZE - ctx->offset;
+            if (temp > size)
+                temp = size;
+            skinny_xor(out, in, ctx->ecounter + ctx->offset, temp);
+            ctx->offset += temp;
+            out += temp;
+            in += temp;
+            size -= temp;
+        }
+    }
+    return 1;
+}
+
+/** Vtable for the 256-bit SIMD Skinny-64-CTR implementation */
+Skinny64CTRVtable_t const _skinny64_ctr_vec256 = {
+    skinny64_ctr_vec256_init,
+    skinny64_ctr_vec256_cleanup,
+    skinny64_ctr_vec256_set_key,
+    skinny64_ctr_vec256_set_tweaked_key,
+    skinny64_ctr_vec256_set_tweak,
+    skinny64_ctr_vec256_set_counter,
+    skinny64_ctr_vec256_encrypt,
+    "vec256"
+};
+
+#else /* !SKINNY_VEC256_MATH */
+
+/* Stubbed out */
+Skinny64CTRVtable_t const _skinny64_ctr_vec256;
+
+#endif /* !SKINNY_VEC256_MATH */
+
+SKINNY_TARGET_END
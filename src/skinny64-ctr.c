@@ -25,17 +25,20 @@
 #include "skinny-internal.h"
 #include <stdlib.h>
 
+/* The default back end generates two blocks of keystream at a time */
+#define SKINNY64_CTR_BLOCK_SIZE (SKINNY64_BLOCK_SIZE * 2)
+
 /** Internal state information for Skinny-64 in CTR mode */
 typedef struct
 {
     /** Key schedule for Skinny-64, with an optional tweak */
     Skinny64TweakedKey_t kt;
 
-    /** Counter value for the next block */
-    unsigned char counter[SKINNY64_BLOCK_SIZE];
+    /** Counter values for the next two blocks */
+    unsigned char counter[SKINNY64_CTR_BLOCK_SIZE];
 
-    /** Encrypted counter value for encrypting the current block */
-    unsigned char ecounter[SKINNY64_BLOCK_SIZE];
+    /** Encrypted counter values for encrypting the current blocks */
+    unsigned char ecounter[SKINNY64_CTR_BLOCK_SIZE];
 
     /** Offset into ecounter where the previous request left off */
     unsigned offset;
@@ -47,7 +50,7 @@ static int skinny64_ctr_def_init(Skinny64CTR_t *ctr)
     Skinny64CTRCtx_t *ctx;
     if ((ctx = calloc(1, sizeof(Skinny64CTRCtx_t))) == NULL)
         return 0;
-    ctx->offset = SKINNY64_BLOCK_SIZE;
+    ctx->offset = SKINNY64_CTR_BLOCK_SIZE;
     ctr->ctx = ctx;
     return 1;
 }
@@ -78,7 +81,7 @@ static int skinny64_ctr_def_set_key
         return 0;
 
     /* Reset the keystream */
-    ctx->offset = SKINNY64_BLOCK_SIZE;
+    ctx->offset = SKINNY64_CTR_BLOCK_SIZE;
     return 1;
 }
 
@@ -99,7 +102,7 @@ static int skinny64_ctr_def_set_tweaked_key
         return 0;
 
     /* Reset the keystream */
-    ctx->offset = SKINNY64_BLOCK_SIZE;
+    ctx->offset = SKINNY64_CTR_BLOCK_SIZE;
     return 1;
 }
 
@@ -118,7 +121,7 @@ static int skinny64_ctr_def_set_tweak
         return 0;
 
     /* Reset the keystream */
-    ctx->offset = SKINNY64_BLOCK_SIZE;
+    ctx->offset = SKINNY64_CTR_BLOCK_SIZE;
     return 1;
 }
 
@@ -141,7 +144,11 @@ static int skinny64_ctr_def_set_counter
     } else {
         memset(ctx->counter, 0, SKINNY64_BLOCK_SIZE);
     }
-    ctx->offset = SKINNY64_BLOCK_SIZE;
+    memcpy(ctx->counter + SKINNY64_BLOCK_SIZE, ctx->counter,
+           SKINNY64_BLOCK_SIZE);
+    skinny64_inc_counter(ctx->counter + SKINNY64_BLOCK_SIZE, 1);
+    SKINNY_STAT_ADD(ctr_discarded_bytes, SKINNY64_CTR_BLOCK_SIZE - ctx->offset);
+    ctx->offset = SKINNY64_CTR_BLOCK_SIZE;
     return 1;
 }
 
@@ -161,17 +168,22 @@ static int skinny64_ctr_def_encrypt
 
     /* Encrypt the input in CTR mode to create the output */
     while (size > 0) {
-        if (ctx->offset >= SKINNY64_BLOCK_SIZE) {
-            /* We need a new keystream block */
-            skinny64_ecb_encrypt(ctx->ecounter, ctx->counter, &(ctx->kt.ks));
-            skinny64_inc_counter(ctx->counter, 1);
+        if (ctx->offset >= SKINNY64_CTR_BLOCK_SIZE) {
+            /* We need two new keystream blocks */
+            _skinny64_parallel_encrypt_x2
+                (ctx->ecounter, ctx->counter, &(ctx->kt.ks));
+            skinny64_inc_counter(ctx->counter, 2);
+            skinny64_inc_counter(ctx->counter + SKINNY64_BLOCK_SIZE, 2);
 
             /* XOR an entire keystream block in one go if possible */
-            if (size >= SKINNY64_BLOCK_SIZE) {
+            if (size >= SKINNY64_CTR_BLOCK_SIZE) {
                 skinny64_xor(out, in, ctx->ecounter);
-                out += SKINNY64_BLOCK_SIZE;
-                in += SKINNY64_BLOCK_SIZE;
-                size -= SKINNY64_BLOCK_SIZE;
+                skinny64_xor(out + SKINNY64_BLOCK_SIZE,
+                           in + SKINNY64_BLOCK_SIZE,
+                           ctx->ecounter + SKINNY64_BLOCK_SIZE);
+                out += SKINNY64_CTR_BLOCK_SIZE;
+                in += SKINNY64_CTR_BLOCK_SIZE;
+                size -= SKINNY64_CTR_BLOCK_SIZE;
             } else {
                 /* Last partial block in the request */
                 skinny_xor(out, in, ctx->ecounter, size);
@@ -180,7 +192,7 @@ static int skinny64_ctr_def_encrypt
             }
         } else {
             /* Left-over keystream data from the last request */
-            size_t temp = SKINNY64_BLOCK_SIZE - ctx->offset;
+            size_t temp = SKINNY64_CTR_BLOCK_SIZE - ctx->offset;
             if (temp > size)
                 temp = size;
             skinny_xor(out, in, ctx->ecounter + ctx->offset, temp);
@@ -201,13 +213,33 @@ static Skinny64CTRVtable_t const skinny64_ctr_def = {
     skinny64_ctr_def_set_tweaked_key,
     skinny64_ctr_def_set_tweak,
     skinny64_ctr_def_set_counter,
-    skinny64_ctr_def_encrypt
+    skinny64_ctr_def_encrypt,
+    "default"
 };
 
+/* Lists the back ends that are usable on this platform, in increasing
+   order of preference */
+static unsigned skinny64_ctr_backends(const Skinny64CTRVtable_t **list)
+{
+    unsigned count = 0;
+    list[count++] = &skinny64_ctr_def;
+    if (_skinny_has_vec128())
+        list[count++] = &_skinny64_ctr_vec128;
+    if (_skinny_has_vec128_ssse3())
+        list[count++] = &_skinny64_ctr_ssse3;
+    if (_skinny_has_vec256())
+        list[count++] = &_skinny64_ctr_vec256;
+    return count;
+}
+
+/* Back end that was chosen by the autotuner, or NULL if not tuned */
+static const Skinny64CTRVtable_t *skinny64_ctr_tuned = 0;
+
 /* Public API, which redirects to the specific backend implementation */
 
 int skinny64_ctr_init(Skinny64CTR_t *ctr)
 {
+    const Skinny64CTRVtable_t *list[SKINNY_AUTOTUNE_MAX_BACKENDS];
     const Skinny64CTRVtable_t *vtable;
 
     /* Validate the parameter */
@@ -215,24 +247,38 @@ int skinny64_ctr_init(Skinny64CTR_t *ctr)
         return 0;
 
     /* Choose a backend implementation */
-    vtable = &skinny64_ctr_def;
-    if (_skinny_has_vec128())
-        vtable = &_skinny64_ctr_vec128;
+    vtable = skinny64_ctr_tuned;
+    if (!vtable)
+        vtable = list[skinny64_ctr_backends(list) - 1];
     ctr->vtable = vtable;
 
     /* Initialize the CTR mode context */
-    return (*(vtable->init))(ctr);
+    if (!(*(vtable->init))(ctr))
+        return 0;
+    SKINNY_STAT_ADD(context_allocs, 1);
+    SKINNY_PROBE2(skinny64_ctr_init, ctr, vtable->name);
+    return 1;
 }
 
 void skinny64_ctr_cleanup(Skinny64CTR_t *ctr)
 {
     if (ctr && ctr->vtable) {
         const Skinny64CTRVtable_t *vtable = ctr->vtable;
+        SKINNY_PROBE1(skinny64_ctr_cleanup, ctr);
         (*(vtable->cleanup))(ctr);
         ctr->vtable = 0;
     }
 }
 
+const char *skinny64_ctr_backend_name(const Skinny64CTR_t *ctr)
+{
+    if (ctr && ctr->vtable) {
+        const Skinny64CTRVtable_t *vtable = ctr->vtable;
+        return vtable->name;
+    }
+    return 0;
+}
+
 int skinny64_ctr_set_key(Skinny64CTR_t *ctr, const void *key, unsigned size)
 {
     if (ctr && ctr->vtable) {
@@ -277,7 +323,79 @@ int skinny64_ctr_encrypt
 {
     if (ctr && ctr->vtable) {
         const Skinny64CTRVtable_t *vtable = ctr->vtable;
-        return (*(vtable->encrypt))(output, input, size, ctr);
+        int result;
+        SKINNY_PROBE3(skinny64_ctr_encrypt_start, ctr, size, vtable->name);
+        result = (*(vtable->encrypt))(output, input, size, ctr);
+        SKINNY_PROBE2(skinny64_ctr_encrypt_done, ctr, size);
+        return result;
     }
     return 0;
 }
+
+/** @cond */
+
+/**
+ * \brief State for timing a CTR back end with the autotuner.
+ */
+typedef struct
+{
+    Skinny64CTR_t ctr;
+    unsigned char data[SKINNY_AUTOTUNE_SIZE];
+
+} Skinny64CTRTune_t;
+
+/** @endcond */
+
+static void skinny64_ctr_time(void *arg)
+{
+    Skinny64CTRTune_t *tune = arg;
+    const Skinny64CTRVtable_t *vtable = tune->ctr.vtable;
+    (*(vtable->encrypt))(tune->data, tune->data, SKINNY_AUTOTUNE_SIZE,
+                         &(tune->ctr));
+}
+
+const char *_skinny64_ctr_autotune(const char *name)
+{
+    const Skinny64CTRVtable_t *list[SKINNY_AUTOTUNE_MAX_BACKENDS];
+    const Skinny64CTRVtable_t *vtable;
+    Skinny64CTRTune_t *tune;
+    uint64_t time, best_time = ~((uint64_t)0);
+    unsigned count, index, best;
+
+    /* Select a specific back end by name */
+    count = skinny64_ctr_backends(list);
+    if (name) {
+        for (index = 0; index < count; ++index) {
+            if (!strcmp(list[index]->name, name)) {
+                skinny64_ctr_tuned = list[index];
+                return list[index]->name;
+            }
+        }
+        return 0;
+    }
+
+    /* Time each back end, starting with the default choice.  Another
+       back end must be strictly faster to replace the default */
+    best = count - 1;
+    if ((tune = calloc(1, sizeof(Skinny64CTRTune_t))) != NULL) {
+        for (index = count; index > 0; ) {
+            --index;
+            vtable = list[index];
+            tune->ctr.vtable = vtable;
+            if (!(*(vtable->init))(&(tune->ctr)))
+                continue;
+            if ((*(vtable->set_key))
+                    (&(tune->ctr), tune->data, SKINNY64_BLOCK_SIZE)) {
+                time = _skinny_autotune_measure(skinny64_ctr_time, tune);
+                if (time < best_time) {
+                    best = index;
+                    best_time = time;
+                }
+            }
+            (*(vtable->cleanup))(&(tune->ctr));
+        }
+        free(tune);
+    }
+    skinny64_ctr_tuned = list[best];
+    return list[best]->name;
+}
@@ -65,8 +65,26 @@ STATIC_INLINE SkinnyVector8x16_t skinny64_inv_sbox(SkinnyVector8x16_t x)
     return ~x;
 }
 
-void _skinny64_parallel_encrypt_vec128
-    (void *output, const void *input, const Skinny64Key_t *ks)
+#if SKINNY_VEC128_SSSE3
+
+/* Nibble lookup tables for the S-box and its inverse, for use with PSHUFB */
+#define SKINNY64_SBOX_LO \
+    _mm_setr_epi8(0x0C, 0x06, 0x09, 0x00, 0x01, 0x0A, 0x02, 0x0B, \
+                  0x03, 0x08, 0x05, 0x0D, 0x04, 0x0E, 0x07, 0x0F)
+#define SKINNY64_SBOX_HI \
+    _mm_setr_epi8(0xC0, 0x60, 0x90, 0x00, 0x10, 0xA0, 0x20, 0xB0, \
+                  0x30, 0x80, 0x50, 0xD0, 0x40, 0xE0, 0x70, 0xF0)
+#define SKINNY64_INV_SBOX_LO \
+    _mm_setr_epi8(0x03, 0x04, 0x06, 0x08, 0x0C, 0x0A, 0x01, 0x0E, \
+                  0x09, 0x02, 0x05, 0x07, 0x00, 0x0B, 0x0D, 0x0F)
+#define SKINNY64_INV_SBOX_HI \
+    _mm_setr_epi8(0x30, 0x40, 0x60, 0x80, 0xC0, 0xA0, 0x10, 0xE0, \
+                  0x90, 0x20, 0x50, 0x70, 0x00, 0xB0, 0xD0, 0xF0)
+
+#endif /* SKINNY_VEC128_SSSE3 */
+
+SKINNY_ALWAYS_INLINE void skinny64_parallel_encrypt
+    (void *output, const void *input, const Skinny64Key_t *ks, int ssse3)
 {
     SkinnyVector8x16_t row0;
     SkinnyVector8x16_t row1;
@@ -75,6 +93,12 @@ void _skinny64_parallel_encrypt_vec128
     const Skinny64HalfCells_t *schedule;
     unsigned index;
     SkinnyVector8x16_t temp;
+#if SKINNY_VEC128_SSSE3
+    const __m128i lo = SKINNY64_SBOX_LO;
+    const __m128i hi = SKINNY64_SBOX_HI;
+#else
+    (void)ssse3;
+#endif
 
     /* Read the rows of all eight blocks into memory */
     row0 = (SkinnyVector8x16_t)
@@ -102,10 +126,20 @@ void _skinny64_parallel_encrypt_vec128
     schedule = ks->schedule;
     for (index = ks->rounds; index > 0; --index, ++schedule) {
         /* Apply the S-box to all bytes in the state */
-        row0 = skinny64_sbox(row0);
-        row1 = skinny64_sbox(row1);
-        row2 = skinny64_sbox(row2);
-        row3 = skinny64_sbox(row3);
+#if SKINNY_VEC128_SSSE3
+        if (ssse3) {
+            row0 = skinny_sbox4_vec128(row0, lo, hi);
+            row1 = skinny_sbox4_vec128(row1, lo, hi);
+            row2 = skinny_sbox4_vec128(row2, lo, hi);
+            row3 = skinny_sbox4_vec128(row3, lo, hi);
+        } else
+#endif
+        {
+            row0 = skinny64_sbox(row0);
+            row1 = skinny64_sbox(row1);
+            row2 = skinny64_sbox(row2);
+            row3 = skinny64_sbox(row3);
+        }
 
         /* Apply the subkey for this round */
         row0 ^= schedule->row[0];
@@ -162,8 +196,8 @@ void _skinny64_parallel_encrypt_vec128
     WRITE_WORD16(output, 62, row3[7]);
 }
 
-void _skinny64_parallel_decrypt_vec128
-    (void *output, const void *input, const Skinny64Key_t *ks)
+SKINNY_ALWAYS_INLINE void skinny64_parallel_decrypt
+    (void *output, const void *input, const Skinny64Key_t *ks, int ssse3)
 {
     SkinnyVector8x16_t row0;
     SkinnyVector8x16_t row1;
@@ -172,6 +206,12 @@ void _skinny64_parallel_decrypt_vec128
     const Skinny64HalfCells_t *schedule;
     unsigned index;
     SkinnyVector8x16_t temp;
+#if SKINNY_VEC128_SSSE3
+    const __m128i lo = SKINNY64_INV_SBOX_LO;
+    const __m128i hi = SKINNY64_INV_SBOX_HI;
+#else
+    (void)ssse3;
+#endif
 
     /* Read the rows of all eight blocks into memory */
     row0 = (SkinnyVector8x16_t)
@@ -218,10 +258,20 @@ void _skinny64_parallel_decrypt_vec128
         row2 ^= 0x20;
 
         /* Apply the inverse S-box to all bytes in the state */
-        row0 = skinny64_inv_sbox(row0);
-        row1 = skinny64_inv_sbox(row1);
-        row2 = skinny64_inv_sbox(row2);
-        row3 = skinny64_inv_sbox(row3);
+#if SKINNY_VEC128_SSSE3
+        if (ssse3) {
+            row0 = skinny_sbox4_vec128(row0, lo, hi);
+            row1 = skinny_sbox4_vec128(row1, lo, hi);
+            row2 = skinny_sbox4_vec128(row2, lo, hi);
+            row3 = skinny_sbox4_vec128(row3, lo, hi);
+        } else
+#endif
+        {
+            row0 = skinny64_inv_sbox(row0);
+            row1 = skinny64_inv_sbox(row1);
+            row2 = skinny64_inv_sbox(row2);
+            row3 = skinny64_inv_sbox(row3);
+        }
     }
 
     /* Write the rows of all eight blocks back to memory */
@@ -259,6 +309,34 @@ void _skinny64_parallel_decrypt_vec128
     WRITE_WORD16(output, 62, row3[7]);
 }
 
+void _skinny64_parallel_encrypt_vec128
+    (void *output, const void *input, const Skinny64Key_t *ks)
+{
+    skinny64_parallel_encrypt(output, input, ks, 0);
+}
+
+void _skinny64_parallel_decrypt_vec128
+    (void *output, const void *input, const Skinny64Key_t *ks)
+{
+    skinny64_parallel_decrypt(output, input, ks, 0);
+}
+
+#if SKINNY_VEC128_SSSE3
+
+SKINNY_TARGET_SSSE3 void _skinny64_parallel_encrypt_ssse3
+    (void *output, const void *input, const Skinny64Key_t *ks)
+{
+    skinny64_parallel_encrypt(output, input, ks, 1);
+}
+
+SKINNY_TARGET_SSSE3 void _skinny64_parallel_decrypt_ssse3
+    (void *output, const void *input, const Skinny64Key_t *ks)
+{
+    skinny64_parallel_decrypt(output, input, ks, 1);
+}
+
+#endif /* SKINNY_VEC128_SSSE3 */
+
 #else /* !SKINNY_VEC128_MATH */
 
 /* Stubbed out */
@@ -280,3 +358,25 @@ void _skinny64_parallel_decrypt_vec128
 }
 
 #endif /* !SKINNY_VEC128_MATH */
+
+#if !SKINNY_VEC128_SSSE3
+
+/* Stubbed out */
+
+void _skinny64_parallel_encrypt_ssse3
+    (void *output, const void *input, const Skinny64Key_t *ks)
+{
+    (void)output;
+    (void)input;
+    (void)ks;
+}
+
+void _skinny64_parallel_decrypt_ssse3
+    (void *output, const void *input, const Skinny64Key_t *ks)
+{
+    (void)output;
+    (void)input;
+    (void)ks;
+}
+
+#endif /* !SKINNY_VEC128_SSSE3 */
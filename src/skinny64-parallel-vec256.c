@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2017 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#define SKINNY_TARGET_VEC256 1
+
+#include "skinny64-parallel.h"
+#include "skinny-internal.h"
+
+#if SKINNY_VEC256_MATH
+
+STATIC_INLINE SkinnyVector16x16_t skinny64_rotate_right
+    (SkinnyVector16x16_t x, unsigned count)
+{
+    return (x >> count) | (x << (16 - count));
+}
+
+/* Nibble lookup tables for the S-box and its inverse, for use with VPSHUFB */
+#define SKINNY64_SBOX_LO \
+    _mm256_setr_epi8(0x0C, 0x06, 0x09, 0x00, 0x01, 0x0A, 0x02, 0x0B, \
+                     0x03, 0x08, 0x05, 0x0D, 0x04, 0x0E, 0x07, 0x0F, \
+                     0x0C, 0x06, 0x09, 0x00, 0x01, 0x0A, 0x02, 0x0B, \
+                     0x03, 0x08, 0x05, 0x0D, 0x04, 0x0E, 0x07, 0x0F)
+#define SKINNY64_SBOX_HI \
+    _mm256_setr_epi8(0xC0, 0x60, 0x90, 0x00, 0x10, 0xA0, 0x20, 0xB0, \
+                     0x30, 0x80, 0x50, 0xD0, 0x40, 0xE0, 0x70, 0xF0, \
+                     0xC0, 0x60, 0x90, 0x00, 0x10, 0xA0, 0x20, 0xB0, \
+                     0x30, 0x80, 0x50, 0xD0, 0x40, 0xE0, 0x70, 0xF0)
+#define SKINNY64_INV_SBOX_LO \
+    _mm256_setr_epi8(0x03, 0x04, 0x06, 0x08, 0x0C, 0x0A, 0x01, 0x0E, \
+                     0x09, 0x02, 0x05, 0x07, 0x00, 0x0B, 0x0D, 0x0F, \
+                     0x03, 0x04, 0x06, 0x08, 0x0C, 0x0A, 0x01, 0x0E, \
+                     0x09, 0x02, 0x05, 0x07, 0x00, 0x0B, 0x0D, 0x0F)
+#define SKINNY64_INV_SBOX_HI \
+    _mm256_setr_epi8(0x30, 0x40, 0x60, 0x80, 0xC0, 0xA0, 0x10, 0xE0, \
+                     0x90, 0x20, 0x50, 0x70, 0x00, 0xB0, 0xD0, 0xF0, \
+                     0x30, 0x40, 0x60, 0x80, 0xC0, 0xA0, 0x10, 0xE0, \
+                     0x90, 0x20, 0x50, 0x70, 0x00, 0xB0, 0xD0, 0xF0)
+
+void _skinny64_parallel_encrypt_vec256
+    (void *output, const void *input, const Skinny64Key_t *ks)
+{
+    SkinnyVector16x16_t row0;
+    SkinnyVector16x16_t row1;
+    SkinnyVector16x16_t row2;
+    SkinnyVector16x16_t row3;
+    const Skinny64HalfCells_t *schedule;
+    unsigned index;
+    SkinnyVector16x16_t temp;
+    SkinnyVector16x16_t rows[4];
+    const __m256i lo = SKINNY64_SBOX_LO;
+    const __m256i hi = SKINNY64_SBOX_HI;
+
+    /* Read the rows of all sixteen blocks into memory */
+    skinny_load_rows_16x16(rows, input);
+    row0 = rows[0];
+    row1 = rows[1];
+    row2 = rows[2];
+    row3 = rows[3];
+
+    /* Perform all encryption rounds */
+    schedule = ks->schedule;
+    for (index = ks->rounds; index > 0; --index, ++schedule) {
+        /* Apply the S-box to all bytes in the state */
+        row0 = skinny_sbox4_vec256(row0, lo, hi);
+        row1 = skinny_sbox4_vec256(row1, lo, hi);
+        row2 = skinny_sbox4_vec256(row2, lo, hi);
+        row3 = skinny_sbox4_vec256(row3, lo, hi);
+
+        /* Apply the subkey for this round */
+        row0 ^= schedule->row[0];
+        row1 ^= schedule->row[1];
+        row2 ^= 0x20;
+
+        /* Shift the rows */
+        row1 = skinny64_rotate_right(row1, 4);
+        row2 = skinny64_rotate_right(row2, 8);
+        row3 = skinny64_rotate_right(row3, 12);
+
+        /* Mix the columns */
+        row1 ^= row2;
+        row2 ^= row0;
+        temp = row3 ^ row2;
+        row3 = row2;
+        row2 = row1;
+        row1 = row0;
+        row0 = temp;
+    }
+
+    /* Write the rows of all sixteen blocks back to memory */
+    skinny_transpose_16x16(rows, row0, row1, row2, row3);
+    _mm256_storeu_si256((__m256i *)output, (__m256i)rows[0]);
+    _mm256_storeu_si256(((__m256i *)output) + 1, (__m256i)rows[1]);
+    _mm256_storeu_si256(((__m256i *)output) + 2, (__m256i)rows[2]);
+    _mm256_storeu_si256(((__m256i *)output) + 3, (__m256i)rows[3]);
+}
+
+void _skinny64_parallel_decrypt_vec256
+    (void *output, const void *input, const Skinny64Key_t *ks)
+{
+    SkinnyVector16x16_t row0;
+    SkinnyVector16x16_t row1;
+    SkinnyVector16x16_t row2;
+    SkinnyVector16x16_t row3;
+    const Skinny64HalfCells_t *schedule;
+    unsigned index;
+    SkinnyVector16x16_t temp;
+    SkinnyVector16x16_t rows[4];
+    const __m256i lo = SKINNY64_INV_SBOX_LO;
+    const __m256i hi = SKINNY64_INV_SBOX_HI;
+
+    /* Read the rows of all sixteen blocks into memory */
+    skinny_load_rows_16x16(rows, input);
+    row0 = rows[0];
+    row1 = rows[1];
+    row2 = rows[2];
+    row3 = rows[3];
+
+    /* Perform all decryption rounds */
+    schedule = &(ks->schedule[ks->rounds - 1]);
+    for (index = ks->rounds; index > 0; --index, --schedule) {
+        /* Inverse mix of the columns */
+        temp = row3;
+        row3 = row0;
+        row0 = row1;
+        row1 = row2;
+        row3 ^= temp;
+        row2 = temp ^ row0;
+        row1 ^= row2;
+
+        /* Inverse shift of the rows */
+        row1 = skinny64_rotate_right(row1, 12);
+        row2 = skinny64_rotate_right(row2, 8);
+        row3 = skinny64_rotate_right(row3, 4);
+
+        /* Apply the subkey for this round */
+        row0 ^= schedule->row[0];
+        row1 ^= schedule->row[1];
+        row2 ^= 0x20;
+
+        /* Apply the inverse S-box to all bytes in the state */
+        row0 = skinny_sbox4_vec256(row0, lo, hi);
+        row1 = skinny_sbox4_vec256(row1, lo, hi);
+        row2 = skinny_sbox4_vec256(row2, lo, hi);
+        row3 = skinny_sbox4_vec256(row3, lo, hi);
+    }
+
+    /* Write the rows of all sixteen blocks back to memory */
+    skinny_transpose_16x16(rows, row0, row1, row2, row3);
+    _mm256_storeu_si256((__m256i *)output, (__m256i)rows[0]);
+    _mm256_storeu_si256(((__m256i *)output) + 1, (__m256i)rows[1]);
+    _mm256_storeu_si256(((__m256i *)output) + 2, (__m256i)rows[2]);
+    _mm256_storeu_si256(((__m256i *)output) + 3, (__m256i)rows[3]);
+}
+
+#else /* !SKINNY_VEC256_MATH */
+
+/* Stubbed out */
+
+void _skinny64_parallel_encrypt_vec256
+    (void *output, const void *input, const Skinny64Key_t *ks)
+{
+    (void)output;
+    (void)input;
+    (void)ks;
+}
+
+void _skinny64_parallel_decrypt_vec256
+    (void *output, const void *input, const Skinny64Key_t *ks)
+{
+    (void)output;
+    (void)input;
+    (void)ks;
+}
+
+#endif /* !SKINNY_VEC256_MATH */
+
+SKINNY_TARGET_END
@@ -34,9 +34,23 @@ typedef struct
 {
     void (*encrypt)(void *output, const void *input, const Skinny64Key_t *ks);
     void (*decrypt)(void *output, const void *input, const Skinny64Key_t *ks);
+    size_t parallel_size;
+    const char *name;
 
 } Skinny64ParallelECBVtable_t;
 
+void _skinny64_parallel_encrypt_x2
+    (void *output, const void *input, const Skinny64Key_t *ks);
+void _skinny64_parallel_decrypt_x2
+    (void *output, const void *input, const Skinny64Key_t *ks);
+
+static Skinny64ParallelECBVtable_t const skinny64_parallel_ecb_x2 = {
+    _skinny64_parallel_encrypt_x2,
+    _skinny64_parallel_decrypt_x2,
+    2 * SKINNY64_BLOCK_SIZE,
+    "x2"
+};
+
 void _skinny64_parallel_encrypt_vec128
     (void *output, const void *input, const Skinny64Key_t *ks);
 void _skinny64_parallel_decrypt_vec128
@@ -44,33 +58,105 @@ void _skinny64_parallel_decrypt_vec128
 
 static Skinny64ParallelECBVtable_t const skinny64_parallel_ecb_vec128 = {
     _skinny64_parallel_encrypt_vec128,
-    _skinny64_parallel_decrypt_vec128
+    _skinny64_parallel_decrypt_vec128,
+    8 * SKINNY64_BLOCK_SIZE,
+    "vec128"
+};
+
+void _skinny64_parallel_encrypt_ssse3
+    (void *output, const void *input, const Skinny64Key_t *ks);
+void _skinny64_parallel_decrypt_ssse3
+    (void *output, const void *input, const Skinny64Key_t *ks);
+
+static Skinny64ParallelECBVtable_t const skinny64_parallel_ecb_ssse3 = {
+    _skinny64_parallel_encrypt_ssse3,
+    _skinny64_parallel_decrypt_ssse3,
+    8 * SKINNY64_BLOCK_SIZE,
+    "ssse3"
+};
+
+void _skinny64_parallel_encrypt_vec256
+    (void *output, const void *input, const Skinny64Key_t *ks);
+void _skinny64_parallel_decrypt_vec256
+    (void *output, const void *input, const Skinny64Key_t *ks);
+
+static Skinny64ParallelECBVtable_t const skinny64_parallel_ecb_vec256 = {
+    _skinny64_parallel_encrypt_vec256,
+    _skinny64_parallel_decrypt_vec256,
+    16 * SKINNY64_BLOCK_SIZE,
+    "vec256"
 };
 
 /** @endcond */
 
+/* Lists the parallel back ends that are usable on this platform, in
+   increasing order of preference.  Without SIMD support, we fall back
+   to interleaving two blocks in scalar registers */
+static unsigned skinny64_parallel_ecb_backends
+    (const Skinny64ParallelECBVtable_t **list)
+{
+    unsigned count = 0;
+    list[count++] = &skinny64_parallel_ecb_x2;
+    if (_skinny_has_vec128())
+        list[count++] = &skinny64_parallel_ecb_vec128;
+    if (_skinny_has_vec128_ssse3())
+        list[count++] = &skinny64_parallel_ecb_ssse3;
+    if (_skinny_has_vec256())
+        list[count++] = &skinny64_parallel_ecb_vec256;
+    return count;
+}
+
+/* Back end that was chosen by the autotuner, or NULL if not tuned */
+static const Skinny64ParallelECBVtable_t *skinny64_parallel_ecb_tuned = 0;
+
+/* Chooses the best parallel back end for this platform */
+static const Skinny64ParallelECBVtable_t *skinny64_parallel_ecb_select
+    (size_t *parallel_size)
+{
+    const Skinny64ParallelECBVtable_t *list[SKINNY_AUTOTUNE_MAX_BACKENDS];
+    const Skinny64ParallelECBVtable_t *vtable;
+    vtable = skinny64_parallel_ecb_tuned;
+    if (!vtable)
+        vtable = list[skinny64_parallel_ecb_backends(list) - 1];
+    *parallel_size = vtable->parallel_size;
+    return vtable;
+}
+
 int skinny64_parallel_ecb_init(Skinny64ParallelECB_t *ecb)
 {
     Skinny64Key_t *ctx;
+    const Skinny64ParallelECBVtable_t *vtable;
     if ((ctx = calloc(1, sizeof(Skinny64Key_t))) == NULL)
         return 0;
-    ecb->vtable = 0;
     ecb->ctx = ctx;
-    ecb->parallel_size = 8 * SKINNY64_BLOCK_SIZE;
-    if (_skinny_has_vec128())
-        ecb->vtable = &skinny64_parallel_ecb_vec128;
+    SKINNY_STAT_ADD(context_allocs, 1);
+    vtable = skinny64_parallel_ecb_select(&(ecb->parallel_size));
+    ecb->vtable = vtable;
+    SKINNY_PROBE3(skinny64_parallel_ecb_init, ecb,
+                  vtable->name, ecb->parallel_size);
     return 1;
 }
 
 void skinny64_parallel_ecb_cleanup(Skinny64ParallelECB_t *ecb)
 {
     if (ecb && ecb->ctx) {
+        SKINNY_PROBE1(skinny64_parallel_ecb_cleanup, ecb);
         skinny_cleanse(ecb->ctx, sizeof(Skinny64Key_t));
         free(ecb->ctx);
         ecb->ctx = 0;
     }
 }
 
+const char *skinny64_parallel_ecb_backend_name
+    (const Skinny64ParallelECB_t *ecb)
+{
+    const Skinny64ParallelECBVtable_t *vtable;
+    if (!ecb || !ecb->ctx)
+        return 0;
+    vtable = ecb->vtable;
+    return vtable->name;
+}
+
 int skinny64_parallel_ecb_set_key
     (Skinny64ParallelECB_t *ecb, const void *key, unsigned size)
 {
@@ -87,17 +173,21 @@ int skinny64_parallel_ecb_encrypt
 {
     const Skinny64Key_t *ks;
     const Skinny64ParallelECBVtable_t *vtable;
+    size_t total;
 
     /* Validate the parameters */
     if (!ecb || !ecb->ctx || (size % SKINNY64_BLOCK_SIZE) != 0)
         return 0;
     ks = ecb->ctx;
+    total = size;
+    SKINNY_PROBE2(skinny64_parallel_ecb_encrypt_start, ecb, size);
 
     /* Process major blocks with the vectorized back end */
     vtable = ecb->vtable;
     if (vtable) {
         size_t psize = ecb->parallel_size;
         while (size >= psize) {
+            SKINNY_STAT_ADD(parallel_blocks, psize / SKINNY64_BLOCK_SIZE);
             (*(vtable->encrypt))(output, input, ks);
             output += psize;
             input += psize;
@@ -106,12 +196,14 @@ int skinny64_parallel_ecb_encrypt
     }
 
     /* Process any left-over blocks with the non-parallel implementation */
+    SKINNY_STAT_ADD(tail_blocks, size / SKINNY64_BLOCK_SIZE);
     while (size >= SKINNY64_BLOCK_SIZE) {
         skinny64_ecb_encrypt(output, input, ks);
         output += SKINNY64_BLOCK_SIZE;
         input += SKINNY64_BLOCK_SIZE;
         size -= SKINNY64_BLOCK_SIZE;
     }
+    SKINNY_PROBE2(skinny64_parallel_ecb_encrypt_done, ecb, total);
     return 1;
 }
 
@@ -121,17 +213,21 @@ int skinny64_parallel_ecb_decrypt
 {
     const Skinny64Key_t *ks;
     const Skinny64ParallelECBVtable_t *vtable;
+    size_t total;
 
     /* Validate the parameters */
     if (!ecb || !ecb->ctx || (size % SKINNY64_BLOCK_SIZE) != 0)
         return 0;
     ks = ecb->ctx;
+    total = size;
+    SKINNY_PROBE2(skinny64_parallel_ecb_decrypt_start, ecb, size);
 
     /* Process major blocks with the vectorized back end */
     vtable = ecb->vtable;
     if (vtable) {
         size_t psize = ecb->parallel_size;
         while (size >= psize) {
+            SKINNY_STAT_ADD(parallel_blocks, psize / SKINNY64_BLOCK_SIZE);
             (*(vtable->decrypt))(output, input, ks);
             output += psize;
             input += psize;
@@ -140,11 +236,199 @@ int skinny64_parallel_ecb_decrypt
     }
 
     /* Process any left-over blocks with the non-parallel implementation */
+    SKINNY_STAT_ADD(tail_blocks, size / SKINNY64_BLOCK_SIZE);
     while (size >= SKINNY64_BLOCK_SIZE) {
         skinny64_ecb_decrypt(output, input, ks);
         output += SKINNY64_BLOCK_SIZE;
         input += SKINNY64_BLOCK_SIZE;
         size -= SKINNY64_BLOCK_SIZE;
     }
+    SKINNY_PROBE2(skinny64_parallel_ecb_decrypt_done, ecb, total);
     return 1;
 }
+
+void skinny64_ecb_encrypt_blocks
+    (void *output, const void *input, size_t count, const Skinny64Key_t *ks)
+{
+    const Skinny64ParallelECBVtable_t *vtable;
+    size_t psize;
+
+    /* Process major blocks with the best vectorized back end */
+    vtable = skinny64_parallel_ecb_select(&psize);
+    SKINNY_PROBE3(skinny64_ecb_encrypt_blocks_start, ks, count,
+                  vtable->name);
+    if (vtable) {
+        size_t pcount = psize / SKINNY64_BLOCK_SIZE;
+        while (count >= pcount) {
+            SKINNY_STAT_ADD(parallel_blocks, pcount);
+            (*(vtable->encrypt))(output, input, ks);
+            output += psize;
+            input += psize;
+            count -= pcount;
+        }
+    }
+
+    /* Process any left-over blocks with the non-parallel implementation */
+    SKINNY_STAT_ADD(tail_blocks, count);
+    while (count > 0) {
+        skinny64_ecb_encrypt(output, input, ks);
+        output += SKINNY64_BLOCK_SIZE;
+        input += SKINNY64_BLOCK_SIZE;
+        --count;
+    }
+    SKINNY_PROBE1(skinny64_ecb_encrypt_blocks_done, ks);
+}
+
+void skinny64_ecb_decrypt_blocks
+    (void *output, const void *input, size_t count, const Skinny64Key_t *ks)
+{
+    const Skinny64ParallelECBVtable_t *vtable;
+    size_t psize;
+
+    /* Process major blocks with the best vectorized back end */
+    vtable = skinny64_parallel_ecb_select(&psize);
+    SKINNY_PROBE3(skinny64_ecb_decrypt_blocks_start, ks, count,
+                  vtable->name);
+    if (vtable) {
+        size_t pcount = psize / SKINNY64_BLOCK_SIZE;
+        while (count >= pcount) {
+            SKINNY_STAT_ADD(parallel_blocks, pcount);
+            (*(vtable->decrypt))(output, input, ks);
+            output += psize;
+            input += psize;
+            count -= pcount;
+        }
+    }
+
+    /* Process any left-over blocks with the non-parallel implementation */
+    SKINNY_STAT_ADD(tail_blocks, count);
+    while (count > 0) {
+        skinny64_ecb_decrypt(output, input, ks);
+        output += SKINNY64_BLOCK_SIZE;
+        input += SKINNY64_BLOCK_SIZE;
+        --count;
+    }
+    SKINNY_PROBE1(skinny64_ecb_decrypt_blocks_done, ks);
+}
+
+/** @cond */
+
+/**
+ * \brief State for timing a parallel back end with the autotuner.
+ */
+typedef struct
+{
+    const Skinny64ParallelECBVtable_t *vtable;
+    Skinny64Key_t ks;
+    unsigned char data[SKINNY_AUTOTUNE_SIZE];
+
+} Skinny64ParallelECBTune_t;
+
+/** @endcond */
+
+static void skinny64_parallel_ecb_time(void *arg)
+{
+    Skinny64ParallelECBTune_t *tune = arg;
+    const Skinny64ParallelECBVtable_t *vtable = tune->vtable;
+    size_t posn;
+    for (posn = 0; posn < SKINNY_AUTOTUNE_SIZE;
+            posn += vtable->parallel_size) {
+        (*(vtable->encrypt))(tune->data + posn, tune->data + posn,
+                             &(tune->ks));
+    }
+}
+
+const char *_skinny64_parallel_ecb_autotune(const char *name)
+{
+    const Skinny64ParallelECBVtable_t *list[SKINNY_AUTOTUNE_MAX_BACKENDS];
+    Skinny64ParallelECBTune_t *tune;
+    uint64_t time, best_time = ~((uint64_t)0);
+    unsigned count, index, best;
+
+    /* Select a specific back end by name */
+    count = skinny64_parallel_ecb_backends(list);
+    if (name) {
+        for (index = 0; index < count; ++index) {
+            if (!strcmp(list[index]->name, name)) {
+                skinny64_parallel_ecb_tuned = list[index];
+                return list[index]->name;
+            }
+        }
+        return 0;
+    }
+
+    /* Time each back end, starting with the default choice.  Another
+       back end must be strictly faster to replace the default */
+    best = count - 1;
+    if ((tune = calloc(1, sizeof(Skinny64ParallelECBTune_t))) != NULL) {
+        skinny64_set_key(&(tune->ks), tune->data, SKINNY64_BLOCK_SIZE);
+        for (index = count; index > 0; ) {
+            --index;
+            tune->vtable = list[index];
+            time = _skinny_autotune_measure
+                (skinny64_parallel_ecb_time, tune);
+            if (time < best_time) {
+                best = index;
+                best_time = time;
+            }
+        }
+        skinny_cleanse(tune, sizeof(Skinny64ParallelECBTune_t));
+        free(tune);
+    }
+    skinny64_parallel_ecb_tuned = list[best];
+    return list[best]->name;
+}
+
+#if !SKINNY_LITTLE_ENDIAN
+
+/* Number of IDs to convert to little-endian at a time */
+#define SKINNY64_IDS_CHUNK 64
+
+/* Encrypts or decrypts IDs on big-endian platforms, converting to and
+   from little-endian in the output array around the block function */
+static void skinny64_ecb_crypt_ids
+    (uint64_t *output, const uint64_t *input, size_t count,
+     const Skinny64Key_t *ks,
+     void (*crypt)(void *output, const void *input, size_t count,
+                   const Skinny64Key_t *ks))
+{
+    size_t len, index;
+    while (count > 0) {
+        len = count < SKINNY64_IDS_CHUNK ? count : SKINNY64_IDS_CHUNK;
+        for (index = 0; index < len; ++index)
+            output[index] = skinny_le64(input[index]);
+        (*crypt)(output, output, len, ks);
+        for (index = 0; index < len; ++index)
+            output[index] = skinny_le64(output[index]);
+        output += len;
+        input += len;
+        count -= len;
+    }
+}
+
+#endif /* !SKINNY_LITTLE_ENDIAN */
+
+void skinny64_ecb_encrypt_ids
+    (uint64_t *output, const uint64_t *input, size_t count,
+     const Skinny64Key_t *ks)
+{
+#if SKINNY_LITTLE_ENDIAN
+    /* The IDs are already in the block format in memory */
+    skinny64_ecb_encrypt_blocks(output, input, count, ks);
+#else
+    skinny64_ecb_crypt_ids
+        (output, input, count, ks, skinny64_ecb_encrypt_blocks);
+#endif
+}
+
+void skinny64_ecb_decrypt_ids
+    (uint64_t *output, const uint64_t *input, size_t count,
+     const Skinny64Key_t *ks)
+{
+#if SKINNY_LITTLE_ENDIAN
+    skinny64_ecb_decrypt_blocks(output, input, count, ks);
+#else
+    skinny64_ecb_crypt_ids
+        (output, input, count, ks, skinny64_ecb_decrypt_blocks);
+#endif
+}
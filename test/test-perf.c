@@ -26,6 +26,8 @@
 #include "skinny64-parallel.h"
 #include "mantis-cipher.h"
 #include "mantis-parallel.h"
+#include "skinny-stats.h"
+#include "skinny-autotune.h"
 #include <stdio.h>
 #include <string.h>
 #include <time.h>
@@ -35,6 +37,16 @@
 #define HAVE_TIMER 1
 #endif
 
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#if defined(__NR_perf_event_open)
+#define HAVE_PERF_EVENTS 1
+#endif
+#endif
+
 static unsigned iters_per_sec = 1;
 static unsigned multiplier = 1;
 
@@ -69,6 +81,155 @@ timestamp_t get_timestamp(void)
 }
 #endif
 
+/* Hardware performance counters that "test-perf --counters" collects */
+#define COUNTER_CYCLES          0
+#define COUNTER_INSTRUCTIONS    1
+#define COUNTER_L1D_MISSES      2
+#define COUNTER_BRANCH_MISSES   3
+#define NUM_COUNTERS            4
+
+/* Counter values for one measurement, or -1 if a counter is unavailable */
+typedef struct
+{
+    const char *mode;
+    const char *backend;
+    double bytes;
+    double blocks;
+    double values[NUM_COUNTERS];
+
+} counter_results_t;
+
+static int counters_enabled = 0;
+static counter_results_t counter_results[8];
+static unsigned num_counter_results = 0;
+
+#if defined(HAVE_PERF_EVENTS)
+
+static int counter_fds[NUM_COUNTERS] = {-1, -1, -1, -1};
+
+static int counter_open(uint32_t type, uint64_t config)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+/* Opens the counters, returning zero if none of them are available */
+static int counters_init(void)
+{
+    counter_fds[COUNTER_CYCLES] =
+        counter_open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    counter_fds[COUNTER_INSTRUCTIONS] =
+        counter_open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    counter_fds[COUNTER_L1D_MISSES] =
+        counter_open(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+                     (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                     (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    counter_fds[COUNTER_BRANCH_MISSES] =
+        counter_open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    return counter_fds[COUNTER_CYCLES] >= 0 ||
+           counter_fds[COUNTER_INSTRUCTIONS] >= 0 ||
+           counter_fds[COUNTER_L1D_MISSES] >= 0 ||
+           counter_fds[COUNTER_BRANCH_MISSES] >= 0;
+}
+
+static void counters_start(void)
+{
+    int index;
+    for (index = 0; index < NUM_COUNTERS; ++index) {
+        if (counter_fds[index] >= 0) {
+            ioctl(counter_fds[index], PERF_EVENT_IOC_RESET, 0);
+            ioctl(counter_fds[index], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+}
+
+static void counters_stop(double *values)
+{
+    uint64_t value;
+    int index;
+    for (index = 0; index < NUM_COUNTERS; ++index) {
+        values[index] = -1;
+        if (counter_fds[index] >= 0) {
+            ioctl(counter_fds[index], PERF_EVENT_IOC_DISABLE, 0);
+            if (read(counter_fds[index], &value, sizeof(value)) ==
+                    sizeof(value))
+                values[index] = (double)value;
+        }
+    }
+}
+
+#else /* !HAVE_PERF_EVENTS */
+
+static int counters_init(void)
+{
+    return 0;
+}
+
+static void counters_start(void)
+{
+}
+
+static void counters_stop(double *values)
+{
+    int index;
+    for (index = 0; index < NUM_COUNTERS; ++index)
+        values[index] = -1;
+}
+
+#endif /* !HAVE_PERF_EVENTS */
+
+/* Records the counters for a measurement, to be printed by report() */
+static void counters_record
+    (const char *mode, const char *backend, double bytes, unsigned blksize)
+{
+    counter_results_t *results;
+    if (!counters_enabled)
+        return;
+    results = &(counter_results[num_counter_results++]);
+    counters_stop(results->values);
+    results->mode = mode;
+    results->backend = backend ? backend : "-";
+    results->bytes = bytes;
+    results->blocks = bytes / blksize;
+}
+
+/* Prints a counter value divided by a quantity, or "-" if unavailable */
+static void counters_print(double value, double divisor)
+{
+    if (value >= 0 && divisor > 0)
+        printf(" %12.3f", value / divisor);
+    else
+        printf(" %12s", "-");
+}
+
+/* Prints and clears the counters that were recorded for an algorithm */
+static void counters_report(void)
+{
+    counter_results_t *results;
+    unsigned index;
+    for (index = 0; index < num_counter_results; ++index) {
+        results = &(counter_results[index]);
+        printf("    %-6s %-10s", results->mode, results->backend);
+        counters_print(results->values[COUNTER_CYCLES], results->bytes);
+        counters_print(results->values[COUNTER_CYCLES], results->blocks);
+        counters_print(results->values[COUNTER_INSTRUCTIONS], results->bytes);
+        counters_print(results->values[COUNTER_INSTRUCTIONS],
+                       results->values[COUNTER_CYCLES]);
+        counters_print(results->values[COUNTER_L1D_MISSES], results->blocks);
+        counters_print(results->values[COUNTER_BRANCH_MISSES],
+                       results->blocks);
+        printf("\n");
+    }
+    num_counter_results = 0;
+}
+
 /* Calibrate the performance framework by figuring out roughly
    how many iterations to run per second for each algorithm.
    We use Skinny-64-192 in ECB mode to calibrate as it is mid-range
@@ -109,8 +270,10 @@ void calibrate(void)
         (result) = 1000000000.0 * total / (end - start); \
     } while (0)
 
-/* Run an operation over and over and determine the number of MB/sec */
-#define RUN_MB(result, op, size, blksize) \
+/* Run an operation over and over and determine the number of MB/sec.
+   The name of the back end that runs the operation is reported with
+   the hardware performance counters */
+#define RUN_MB(result, op, size, blksize, backend) \
     do { \
         timestamp_t start, end; \
         unsigned total = iters_per_sec * multiplier; \
@@ -119,12 +282,15 @@ void calibrate(void)
             total /= (size) / (blksize); \
         count = total; \
         total *= (size); \
+        if (counters_enabled) \
+            counters_start(); \
         start = get_timestamp(); \
         while (count > 0) { \
             (op); \
             --count; \
         } \
         end = get_timestamp(); \
+        counters_record(#result, (backend), total, (blksize)); \
         (result) = 1000000000.0 * total / ((end - start) * 1024.0 * 1024.0); \
     } while (0)
 
@@ -146,6 +312,7 @@ void report(const char *name, double set_key,
         printf("%-38s %12.3f %12.3f\n",
                new_name, penc, pdec);
     }
+    counters_report();
 }
 
 void skinny64_perf(const char *name, unsigned key_size)
@@ -158,20 +325,23 @@ void skinny64_perf(const char *name, unsigned key_size)
     Skinny64ParallelECB_t e;
 
     RUN_OP(set_key, skinny64_set_key(&ks, key_data, key_size));
-    RUN_MB(enc, skinny64_ecb_encrypt(block, block, &ks), 8, 8);
-    RUN_MB(dec, skinny64_ecb_decrypt(block, block, &ks), 8, 8);
+    RUN_MB(enc, skinny64_ecb_encrypt(block, block, &ks), 8, 8, "scalar");
+    RUN_MB(dec, skinny64_ecb_decrypt(block, block, &ks), 8, 8, "scalar");
 
     skinny64_ctr_init(&c);
     skinny64_ctr_set_key(&c, key_data, key_size);
     memset(buffer, 0xBA, sizeof(buffer));
-    RUN_MB(ctr, skinny64_ctr_encrypt(buffer, buffer, 1024, &c), 1024, 8);
+    RUN_MB(ctr, skinny64_ctr_encrypt(buffer, buffer, 1024, &c), 1024, 8,
+           skinny64_ctr_backend_name(&c));
     skinny64_ctr_cleanup(&c);
 
     skinny64_parallel_ecb_init(&e);
     skinny64_parallel_ecb_set_key(&e, key_data, key_size);
     memset(buffer, 0xBA, sizeof(buffer));
-    RUN_MB(penc, skinny64_parallel_ecb_encrypt(buffer, buffer, 1024, &e), 1024, 8);
-    RUN_MB(pdec, skinny64_parallel_ecb_decrypt(buffer, buffer, 1024, &e), 1024, 8);
+    RUN_MB(penc, skinny64_parallel_ecb_encrypt(buffer, buffer, 1024, &e), 1024, 8,
+           skinny64_parallel_ecb_backend_name(&e));
+    RUN_MB(pdec, skinny64_parallel_ecb_decrypt(buffer, buffer, 1024, &e), 1024, 8,
+           skinny64_parallel_ecb_backend_name(&e));
     skinny64_parallel_ecb_cleanup(&e);
 
     report(name, set_key, enc, dec, ctr, penc, pdec);
@@ -188,20 +358,23 @@ void skinny128_perf(const char *name, unsigned key_size)
     Skinny128ParallelECB_t e;
 
     RUN_OP(set_key, skinny128_set_key(&ks, key_data, key_size));
-    RUN_MB(enc, skinny128_ecb_encrypt(block, block, &ks), 16, 16);
-    RUN_MB(dec, skinny128_ecb_decrypt(block, block, &ks), 16, 16);
+    RUN_MB(enc, skinny128_ecb_encrypt(block, block, &ks), 16, 16, "scalar");
+    RUN_MB(dec, skinny128_ecb_decrypt(block, block, &ks), 16, 16, "scalar");
 
     skinny128_ctr_init(&c);
     skinny128_ctr_set_key(&c, key_data, key_size);
     memset(buffer, 0xBA, sizeof(buffer));
-    RUN_MB(ctr, skinny128_ctr_encrypt(buffer, buffer, 1024, &c), 1024, 16);
+    RUN_MB(ctr, skinny128_ctr_encrypt(buffer, buffer, 1024, &c), 1024, 16,
+           skinny128_ctr_backend_name(&c));
     skinny128_ctr_cleanup(&c);
 
     skinny128_parallel_ecb_init(&e);
     skinny128_parallel_ecb_set_key(&e, key_data, key_size);
     memset(buffer, 0xBA, sizeof(buffer));
-    RUN_MB(penc, skinny128_parallel_ecb_encrypt(buffer, buffer, 1024, &e), 1024, 8);
-    RUN_MB(pdec, skinny128_parallel_ecb_decrypt(buffer, buffer, 1024, &e), 1024, 8);
+    RUN_MB(penc, skinny128_parallel_ecb_encrypt(buffer, buffer, 1024, &e), 1024, 16,
+           skinny128_parallel_ecb_backend_name(&e));
+    RUN_MB(pdec, skinny128_parallel_ecb_decrypt(buffer, buffer, 1024, &e), 1024, 16,
+           skinny128_parallel_ecb_backend_name(&e));
     skinny128_parallel_ecb_cleanup(&e);
 
     report(name, set_key, enc, dec, ctr, penc, pdec);
@@ -219,14 +392,15 @@ void mantis_perf(const char *name, unsigned rounds)
     unsigned index;
 
     mantis_set_key(&ks, key_data, 16, rounds, MANTIS_ENCRYPT);
-    RUN_MB(enc, mantis_ecb_crypt(block, block, &ks), 8, 8);
+    RUN_MB(enc, mantis_ecb_crypt(block, block, &ks), 8, 8, "scalar");
     mantis_swap_modes(&ks);
-    RUN_MB(dec, mantis_ecb_crypt(block, block, &ks), 8, 8);
+    RUN_MB(dec, mantis_ecb_crypt(block, block, &ks), 8, 8, "scalar");
 
     mantis_ctr_init(&c);
     mantis_ctr_set_key(&c, key_data, 16, rounds);
     memset(buffer, 0xBA, sizeof(buffer));
-    RUN_MB(ctr, mantis_ctr_encrypt(buffer, buffer, 1024, &c), 1024, 8);
+    RUN_MB(ctr, mantis_ctr_encrypt(buffer, buffer, 1024, &c), 1024, 8,
+           mantis_ctr_backend_name(&c));
     mantis_ctr_cleanup(&c);
 
     mantis_parallel_ecb_init(&e);
@@ -236,22 +410,63 @@ void mantis_perf(const char *name, unsigned rounds)
     for (index = 0; index < sizeof(tweak); ++index)
         tweak[index] = (uint8_t)(index % 251);
     RUN_MB(penc, mantis_parallel_ecb_crypt
-                    (buffer, buffer, tweak, 1024, &e), 1024, 8);
+                    (buffer, buffer, tweak, 1024, &e), 1024, 8,
+           mantis_parallel_ecb_backend_name(&e));
     mantis_parallel_ecb_swap_modes(&e);
     RUN_MB(pdec, mantis_parallel_ecb_crypt
-                    (buffer, buffer, tweak, 1024, &e), 1024, 8);
+                    (buffer, buffer, tweak, 1024, &e), 1024, 8,
+           mantis_parallel_ecb_backend_name(&e));
     mantis_parallel_ecb_cleanup(&e);
 
     report(name, -1, enc, dec, ctr, penc, pdec);
 }
 
+/* Report the slow-path statistics if the library is collecting them */
+void report_stats(void)
+{
+    SkinnyStats_t stats;
+    if (!skinny_stats_snapshot(&stats))
+        return;
+    printf("\n");
+    printf("%-38s %12llu\n", "Parallel blocks", stats.parallel_blocks);
+    printf("%-38s %12llu\n", "Tail blocks", stats.tail_blocks);
+    printf("%-38s %12llu\n", "CTR keystream bytes discarded",
+           stats.ctr_discarded_bytes);
+    printf("%-38s %12llu\n", "Tweak rewrites", stats.tweak_rewrites);
+    printf("%-38s %12llu\n", "Context allocations", stats.context_allocs);
+}
+
 int main(int argc, char *argv[])
 {
 #if defined(HAVE_TIMER)
+    int index;
+
+    /* "--autotune [cache-file]" measures the tuned back ends and
+       "--counters" collects hardware performance counters */
+    for (index = 1; index < argc; ++index) {
+        if (!strcmp(argv[index], "--autotune")) {
+            const char *cache_file = 0;
+            if ((index + 1) < argc && argv[index + 1][0] != '-')
+                cache_file = argv[++index];
+            if (!skinny_autotune(cache_file))
+                fprintf(stderr, "Could not write the autotune cache file\n");
+        } else if (!strcmp(argv[index], "--counters")) {
+            counters_enabled = counters_init();
+            if (!counters_enabled)
+                fprintf(stderr, "Hardware performance counters are not available\n");
+        }
+    }
+
     calibrate();
 
     printf("\n");
     printf("                       Set Key (ops/s)  ENC (MiB/s)  DEC (MiB/s)  CTR (MiB/s)\n");
+    if (counters_enabled) {
+        printf("    %-6s %-10s %12s %12s %12s %12s %12s %12s\n",
+               "Mode", "Back end",
+               "cycles/B", "cycles/blk", "instrs/B", "IPC",
+               "L1D-miss/blk", "br-miss/blk");
+    }
 
     skinny64_perf("Skinny-64-64", 8);
     skinny64_perf("Skinny-64-128", 16);
@@ -265,6 +480,8 @@ int main(int argc, char *argv[])
     mantis_perf("Mantis6", 6);
     mantis_perf("Mantis7", 7);
     mantis_perf("Mantis8", 8);
+
+    report_stats();
 #else
     fprintf(stderr, "Do not know how to measure time - performance tests skipped\n");
 #endif
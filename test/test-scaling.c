@@ -0,0 +1,235 @@
+/*
+ * Copyright (C) 2017 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* Measures how the CTR and parallel ECB modes scale with the number of
+   threads and the size of the working set, next to a memcpy() baseline.
+   Each thread has its own context and buffers.  Usage:
+
+       test-scaling [max-threads]
+
+   The default for max-threads is the number of online CPUs. */
+
+#include "skinny128-cipher.h"
+#include "skinny128-parallel.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(_POSIX_THREADS) && _POSIX_THREADS > 0 && \
+        defined(CLOCK_MONOTONIC)
+#include <pthread.h>
+#define HAVE_THREADS 1
+#endif
+
+#if defined(HAVE_THREADS)
+
+typedef int64_t timestamp_t;
+
+/* Length of each measurement, in nanoseconds */
+#define RUN_TIME 250000000LL
+
+/* Working set sizes per thread, from L1-sized to DRAM-sized */
+static size_t const working_sets[] = {
+    16 * 1024, 256 * 1024, 4 * 1024 * 1024, 64 * 1024 * 1024
+};
+#define NUM_WORKING_SETS (sizeof(working_sets) / sizeof(working_sets[0]))
+
+/* Common key data */
+static uint8_t const key_data[32] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+    0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+    0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F
+};
+
+/* Operations to measure */
+#define OP_MEMCPY   0
+#define OP_CTR      1
+#define OP_ECB      2
+#define NUM_OPS     3
+
+typedef struct
+{
+    pthread_t thread;
+    int op;
+    size_t size;
+    uint8_t *src;
+    uint8_t *dst;
+    double bytes_per_sec;
+
+} ThreadState;
+
+static timestamp_t get_timestamp(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* Runs the operation over the thread's buffers for RUN_TIME nanoseconds.
+   Each thread times itself so that no locking is needed */
+static void *run_thread(void *arg)
+{
+    ThreadState *state = (ThreadState *)arg;
+    Skinny128CTR_t ctr;
+    Skinny128ParallelECB_t ecb;
+    timestamp_t start, elapsed;
+    double bytes = 0;
+
+    skinny128_ctr_init(&ctr);
+    skinny128_ctr_set_key(&ctr, key_data, sizeof(key_data));
+    skinny128_parallel_ecb_init(&ecb);
+    skinny128_parallel_ecb_set_key(&ecb, key_data, sizeof(key_data));
+
+    start = get_timestamp();
+    do {
+        switch (state->op) {
+        case OP_MEMCPY:
+            memcpy(state->dst, state->src, state->size);
+            break;
+        case OP_CTR:
+            skinny128_ctr_encrypt
+                (state->dst, state->src, state->size, &ctr);
+            break;
+        case OP_ECB:
+            skinny128_parallel_ecb_encrypt
+                (state->dst, state->src, state->size, &ecb);
+            break;
+        }
+        bytes += state->size;
+        elapsed = get_timestamp() - start;
+    } while (elapsed < RUN_TIME);
+    state->bytes_per_sec = bytes * 1000000000.0 / elapsed;
+
+    skinny128_parallel_ecb_cleanup(&ecb);
+    skinny128_ctr_cleanup(&ctr);
+    return 0;
+}
+
+/* Runs an operation on several threads and returns the aggregate GiB/s */
+static double run_op(ThreadState *states, unsigned num_threads, int op)
+{
+    double total = 0;
+    unsigned index;
+    for (index = 0; index < num_threads; ++index) {
+        states[index].op = op;
+        states[index].bytes_per_sec = 0;
+        if (pthread_create(&(states[index].thread), 0, run_thread,
+                           &(states[index])) != 0) {
+            /* Run the operation inline if we cannot start a thread */
+            run_thread(&(states[index]));
+            states[index].thread = pthread_self();
+        }
+    }
+    for (index = 0; index < num_threads; ++index) {
+        if (!pthread_equal(states[index].thread, pthread_self()))
+            pthread_join(states[index].thread, 0);
+        total += states[index].bytes_per_sec;
+    }
+    return total / (1024.0 * 1024.0 * 1024.0);
+}
+
+static void run_working_set(size_t size, unsigned max_threads)
+{
+    ThreadState *states;
+    double results[NUM_OPS];
+    unsigned num_threads, index;
+    int op;
+
+    /* Allocate the buffers for all threads up front */
+    states = calloc(max_threads, sizeof(ThreadState));
+    if (!states)
+        return;
+    for (index = 0; index < max_threads; ++index) {
+        states[index].size = size;
+        states[index].src = malloc(size);
+        states[index].dst = malloc(size);
+        if (!states[index].src || !states[index].dst) {
+            max_threads = index;
+            free(states[index].src);
+            free(states[index].dst);
+            break;
+        }
+        memset(states[index].src, 0xBA, size);
+        memset(states[index].dst, 0, size);
+    }
+
+    printf("\nWorking set: %lu KiB per buffer\n",
+           (unsigned long)(size / 1024));
+    printf("Threads   memcpy (GiB/s)  CTR (GiB/s)  ECB (GiB/s)  "
+           "CTR/thread  ECB/thread\n");
+    for (num_threads = 1; num_threads <= max_threads; ) {
+        for (op = 0; op < NUM_OPS; ++op)
+            results[op] = run_op(states, num_threads, op);
+        printf("%7u %16.3f %12.3f %12.3f %11.3f %11.3f\n", num_threads,
+               results[OP_MEMCPY], results[OP_CTR], results[OP_ECB],
+               results[OP_CTR] / num_threads,
+               results[OP_ECB] / num_threads);
+        fflush(stdout);
+
+        /* Double the thread count each time, and finish on max_threads */
+        if (num_threads == max_threads)
+            break;
+        num_threads *= 2;
+        if (num_threads > max_threads)
+            num_threads = max_threads;
+    }
+
+    for (index = 0; index < max_threads; ++index) {
+        free(states[index].src);
+        free(states[index].dst);
+    }
+    free(states);
+}
+
+int main(int argc, char *argv[])
+{
+    long max_threads = 0;
+    unsigned index;
+
+    if (argc > 1)
+        max_threads = atol(argv[1]);
+#if defined(_SC_NPROCESSORS_ONLN)
+    if (max_threads <= 0)
+        max_threads = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    if (max_threads <= 0)
+        max_threads = 1;
+
+    printf("Skinny-128-256 scaling with up to %ld threads\n", max_threads);
+    for (index = 0; index < NUM_WORKING_SETS; ++index)
+        run_working_set(working_sets[index], (unsigned)max_threads);
+    return 0;
+}
+
+#else /* !HAVE_THREADS */
+
+int main(int argc, char *argv[])
+{
+    fprintf(stderr, "Do not know how to create threads - "
+                    "scaling tests skipped\n");
+    return 0;
+}
+
+#endif /* !HAVE_THREADS */
@@ -26,7 +26,13 @@
 #include "skinny64-parallel.h"
 #include "mantis-cipher.h"
 #include "mantis-parallel.h"
+#include "skinny128-hctr.h"
+#include "skinny128-kdf.h"
+#include "skinny128-keyhandle.h"
+#include "skinny128-queue.h"
+#include "skinny-autotune.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 typedef struct
@@ -150,6 +156,16 @@ static MantisTestVector const testMantis8 = {
 
 static int error = 0;
 
+/* Reads a 64-bit value in little-endian byte order */
+static uint64_t readLE64(const uint8_t *buf)
+{
+    uint64_t value = 0;
+    unsigned posn;
+    for (posn = 8; posn > 0; --posn)
+        value = (value << 8) | buf[posn - 1];
+    return value;
+}
+
 static void skinny64EcbTest(const SkinnyTestVector *test)
 {
     Skinny64Key_t ks;
@@ -271,7 +287,8 @@ static void skinny64ParallelEcbTest(const SkinnyTestVector *test)
     uint8_t plaintext[SKINNY64_BLOCK_SIZE * 128];
     uint8_t ciphertext[SKINNY64_BLOCK_SIZE * 128];
     uint8_t rplaintext[SKINNY64_BLOCK_SIZE * 128];
-    int plaintext_ok, ciphertext_ok;
+    uint64_t ids[127];
+    int plaintext_ok, ciphertext_ok, blocks_ok;
     unsigned index;
 
     printf("%s Parallel ECB: ", test->name);
@@ -296,7 +313,29 @@ static void skinny64ParallelEcbTest(const SkinnyTestVector *test)
 
     ciphertext_ok = memcmp(rplaintext, ciphertext, sizeof(ciphertext)) == 0;
 
-    if (plaintext_ok && ciphertext_ok) {
+    /* Check the stateless multi-block API in-place on an odd block count */
+    memcpy(rplaintext, plaintext, sizeof(plaintext));
+    skinny64_ecb_encrypt_blocks(rplaintext, rplaintext, 127, &ks);
+    blocks_ok = memcmp(rplaintext, ciphertext, 127 * SKINNY64_BLOCK_SIZE) == 0;
+    skinny64_ecb_decrypt_blocks(rplaintext, rplaintext, 127, &ks);
+    blocks_ok = blocks_ok &&
+        memcmp(rplaintext, plaintext, 127 * SKINNY64_BLOCK_SIZE) == 0;
+
+    /* Check the 64-bit ID API against the little-endian block encoding */
+    for (index = 0; index < 127; ++index)
+        ids[index] = readLE64(plaintext + index * SKINNY64_BLOCK_SIZE);
+    skinny64_ecb_encrypt_ids(ids, ids, 127, &ks);
+    for (index = 0; index < 127; ++index) {
+        if (ids[index] != readLE64(ciphertext + index * SKINNY64_BLOCK_SIZE))
+            blocks_ok = 0;
+    }
+    skinny64_ecb_decrypt_ids(ids, ids, 127, &ks);
+    for (index = 0; index < 127; ++index) {
+        if (ids[index] != readLE64(plaintext + index * SKINNY64_BLOCK_SIZE))
+            blocks_ok = 0;
+    }
+
+    if (plaintext_ok && ciphertext_ok && blocks_ok) {
         printf("ok");
     } else {
         error = 1;
@@ -308,6 +347,10 @@ static void skinny64ParallelEcbTest(const SkinnyTestVector *test)
             printf(", ciphertext ok");
         else
             printf(", ciphertext INCORRECT");
+        if (blocks_ok)
+            printf(", blocks ok");
+        else
+            printf(", blocks INCORRECT");
     }
     printf("\n");
 }
@@ -432,7 +475,7 @@ static void skinny128ParallelEcbTest(const SkinnyTestVector *test)
     uint8_t plaintext[SKINNY128_BLOCK_SIZE * 128];
     uint8_t ciphertext[SKINNY128_BLOCK_SIZE * 128];
     uint8_t rplaintext[SKINNY128_BLOCK_SIZE * 128];
-    int plaintext_ok, ciphertext_ok;
+    int plaintext_ok, ciphertext_ok, blocks_ok;
     unsigned index;
 
     printf("%s Parallel ECB: ", test->name);
@@ -457,7 +500,15 @@ static void skinny128ParallelEcbTest(const SkinnyTestVector *test)
 
     ciphertext_ok = memcmp(rplaintext, ciphertext, sizeof(ciphertext)) == 0;
 
-    if (plaintext_ok && ciphertext_ok) {
+    /* Check the stateless multi-block API in-place on an odd block count */
+    memcpy(rplaintext, plaintext, sizeof(plaintext));
+    skinny128_ecb_encrypt_blocks(rplaintext, rplaintext, 127, &ks);
+    blocks_ok = memcmp(rplaintext, ciphertext, 127 * SKINNY128_BLOCK_SIZE) == 0;
+    skinny128_ecb_decrypt_blocks(rplaintext, rplaintext, 127, &ks);
+    blocks_ok = blocks_ok &&
+        memcmp(rplaintext, plaintext, 127 * SKINNY128_BLOCK_SIZE) == 0;
+
+    if (plaintext_ok && ciphertext_ok && blocks_ok) {
         printf("ok");
     } else {
         error = 1;
@@ -469,6 +520,10 @@ static void skinny128ParallelEcbTest(const SkinnyTestVector *test)
             printf(", ciphertext ok");
         else
             printf(", ciphertext INCORRECT");
+        if (blocks_ok)
+            printf(", blocks ok");
+        else
+            printf(", blocks INCORRECT");
     }
     printf("\n");
 }
@@ -476,6 +531,8 @@ static void skinny128ParallelEcbTest(const SkinnyTestVector *test)
 static void mantisEcbTest(const MantisTestVector *test)
 {
     MantisKey_t ks;
+    MantisPreparedTweak_t pt;
+    uint8_t blocks[MANTIS_BLOCK_SIZE * 2];
     uint8_t plaintext1[MANTIS_BLOCK_SIZE];
     uint8_t ciphertext1[MANTIS_BLOCK_SIZE];
     uint8_t plaintext2[MANTIS_BLOCK_SIZE];
@@ -533,6 +590,26 @@ static void mantisEcbTest(const MantisTestVector *test)
         memcmp(ciphertext1, test->ciphertext, MANTIS_BLOCK_SIZE) == 0 &&
         memcmp(ciphertext2, test->ciphertext, MANTIS_BLOCK_SIZE) == 0;
 
+    /* And again with prepared tweaks, for several blocks at once */
+    memcpy(blocks, test->plaintext, MANTIS_BLOCK_SIZE);
+    memcpy(blocks + MANTIS_BLOCK_SIZE, test->plaintext, MANTIS_BLOCK_SIZE);
+    mantis_set_key(&ks, test->key, MANTIS_KEY_SIZE,
+                   test->rounds, MANTIS_ENCRYPT);
+    mantis_prepare_tweak(&pt, &ks, test->tweak, MANTIS_TWEAK_SIZE);
+    mantis_ecb_crypt_prepared(blocks, blocks, 2, &pt);
+    ciphertext_ok &=
+        memcmp(blocks, test->ciphertext, MANTIS_BLOCK_SIZE) == 0 &&
+        memcmp(blocks + MANTIS_BLOCK_SIZE, test->ciphertext,
+               MANTIS_BLOCK_SIZE) == 0;
+    mantis_swap_modes(&ks);
+    mantis_set_tweak(&ks, test->tweak, MANTIS_TWEAK_SIZE);
+    mantis_prepare_tweak(&pt, &ks, 0, MANTIS_TWEAK_SIZE);
+    mantis_ecb_crypt_prepared(blocks, blocks, 2, &pt);
+    plaintext_ok &=
+        memcmp(blocks, test->plaintext, MANTIS_BLOCK_SIZE) == 0 &&
+        memcmp(blocks + MANTIS_BLOCK_SIZE, test->plaintext,
+               MANTIS_BLOCK_SIZE) == 0;
+
     /* Report the results */
     if (plaintext_ok && ciphertext_ok) {
         printf("ok");
@@ -640,7 +717,9 @@ static void mantisParallelEcbTest(const MantisTestVector *test)
     uint8_t ciphertext[MANTIS_BLOCK_SIZE * 128];
     uint8_t rplaintext[MANTIS_BLOCK_SIZE * 128];
     uint8_t tweak[MANTIS_BLOCK_SIZE * 128];
-    int plaintext_ok, ciphertext_ok;
+    uint64_t ids[127];
+    uint64_t tweaks[127];
+    int plaintext_ok, ciphertext_ok, blocks_ok;
     unsigned index;
 
     printf("%s Parallel ECB: ", test->name);
@@ -672,7 +751,38 @@ static void mantisParallelEcbTest(const MantisTestVector *test)
 
     ciphertext_ok = memcmp(rplaintext, ciphertext, sizeof(ciphertext)) == 0;
 
-    if (plaintext_ok && ciphertext_ok) {
+    /* Check the stateless multi-block API in-place on an odd block count */
+    memcpy(rplaintext, plaintext, sizeof(plaintext));
+    mantis_ecb_crypt_blocks(rplaintext, rplaintext, tweak, 127, &ks);
+    blocks_ok = memcmp(rplaintext, ciphertext, 127 * MANTIS_BLOCK_SIZE) == 0;
+    mantis_swap_modes(&ks);
+    mantis_ecb_crypt_blocks(rplaintext, rplaintext, tweak, 127, &ks);
+    blocks_ok = blocks_ok &&
+        memcmp(rplaintext, plaintext, 127 * MANTIS_BLOCK_SIZE) == 0;
+
+    /* Check the 64-bit ID API against the little-endian block encoding */
+    mantis_swap_modes(&ks);
+    for (index = 0; index < 127; ++index) {
+        ids[index] = readLE64(plaintext + index * MANTIS_BLOCK_SIZE);
+        tweaks[index] = readLE64(tweak + index * MANTIS_BLOCK_SIZE);
+    }
+    mantis_ecb_crypt_ids(ids, ids, tweaks, 127, &ks);
+    for (index = 0; index < 127; ++index) {
+        if (ids[index] != readLE64(ciphertext + index * MANTIS_BLOCK_SIZE))
+            blocks_ok = 0;
+    }
+
+    /* Without a tweak array, the tweak in the key schedule is used */
+    mantis_set_tweak(&ks, tweak, MANTIS_TWEAK_SIZE);
+    mantis_ecb_crypt_ids(ids, ids, 0, 127, &ks);
+    for (index = 0; index < 127; ++index) {
+        mantis_ecb_crypt(rplaintext, ciphertext + index * MANTIS_BLOCK_SIZE,
+                         &ks);
+        if (ids[index] != readLE64(rplaintext))
+            blocks_ok = 0;
+    }
+
+    if (plaintext_ok && ciphertext_ok && blocks_ok) {
         printf("ok");
     } else {
         error = 1;
@@ -684,10 +794,481 @@ static void mantisParallelEcbTest(const MantisTestVector *test)
             printf(", ciphertext ok");
         else
             printf(", ciphertext INCORRECT");
+        if (blocks_ok)
+            printf(", blocks ok");
+        else
+            printf(", blocks INCORRECT");
     }
     printf("\n");
 }
 
+/* Known answer for the first page of the HCTR test below */
+static uint8_t const hctrKnownAnswer[48] = {
+    0xf1, 0x07, 0x54, 0x03, 0xab, 0x97, 0xb6, 0xda,
+    0xa7, 0x03, 0x8a, 0x75, 0x57, 0x05, 0x3d, 0x83,
+    0x77, 0x9a, 0x20, 0x2b, 0xc2, 0x7d, 0x1d, 0xdf,
+    0x8c, 0xe4, 0x36, 0xaf, 0x41, 0x4e, 0x45, 0xa9,
+    0xf9, 0x4a, 0x80, 0x9e, 0xc3, 0x26, 0x2d, 0x03,
+    0x64, 0x92, 0x30, 0x35, 0x9b, 0x58, 0xa3, 0x14
+};
+
+static void skinny128HctrTest(void)
+{
+    static unsigned const page_sizes[] = {16, 17, 48, 100, 4096};
+    static uint8_t plaintext[4096 * 3];
+    static uint8_t ciphertext[4096 * 3];
+    static uint8_t actual[4096 * 3];
+    uint8_t key[32];
+    uint8_t tweaks[3][SKINNY128_HCTR_TWEAK_SIZE];
+    Skinny128HCTR_t hctr;
+    unsigned index, page, size;
+    int ok = 1;
+
+    printf("Skinny-128 HCTR: ");
+    fflush(stdout);
+
+    for (index = 0; index < sizeof(key); ++index)
+        key[index] = (uint8_t)index;
+    for (index = 0; index < sizeof(plaintext); ++index)
+        plaintext[index] = (uint8_t)(index % 251);
+    for (index = 0; index < sizeof(tweaks); ++index)
+        tweaks[index / SKINNY128_HCTR_TWEAK_SIZE]
+              [index % SKINNY128_HCTR_TWEAK_SIZE] = (uint8_t)(index * 7);
+
+    skinny128_hctr_init(&hctr);
+    skinny128_hctr_set_key(&hctr, key, sizeof(key));
+
+    /* Check the output against a known answer */
+    skinny128_hctr_encrypt(ciphertext, plaintext, 48, tweaks, 1, &hctr);
+    if (memcmp(ciphertext, hctrKnownAnswer, 48) != 0)
+        ok = 0;
+
+    for (index = 0; index < sizeof(page_sizes) / sizeof(page_sizes[0]);
+            ++index) {
+        size = page_sizes[index];
+
+        /* Encrypt three pages in one call and decrypt them in-place */
+        skinny128_hctr_encrypt
+            (ciphertext, plaintext, size, tweaks, 3, &hctr);
+        memcpy(actual, ciphertext, size * 3);
+        skinny128_hctr_decrypt(actual, actual, size, tweaks, 3, &hctr);
+        if (memcmp(actual, plaintext, size * 3) != 0)
+            ok = 0;
+
+        /* Encrypting the pages one at a time should give the same result */
+        for (page = 0; page < 3; ++page) {
+            skinny128_hctr_encrypt
+                (actual + page * size, plaintext + page * size,
+                 size, tweaks[page], 1, &hctr);
+        }
+        if (memcmp(actual, ciphertext, size * 3) != 0)
+            ok = 0;
+
+        /* Changing the last byte of the plaintext or the tweak should
+           change the first block of the ciphertext */
+        memcpy(actual, plaintext, size);
+        actual[size - 1] ^= 0x01;
+        skinny128_hctr_encrypt(actual, actual, size, tweaks, 1, &hctr);
+        if (!memcmp(actual, ciphertext, SKINNY128_BLOCK_SIZE))
+            ok = 0;
+        skinny128_hctr_encrypt(actual, plaintext, size, tweaks[1], 1, &hctr);
+        if (!memcmp(actual, ciphertext, SKINNY128_BLOCK_SIZE))
+            ok = 0;
+    }
+
+    skinny128_hctr_cleanup(&hctr);
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("INCORRECT\n");
+        error = 1;
+    }
+}
+
+static void skinny128KdfTest(void)
+{
+    static uint8_t labels[130][SKINNY128_KDF_LABEL_SIZE];
+    static uint8_t subkeys[130][SKINNY128_KDF_MAX_SUBKEY_SIZE];
+    static uint8_t actual[130 * SKINNY128_KDF_MAX_SUBKEY_SIZE];
+    static Skinny128Key_t schedules[130];
+    uint8_t key[32];
+    uint8_t tk[SKINNY128_KDF_TWEAKEY_SIZE];
+    uint8_t block[2][SKINNY128_BLOCK_SIZE];
+    Skinny128KDF_t kdf;
+    Skinny128Key_t ks;
+    unsigned index, posn, size;
+    int ok = 1;
+
+    printf("Skinny-128 KDF: ");
+    fflush(stdout);
+
+    for (index = 0; index < sizeof(key); ++index)
+        key[index] = (uint8_t)(index * 3);
+    for (index = 0; index < 130; ++index) {
+        memset(labels[index], 0, SKINNY128_KDF_LABEL_SIZE);
+        labels[index][0] = (uint8_t)index;
+        labels[index][15] = (uint8_t)(index >> 8);
+    }
+
+    /* Derive subkeys in bulk with various sizes and compare them with
+       subkeys that are derived one block at a time */
+    if (!skinny128_kdf_set_key(&kdf, key, sizeof(key)))
+        ok = 0;
+    memset(tk, 0, sizeof(tk));
+    memcpy(tk, key, sizeof(key));
+    tk[33] = (uint8_t)sizeof(key);
+    for (size = 1; size <= SKINNY128_KDF_MAX_SUBKEY_SIZE; size += 5) {
+        tk[34] = (uint8_t)size;
+        for (posn = 0; posn < 3; ++posn) {
+            tk[32] = (uint8_t)(posn + 1);
+            skinny128_set_key(&ks, tk, sizeof(tk));
+            for (index = 0; index < 130; ++index) {
+                skinny128_ecb_encrypt
+                    (subkeys[index] + posn * SKINNY128_BLOCK_SIZE,
+                     labels[index], &ks);
+            }
+        }
+        memset(actual, 0xAA, sizeof(actual));
+        if (!skinny128_kdf_derive(actual, size, labels, 130, &kdf))
+            ok = 0;
+        for (index = 0; index < 130; ++index) {
+            if (memcmp(actual + index * size, subkeys[index], size) != 0)
+                ok = 0;
+        }
+    }
+    if (skinny128_kdf_derive(actual, 49, labels, 130, &kdf))
+        ok = 0;
+    if (skinny128_kdf_derive(0, 16, labels, 130, &kdf))
+        ok = 0;
+    if (skinny128_kdf_derive(actual, 16, 0, 130, &kdf))
+        ok = 0;
+    if (skinny128_kdf_derive_keys(schedules, 32, 0, 130, &kdf))
+        ok = 0;
+
+    /* A shorter subkey must not be a prefix of a longer one */
+    skinny128_kdf_derive(block[0], 16, labels, 1, &kdf);
+    skinny128_kdf_derive(subkeys[0], 32, labels, 1, &kdf);
+    if (memcmp(block[0], subkeys[0], SKINNY128_BLOCK_SIZE) == 0)
+        ok = 0;
+
+    /* Derive the key schedules in bulk and check them */
+    if (!skinny128_kdf_derive(actual, 32, labels, 130, &kdf))
+        ok = 0;
+    if (!skinny128_kdf_derive_keys(schedules, 32, labels, 130, &kdf))
+        ok = 0;
+    for (index = 0; index < 130; ++index) {
+        skinny128_set_key(&ks, actual + index * 32, 32);
+        skinny128_ecb_encrypt(block[0], labels[index], &ks);
+        skinny128_ecb_encrypt(block[1], labels[index], &(schedules[index]));
+        if (memcmp(block[0], block[1], SKINNY128_BLOCK_SIZE) != 0)
+            ok = 0;
+    }
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("INCORRECT\n");
+        error = 1;
+    }
+}
+
+static void skinny128KeyHandleTest(void)
+{
+    static uint8_t plaintext[100];
+    static uint8_t expected[100];
+    static uint8_t actual[100];
+    uint8_t key[2][32];
+    uint8_t counter[SKINNY128_BLOCK_SIZE];
+    uint8_t counter2[SKINNY128_BLOCK_SIZE];
+    Skinny128KeyHandle_t handle;
+    const Skinny128Key_t *ks;
+    Skinny128Key_t ks2;
+    Skinny128CTR_t ctr;
+    unsigned index, posn, token;
+    int ok = 1;
+
+    printf("Skinny-128 key handle: ");
+    fflush(stdout);
+
+    for (index = 0; index < sizeof(key[0]); ++index) {
+        key[0][index] = (uint8_t)(index * 5);
+        key[1][index] = (uint8_t)(index * 7 + 1);
+    }
+    for (index = 0; index < sizeof(plaintext); ++index)
+        plaintext[index] = (uint8_t)(index * 11);
+
+    if (!skinny128_key_handle_init(&handle, key[0], sizeof(key[0]))) {
+        printf("INCORRECT\n");
+        error = 1;
+        return;
+    }
+    for (posn = 0; posn < 2; ++posn) {
+        /* The handle should be using the most recent key */
+        if (posn > 0 &&
+                !skinny128_key_handle_rotate(&handle, key[posn], 32))
+            ok = 0;
+        skinny128_set_key(&ks2, key[posn], 32);
+
+        /* Check ECB mode against the plain block cipher */
+        for (index = 0; index < 96; index += SKINNY128_BLOCK_SIZE)
+            skinny128_ecb_encrypt(expected + index, plaintext + index, &ks2);
+        if (!skinny128_key_handle_ecb_encrypt(actual, plaintext, 96, &handle))
+            ok = 0;
+        if (memcmp(actual, expected, 96) != 0)
+            ok = 0;
+        if (!skinny128_key_handle_ecb_decrypt(actual, actual, 96, &handle))
+            ok = 0;
+        if (memcmp(actual, plaintext, 96) != 0)
+            ok = 0;
+        if (skinny128_key_handle_ecb_encrypt(actual, plaintext, 17, &handle))
+            ok = 0;
+
+        /* Check CTR mode against a regular CTR context */
+        memset(counter, 0, sizeof(counter));
+        counter[15] = 0xFE;
+        memcpy(counter2, counter, sizeof(counter));
+        skinny128_ctr_init(&ctr);
+        skinny128_ctr_set_key(&ctr, key[posn], 32);
+        skinny128_ctr_set_counter(&ctr, counter, sizeof(counter));
+        skinny128_ctr_encrypt(expected, plaintext, sizeof(plaintext), &ctr);
+        skinny128_ctr_cleanup(&ctr);
+        if (!skinny128_key_handle_ctr_encrypt
+                (actual, plaintext, sizeof(plaintext), counter, &handle))
+            ok = 0;
+        if (memcmp(actual, expected, sizeof(plaintext)) != 0)
+            ok = 0;
+        counter2[14] = 0x01;
+        counter2[15] = 0x05;
+        if (memcmp(counter, counter2, sizeof(counter)) != 0)
+            ok = 0;
+
+        /* Check the key schedule that readers see directly */
+        ks = skinny128_key_handle_acquire(&handle, &token);
+        skinny128_ecb_encrypt(actual, plaintext, ks);
+        skinny128_key_handle_release(&handle, token);
+        skinny128_ecb_encrypt(expected, plaintext, &ks2);
+        if (memcmp(actual, expected, SKINNY128_BLOCK_SIZE) != 0)
+            ok = 0;
+    }
+    skinny128_key_handle_cleanup(&handle);
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("INCORRECT\n");
+        error = 1;
+    }
+}
+
+static uint8_t queueCalled[101];
+
+static void skinny128QueueCallback(Skinny128Job_t *job)
+{
+    *((uint8_t *)(job->user_data)) = 1;
+}
+
+/* Callback for a job that is released by the callback itself */
+static void skinny128QueueFreeCallback(Skinny128Job_t *job)
+{
+    *((uint8_t *)(job->user_data)) = 1;
+    memset(job, 0, sizeof(Skinny128Job_t));
+    free(job);
+}
+
+static void skinny128QueueTest(void)
+{
+    static uint8_t plaintext[100][SKINNY128_BLOCK_SIZE * 80];
+    static uint8_t actual[100][SKINNY128_BLOCK_SIZE * 80];
+    static Skinny128Job_t jobs[100];
+    uint8_t expected[SKINNY128_BLOCK_SIZE];
+    uint8_t key[3][16];
+    Skinny128Key_t ks[3];
+    Skinny128Queue_t queue;
+    Skinny128Job_t *job;
+    unsigned index, posn;
+    size_t size;
+    int ok = 1;
+
+    printf("Skinny-128 job queue: ");
+    fflush(stdout);
+
+    for (index = 0; index < 3; ++index) {
+        memset(key[index], (int)(index * 0x35 + 1), sizeof(key[index]));
+        skinny128_set_key(&(ks[index]), key[index], sizeof(key[index]));
+    }
+    for (index = 0; index < 100; ++index) {
+        for (posn = 0; posn < sizeof(plaintext[index]); ++posn)
+            plaintext[index][posn] = (uint8_t)(index + posn * 3);
+    }
+
+    if (!skinny128_queue_init(&queue, 2, 200)) {
+        printf("INCORRECT\n");
+        error = 1;
+        return;
+    }
+
+    /* Submit a mix of small and large jobs with different keys */
+    memset(queueCalled, 0, sizeof(queueCalled));
+    memset(actual, 0, sizeof(actual));
+    for (index = 0; index < 100; ++index) {
+        memset(&(jobs[index]), 0, sizeof(Skinny128Job_t));
+        size = (index % 10 == 9) ? 80 : (index % 3 + 1);
+        jobs[index].output = actual[index];
+        jobs[index].input = plaintext[index];
+        jobs[index].size = size * SKINNY128_BLOCK_SIZE;
+        jobs[index].ks = &(ks[index % 3]);
+        jobs[index].direction = (index & 4) ? SKINNY128_JOB_DECRYPT
+                                            : SKINNY128_JOB_ENCRYPT;
+        if (index & 1) {
+            jobs[index].callback = skinny128QueueCallback;
+            jobs[index].user_data = &(queueCalled[index]);
+        }
+        if (!skinny128_queue_submit(&queue, &(jobs[index])))
+            ok = 0;
+    }
+
+    /* Check each job against the plain block cipher */
+    for (index = 0; index < 100; ++index) {
+        skinny128_queue_wait(&queue, &(jobs[index]));
+        if (!skinny128_queue_poll(&queue, &(jobs[index])))
+            ok = 0;
+        for (posn = 0; posn < jobs[index].size;
+                posn += SKINNY128_BLOCK_SIZE) {
+            if (jobs[index].direction == SKINNY128_JOB_DECRYPT) {
+                skinny128_ecb_decrypt
+                    (expected, plaintext[index] + posn, jobs[index].ks);
+            } else {
+                skinny128_ecb_encrypt
+                    (expected, plaintext[index] + posn, jobs[index].ks);
+            }
+            if (memcmp(actual[index] + posn, expected,
+                       SKINNY128_BLOCK_SIZE) != 0)
+                ok = 0;
+        }
+    }
+    /* Badly-sized jobs should be rejected */
+    jobs[0].size = 17;
+    if (skinny128_queue_submit(&queue, &(jobs[0])))
+        ok = 0;
+
+    /* Jobs that are still pending at cleanup should be processed */
+    jobs[1].output = actual[1];
+    jobs[1].size = SKINNY128_BLOCK_SIZE;
+    jobs[1].callback = 0;
+    memset(actual[1], 0, SKINNY128_BLOCK_SIZE);
+    skinny128_queue_submit(&queue, &(jobs[1]));
+
+    /* A callback should be able to free its own job */
+    if ((job = calloc(1, sizeof(Skinny128Job_t))) != NULL) {
+        job->output = actual[2];
+        job->input = plaintext[2];
+        job->size = SKINNY128_BLOCK_SIZE;
+        job->ks = &(ks[0]);
+        job->callback = skinny128QueueFreeCallback;
+        job->user_data = &(queueCalled[100]);
+        if (!skinny128_queue_submit(&queue, job))
+            ok = 0;
+    }
+    skinny128_queue_cleanup(&queue);
+    if (!jobs[1].done)
+        ok = 0;
+
+    /* The workers have been joined, so all callbacks have finished */
+    for (index = 0; index < 100; ++index) {
+        if (queueCalled[index] != (index & 1))
+            ok = 0;
+    }
+    if (job && !queueCalled[100])
+        ok = 0;
+    skinny128_ecb_encrypt(expected, plaintext[1], jobs[1].ks);
+    if (jobs[1].direction == SKINNY128_JOB_DECRYPT ||
+            memcmp(actual[1], expected, SKINNY128_BLOCK_SIZE) != 0)
+        ok = 0;
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("INCORRECT\n");
+        error = 1;
+    }
+}
+
+/* Reads the contents of a small file into a NUL-terminated buffer */
+static int readSmallFile(const char *filename, char *buf, size_t size)
+{
+    FILE *file = fopen(filename, "r");
+    size_t len;
+    if (!file)
+        return 0;
+    len = fread(buf, 1, size - 1, file);
+    fclose(file);
+    buf[len] = '\0';
+    return len > 0 && len < (size - 1);
+}
+
+/* Writes a string to a small file */
+static int writeSmallFile(const char *filename, const char *str)
+{
+    FILE *file = fopen(filename, "w");
+    int ok;
+    if (!file)
+        return 0;
+    ok = fputs(str, file) >= 0;
+    if (fclose(file) != 0)
+        ok = 0;
+    return ok;
+}
+
+/* Tunes the back ends and checks that the cache file is read back.
+   The autotuner always writes the results in a fixed order, so we
+   reverse the order of the results in the file and check that the
+   second run leaves the file alone rather than measuring again */
+static void autotuneTest(void)
+{
+    static char const cache_file[] = "test-autotune.cache";
+    char contents[1024];
+    char reversed[1024];
+    char *lines[16];
+    unsigned count = 0;
+    char *line;
+    int ok;
+
+    printf("Autotune: ");
+    fflush(stdout);
+
+    remove(cache_file);
+    ok = skinny_autotune(cache_file);
+    ok = ok && readSmallFile(cache_file, contents, sizeof(contents));
+    if (ok) {
+        /* Split the file into lines; the first is the CPU identifier */
+        for (line = strtok(contents, "\n"); line && count < 16;
+                line = strtok(0, "\n"))
+            lines[count++] = line;
+        ok = count > 2;
+    }
+    if (ok) {
+        strcpy(reversed, lines[0]);
+        strcat(reversed, "\n");
+        while (count > 1) {
+            strcat(reversed, lines[--count]);
+            strcat(reversed, "\n");
+        }
+        ok = writeSmallFile(cache_file, reversed);
+    }
+    ok = ok && skinny_autotune(cache_file);
+    ok = ok && readSmallFile(cache_file, contents, sizeof(contents));
+    ok = ok && strcmp(contents, reversed) == 0;
+    remove(cache_file);
+
+    if (ok) {
+        printf("ok\n");
+    } else {
+        printf("INCORRECT\n");
+        error = 1;
+    }
+}
+
 /* Define to 1 to include the sbox generator */
 #define GEN_SBOX 0
 
@@ -736,6 +1317,24 @@ int main(int argc, char **argv)
     mantisParallelEcbTest(&testMantis7);
     mantisParallelEcbTest(&testMantis8);
 
+    skinny128HctrTest();
+    skinny128KdfTest();
+    skinny128KeyHandleTest();
+    skinny128QueueTest();
+
+    /* Run the bulk tests again with the back ends that the tuner chose */
+    autotuneTest();
+    skinny64CtrTest(&testVector64_128);
+    skinny64ParallelEcbTest(&testVector64_128);
+    skinny128CtrTest(&testVector128_256);
+    skinny128ParallelEcbTest(&testVector128_256);
+    skinny128HctrTest();
+    skinny128KdfTest();
+    skinny128KeyHandleTest();
+    skinny128QueueTest();
+    mantisCtrTest(&testMantis7);
+    mantisParallelEcbTest(&testMantis7);
+
 #if GEN_SBOX
     generate_sboxes();
 #endif